@@ -0,0 +1,133 @@
+/**
+ * Chunk streaming benchmark
+ *
+ * Encodes a square of generated chunks the way the server streams them to a joining client, applies the messages to
+ * a second world and checks that every block arrived. Then edits sections with a growing number of blocks and
+ * compares the size of a delta record with resending the section, which is the choice the streamer makes per section
+ * and tick.
+ *
+ * usage: chunk_stream_bench [radius in chunks] [seed]
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../src/world/world.h"
+#include "../src/net/chunk_protocol.h"
+
+using namespace std;
+
+static double seconds(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static bool sameBlocks(const Chunk& a, const Chunk& b) {
+  for (int i = 0; i < CHUNK_SECTIONS; i++) {
+    const BlockID* blocksA = a.sections[i].blocks();
+    const BlockID* blocksB = b.sections[i].blocks();
+    for (int j = 0; j < SECTION_VOLUME; j++) {
+      if (blocksA[j] != blocksB[j]) {
+        return false;
+      }
+    }
+    if (a.sections[i].nonAirCount() != b.sections[i].nonAirCount()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  int radius = argc > 1 ? atoi(argv[1]) : 8;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1337;
+
+  try {
+    World server(seed);
+    World client(seed);
+    Codec* codec = Codec::create(CODEC_ZSTD, CODEC_LEVEL_FAST, vector<uint8_t>());
+
+    vector<ChunkSnapshot> snapshots;
+    for (int x = -radius; x < radius; x++) {
+      for (int z = -radius; z < radius; z++) {
+        snapshots.push_back(server.loadChunk({ x, z })->snapshot());
+      }
+    }
+
+    ChunkBatchWriter writer(codec);
+    vector<vector<uint8_t>> messages;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < snapshots.size(); i++) {
+      writer.chunk(snapshots[i]);
+    }
+    writer.finish(messages);
+    double encodeTime = seconds(start);
+
+    ChunkUpdates updates;
+    bool ok = true;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < messages.size(); i++) {
+      ok &= applyChunkBatch(messages[i].data(), messages[i].size(), *codec, client, updates);
+    }
+    double decodeTime = seconds(start);
+
+    for (size_t i = 0; i < snapshots.size(); i++) {
+      const Chunk* received = client.getChunk(snapshots[i].pos);
+      ok &= received && sameBlocks(*server.getChunk(snapshots[i].pos), *received);
+    }
+
+    double rawBlocks = snapshots.size() * (double)CHUNK_SECTIONS * SECTION_VOLUME * sizeof(BlockID);
+    printf("%zu chunks in %zu messages: %.1f KB as block arrays, %.1f KB palette records, %.1f KB on the wire\n",
+      snapshots.size(), messages.size(), rawBlocks / 1e3, writer.rawBytes / 1e3, writer.messageBytes / 1e3);
+    printf("%.0f bytes per chunk, encode %.1f MB/s, decode %.1f MB/s (of palette records)%s\n\n",
+      (double)writer.messageBytes / snapshots.size(), writer.rawBytes / 1e6 / encodeTime, writer.rawBytes / 1e6 / decodeTime,
+      ok ? "" : "  ROUNDTRIP FAILED");
+
+    // Edit the lowest section of the spawn chunk, a random mix of stone and air
+    printf("%8s %14s %16s %10s\n", "edits", "delta bytes", "section bytes", "sent as");
+    const int counts[] = { 1, 4, 16, 64, 256, 1024, SECTION_VOLUME };
+    uint32_t random = seed;
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+      Chunk* chunk = server.getChunk({ 0, 0 });
+      vector<BlockDelta> deltas;
+      for (int i = 0; i < counts[c]; i++) {
+        random = random * 1664525 + 1013904223;
+        int index = counts[c] == SECTION_VOLUME ? i : (int)((random >> 8) % SECTION_VOLUME);
+        BlockID id = (random >> 4) & 1 ? BLOCK_STONE : BLOCK_AIR;
+        chunk->sections[0].setBlock(index & SECTION_MASK, index >> (2 * SECTION_SHIFT), (index >> SECTION_SHIFT) & SECTION_MASK, id);
+        deltas.push_back({ (uint16_t)index, id });
+      }
+
+      vector<uint8_t> deltaRecord, sectionRecord;
+      ByteWriter deltaWriter(deltaRecord), sectionWriter(sectionRecord);
+      ChunkBatchWriter::writeDeltas(deltaWriter, chunk->pos, 0, deltas.data(), deltas.size());
+      ChunkBatchWriter::writeSection(sectionWriter, chunk->pos, 0, *chunk->sections[0].share());
+      bool resend = sectionRecord.size() < deltaRecord.size();
+
+      writer.records(resend ? sectionRecord.data() : deltaRecord.data(), resend ? sectionRecord.size() : deltaRecord.size());
+      messages.clear();
+      writer.finish(messages);
+      for (size_t i = 0; i < messages.size(); i++) {
+        ok &= applyChunkBatch(messages[i].data(), messages[i].size(), *codec, client, updates);
+      }
+      ok &= sameBlocks(*chunk, *client.getChunk({ 0, 0 }));
+
+      printf("%8d %14zu %16zu %10s%s\n", counts[c], deltaRecord.size(), sectionRecord.size(), resend ? "section" : "deltas",
+        ok ? "" : "  MISMATCH");
+    }
+
+    delete codec;
+    if (!ok) {
+      return EXIT_FAILURE;
+    }
+  }
+  catch (string& e) {
+    fprintf(stderr, "%s\n", e.c_str());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,117 @@
+/**
+ * Chunk codec benchmark
+ *
+ * Generates a square of chunks, serializes them with the palette encoding used on disk and reports compression and
+ * decompression throughput (relative to the serialized size) and ratio for every codec configuration.
+ *
+ * usage: codec_bench [radius in chunks] [seed]
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+#include "../src/world/world.h"
+#include "../src/world/storage/chunk_serializer.h"
+#include "../src/world/storage/codec.h"
+
+using namespace std;
+
+struct Config {
+  const char* name;
+  CodecID id;
+  int level;
+};
+
+static const Config configs[] = {
+  { "none",            CODEC_NONE,      0 },
+  { "zstd -5 (fast)",  CODEC_ZSTD,      CODEC_LEVEL_FAST },
+  { "zstd 1",          CODEC_ZSTD,      1 },
+  { "zstd 3",          CODEC_ZSTD,      CODEC_LEVEL_DEFAULT },
+  { "zstd 19",         CODEC_ZSTD,      CODEC_LEVEL_ARCHIVE },
+  { "zstd+dict -5",    CODEC_ZSTD_DICT, CODEC_LEVEL_FAST },
+  { "zstd+dict 3",     CODEC_ZSTD_DICT, CODEC_LEVEL_DEFAULT },
+  { "zstd+dict 19",    CODEC_ZSTD_DICT, CODEC_LEVEL_ARCHIVE },
+};
+
+static double seconds(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static void generate(unsigned int seed, int radius, vector<vector<uint8_t>>& payloads) {
+  World world(seed);
+
+  for (int x = -radius; x < radius; x++) {
+    for (int z = -radius; z < radius; z++) {
+      payloads.push_back(vector<uint8_t>());
+      ChunkSerializer::serialize(world.loadChunk({ x, z })->snapshot(), payloads.back());
+      world.unloadChunk({ x, z });
+    }
+  }
+}
+
+int main(int argc, char* argv[]) {
+  int radius = argc > 1 ? atoi(argv[1]) : 16;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1337;
+
+  try {
+    vector<vector<uint8_t>> payloads;
+    generate(seed, radius, payloads);
+
+    // Train on a different world so the dictionary results aren't measured on their own training data
+    vector<vector<uint8_t>> training;
+    generate(seed + 1, radius / 2 > 4 ? radius / 2 : 4, training);
+    vector<uint8_t> dictionary = Codec::trainDictionary(training);
+
+    size_t rawBytes = 0;
+    for (size_t i = 0; i < payloads.size(); i++) {
+      rawBytes += payloads[i].size();
+    }
+
+    printf("%zu chunks, %.2f MB palette encoded (%.2f MB as raw block arrays), dictionary %zu bytes\n\n",
+      payloads.size(), rawBytes / 1e6, payloads.size() * (double)CHUNK_SECTIONS * SECTION_VOLUME * sizeof(BlockID) / 1e6, dictionary.size());
+    printf("%-16s %12s %14s %14s %10s\n", "codec", "size (MB)", "compress MB/s", "decompress MB/s", "ratio");
+
+    for (size_t c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+      Codec* codec = Codec::create(configs[c].id, configs[c].level, dictionary);
+      if (!codec) {
+        printf("%-16s unavailable\n", configs[c].name);
+        continue;
+      }
+
+      vector<vector<uint8_t>> compressed(payloads.size());
+      auto start = chrono::steady_clock::now();
+      for (size_t i = 0; i < payloads.size(); i++) {
+        codec->compress(payloads[i].data(), payloads[i].size(), compressed[i]);
+      }
+      double compressTime = seconds(start);
+
+      size_t compressedBytes = 0;
+      for (size_t i = 0; i < compressed.size(); i++) {
+        compressedBytes += compressed[i].size();
+      }
+
+      vector<uint8_t> decompressed;
+      bool ok = true;
+      start = chrono::steady_clock::now();
+      for (size_t i = 0; i < compressed.size(); i++) {
+        ok &= codec->decompress(compressed[i].data(), compressed[i].size(), decompressed);
+        ok &= decompressed == payloads[i];
+      }
+      double decompressTime = seconds(start);
+
+      printf("%-16s %12.3f %14.1f %14.1f %10.2f%s\n", configs[c].name, compressedBytes / 1e6,
+        rawBytes / 1e6 / compressTime, rawBytes / 1e6 / decompressTime, (double)rawBytes / compressedBytes,
+        ok ? "" : "  ROUNDTRIP FAILED");
+
+      delete codec;
+    }
+  }
+  catch (string& e) {
+    fprintf(stderr, "%s\n", e.c_str());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
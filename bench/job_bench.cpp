@@ -0,0 +1,106 @@
+/**
+ * Job system benchmark
+ *
+ * Generates the same square of chunks once on the calling thread and once through World::loadChunks() on job systems
+ * of increasing size, and checks that both produce the same blocks. A second run submits many tiny jobs from inside
+ * jobs (a recursive split with waits in between) to show the overhead per job and how much of it is stolen. The
+ * utilisation is the workers' share of the split run, the calling thread's help is shown on its own as the share of
+ * the job time it ran.
+ *
+ * usage: job_bench [radius] [max workers]
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "../src/world/world.h"
+#include "../src/jobs/job_system.h"
+
+using namespace std;
+
+#define SPLIT_LEAF 64
+
+static double seconds(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Sums [begin, end) by splitting it in halves, one half as a job and the other on the current thread
+static uint64_t split(JobSystem& jobs, uint64_t begin, uint64_t end) {
+  if (end - begin <= SPLIT_LEAF) {
+    uint64_t sum = 0;
+    for (uint64_t i = begin; i < end; i++) {
+      sum += i;
+    }
+    return sum;
+  }
+
+  uint64_t middle = begin + (end - begin) / 2;
+  uint64_t left = 0;
+  JobHandle job = jobs.submit([&jobs, &left, begin, middle]() { left = split(jobs, begin, middle); }, JOB_NORMAL);
+  uint64_t right = split(jobs, middle, end);
+  jobs.wait(job);
+  return left + right;
+}
+
+int main(int argc, char* argv[]) {
+  int radius = argc > 1 ? atoi(argv[1]) : 12;
+  int maxWorkers = argc > 2 ? atoi(argv[2]) : (int)thread::hardware_concurrency();
+  bool ok = true;
+
+  vector<ChunkPos> positions;
+  for (int x = -radius; x <= radius; x++) {
+    for (int z = -radius; z <= radius; z++) {
+      positions.push_back({ x, z });
+    }
+  }
+
+  printf("%zu chunks, %u hardware threads\n\n", positions.size(), thread::hardware_concurrency());
+
+  World reference(1337);
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  for (size_t i = 0; i < positions.size(); i++) {
+    reference.loadChunk(positions[i]);
+  }
+  double serial = seconds(start);
+
+  printf("%8s %12s %9s %12s %9s %12s %8s\n", "workers", "chunks/s", "speedup", "split M/s", "steals", "utilisation", "helped");
+  printf("%8s %12.0f %9s\n", "serial", positions.size() / serial, "1.0x");
+
+  for (int workers = 1; workers <= max(maxWorkers, 1); workers *= 2) {
+    JobSystem jobs(workers);
+
+    World world(1337);
+    start = chrono::steady_clock::now();
+    world.loadChunks(positions, jobs);
+    double parallel = seconds(start);
+
+    for (size_t i = 0; i < positions.size() && ok; i++) {
+      const Chunk* a = world.getChunk(positions[i]);
+      const Chunk* b = reference.getChunk(positions[i]);
+      for (int y = 0; y < CHUNK_HEIGHT && ok; y++) {
+        for (int x = 0; x < SECTION_SIZE; x++) {
+          for (int z = 0; z < SECTION_SIZE; z++) {
+            ok = ok && a && a->getBlock(x, y, z) == b->getBlock(x, y, z);
+          }
+        }
+      }
+    }
+
+    uint64_t count = 1 << 22;
+    jobs.takeStats();
+    start = chrono::steady_clock::now();
+    ok = ok && split(jobs, 0, count) == count * (count - 1) / 2;
+    double splitTime = seconds(start);
+    JobStats stats = jobs.takeStats();
+
+    double helped = stats.busy + stats.helped > 0.0 ? stats.helped / (stats.busy + stats.helped) : 0.0;
+    printf("%8d %12.0f %8.1fx %12.1f %9llu %11.0f%% %7.0f%%\n", workers, positions.size() / parallel, serial / parallel,
+      stats.jobs / splitTime / 1e6, (unsigned long long)stats.steals, stats.utilisation() * 100.0, helped * 100.0);
+  }
+
+  printf("\n%s\n", ok ? "parallel generation matches" : "ERROR: parallel generation differs");
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,157 @@
+/**
+ * Network loop benchmark
+ *
+ * Runs an echo server on its own NetLoop and thread and many clients over loopback, all sharing a second NetLoop on
+ * the main thread. Every client sends its messages in bursts of 'burst', waits for all echoes and checks their
+ * contents. Reports message throughput,
+ * round trips per second and how many messages shared one sendmsg() call thanks to batching.
+ *
+ * usage: net_bench [clients] [messages per client] [message size] [burst]
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/net/net_loop.h"
+
+using namespace std;
+
+static double seconds(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Sends every message straight back
+class EchoServer : public NetHandler {
+public:
+  NetLoop& loop;
+  size_t connected;
+
+  EchoServer(NetLoop& loop) : loop(loop), connected(0) {}
+
+  void onConnect(ConnectionId id) { connected++; }
+  void onDisconnect(ConnectionId id) { connected--; }
+  void onMessage(ConnectionId id, const uint8_t* data, size_t size) { loop.send(id, data, size); }
+};
+
+// Message 'n' of a client is filled with bytes derived from the client and n, so echoes can be verified
+static void fillMessage(vector<uint8_t>& message, size_t client, uint32_t n) {
+  for (size_t i = 0; i < message.size(); i++) {
+    message[i] = (uint8_t)(client * 31 + n * 7 + i);
+  }
+}
+
+class Clients : public NetHandler {
+public:
+  NetLoop& loop;
+  size_t messageSize;
+  uint32_t messages;
+  uint32_t burst;
+
+  vector<ConnectionId> ids;
+  // Per client: messages sent and echoes received
+  vector<uint32_t> sent;
+  vector<uint32_t> received;
+  size_t connected;
+  size_t finished;
+  size_t errors;
+  vector<uint8_t> message;
+
+  Clients(NetLoop& loop, size_t messageSize, uint32_t messages, uint32_t burst) :
+    loop(loop), messageSize(messageSize), messages(messages), burst(burst), connected(0), finished(0), errors(0),
+    message(messageSize) {}
+
+  size_t index(ConnectionId id) {
+    // Ids are handed out in order starting at 1
+    return id - ids[0];
+  }
+
+  void sendBurst(size_t client) {
+    for (uint32_t i = 0; i < burst && sent[client] < messages; i++) {
+      fillMessage(message, client, sent[client]);
+      loop.send(ids[client], message.data(), message.size());
+      sent[client]++;
+    }
+  }
+
+  void onConnect(ConnectionId id) {
+    connected++;
+    sendBurst(index(id));
+  }
+
+  void onDisconnect(ConnectionId id) {
+    errors++;
+  }
+
+  void onMessage(ConnectionId id, const uint8_t* data, size_t size) {
+    size_t client = index(id);
+    fillMessage(message, client, received[client]);
+    if (size != messageSize || memcmp(data, message.data(), size) != 0) {
+      errors++;
+    }
+
+    received[client]++;
+    if (received[client] == messages) {
+      finished++;
+    }
+    else if (received[client] == sent[client]) {
+      sendBurst(client);
+    }
+  }
+};
+
+int main(int argc, char* argv[]) {
+  size_t clientCount = argc > 1 ? (size_t)atoi(argv[1]) : 500;
+  uint32_t messages = argc > 2 ? (uint32_t)atoi(argv[2]) : 2000;
+  size_t messageSize = argc > 3 ? (size_t)atoi(argv[3]) : 32;
+  uint32_t burst = argc > 4 ? (uint32_t)atoi(argv[4]) : 16;
+
+  try {
+    NetLoop serverLoop;
+    serverLoop.listen(0, "127.0.0.1");
+    EchoServer server(serverLoop);
+
+    atomic<bool> done(false);
+    thread serverThread([&]() {
+      while (!done.load()) {
+        serverLoop.poll(10, server);
+      }
+    });
+
+    NetLoop clientLoop;
+    Clients clients(clientLoop, messageSize, messages, burst);
+    for (size_t i = 0; i < clientCount; i++) {
+      clients.ids.push_back(clientLoop.connect("127.0.0.1", serverLoop.listenPort()));
+    }
+    clients.sent.assign(clientCount, 0);
+    clients.received.assign(clientCount, 0);
+
+    auto start = chrono::steady_clock::now();
+    while (clients.finished + clients.errors < clientCount && seconds(start) < 60.0) {
+      clientLoop.poll(10, clients);
+    }
+    double time = seconds(start);
+
+    done.store(true);
+    serverThread.join();
+
+    const NetStats& serverStats = serverLoop.getStats();
+    uint64_t total = (uint64_t)clientCount * messages;
+    printf("%zu clients, %u messages of %zu bytes each, bursts of %u\n", clientCount, messages, messageSize, burst);
+    printf("%.2f s, %.0f round trips/s, %.1f MB/s each way\n", time, total / time, total * (messageSize + 4) / time / 1e6);
+    printf("server: %llu messages in %llu sendmsg calls (%.1f per call)\n", (unsigned long long)serverStats.messagesSent,
+      (unsigned long long)serverStats.sendCalls, (double)serverStats.messagesSent / (serverStats.sendCalls ? serverStats.sendCalls : 1));
+    printf("%zu of %zu clients finished, %zu errors\n", clients.finished, clientCount, clients.errors);
+
+    return clients.finished == clientCount && clients.errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+  catch (string& e) {
+    fprintf(stderr, "%s\n", e.c_str());
+    return EXIT_FAILURE;
+  }
+}
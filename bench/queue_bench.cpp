@@ -0,0 +1,224 @@
+/**
+ * Queue benchmark
+ *
+ * Moves messages between threads through the lock-free queues and through a std::mutex + std::deque baseline. The
+ * SPSC run has one producer and one consumer passing integers. The MPSC runs pass preallocated nodes from several
+ * producers to one consumer; the baseline consumer swaps out the whole deque under the lock, so both sides drain in
+ * batches and only the cost of the synchronization differs. Every run checks that each producer's messages arrive
+ * complete and in order.
+ *
+ * usage: queue_bench [messages] [max producers]
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../src/util/spsc_queue.h"
+#include "../src/util/mpsc_queue.h"
+
+using namespace std;
+
+#define SPSC_CAPACITY 1024
+
+struct Message : MpscNode {
+  uint32_t producer;
+  uint64_t sequence;
+};
+
+static double seconds(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static double spscLockFree(uint64_t count, bool& ok) {
+  SpscQueue<uint64_t> queue(SPSC_CAPACITY);
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  thread producer([&queue, count]() {
+    for (uint64_t i = 0; i < count; i++) {
+      while (!queue.push(i)) {
+        this_thread::yield();
+      }
+    }
+  });
+
+  uint64_t expected = 0;
+  while (expected < count) {
+    uint64_t value;
+    if (!queue.pop(value)) {
+      this_thread::yield();
+      continue;
+    }
+    ok = ok && value == expected;
+    expected++;
+  }
+
+  producer.join();
+  return seconds(start);
+}
+
+static double spscMutex(uint64_t count, bool& ok) {
+  mutex lock;
+  deque<uint64_t> queue;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  thread producer([&lock, &queue, count]() {
+    for (uint64_t i = 0; i < count; i++) {
+      // Bounded like the ring buffer, so the producer can't just run ahead
+      for (;;) {
+        {
+          lock_guard<mutex> guard(lock);
+          if (queue.size() < SPSC_CAPACITY) {
+            queue.push_back(i);
+            break;
+          }
+        }
+        this_thread::yield();
+      }
+    }
+  });
+
+  uint64_t expected = 0;
+  while (expected < count) {
+    uint64_t value;
+    {
+      lock_guard<mutex> guard(lock);
+      if (queue.empty()) {
+        value = count;
+      }
+      else {
+        value = queue.front();
+        queue.pop_front();
+      }
+    }
+    if (value == count) {
+      this_thread::yield();
+      continue;
+    }
+    ok = ok && value == expected;
+    expected++;
+  }
+
+  producer.join();
+  return seconds(start);
+}
+
+static double mpscLockFree(vector<Message>& messages, int producers, double& batch, bool& ok) {
+  MpscQueue<Message> queue;
+  size_t perProducer = messages.size() / producers;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  vector<thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.push_back(thread([&queue, &messages, p, perProducer]() {
+      for (size_t i = 0; i < perProducer; i++) {
+        queue.push(&messages[p * perProducer + i]);
+      }
+    }));
+  }
+
+  vector<uint64_t> next(producers, 0);
+  size_t received = 0;
+  size_t batches = 0;
+  while (received < perProducer * producers) {
+    Message* message = queue.popAll();
+    if (!message) {
+      this_thread::yield();
+      continue;
+    }
+
+    batches++;
+    for (; message; message = MpscQueue<Message>::next(message)) {
+      ok = ok && message->sequence == next[message->producer]++;
+      received++;
+    }
+  }
+
+  for (size_t i = 0; i < threads.size(); i++) {
+    threads[i].join();
+  }
+  batch = (double)received / batches;
+  return seconds(start);
+}
+
+static double mpscMutex(vector<Message>& messages, int producers, double& batch, bool& ok) {
+  mutex lock;
+  deque<Message*> queue;
+  size_t perProducer = messages.size() / producers;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  vector<thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.push_back(thread([&lock, &queue, &messages, p, perProducer]() {
+      for (size_t i = 0; i < perProducer; i++) {
+        lock_guard<mutex> guard(lock);
+        queue.push_back(&messages[p * perProducer + i]);
+      }
+    }));
+  }
+
+  vector<uint64_t> next(producers, 0);
+  deque<Message*> taken;
+  size_t received = 0;
+  size_t batches = 0;
+  while (received < perProducer * producers) {
+    {
+      lock_guard<mutex> guard(lock);
+      taken.swap(queue);
+    }
+    if (taken.empty()) {
+      this_thread::yield();
+      continue;
+    }
+
+    batches++;
+    for (size_t i = 0; i < taken.size(); i++) {
+      ok = ok && taken[i]->sequence == next[taken[i]->producer]++;
+      received++;
+    }
+    taken.clear();
+  }
+
+  for (size_t i = 0; i < threads.size(); i++) {
+    threads[i].join();
+  }
+  batch = (double)received / batches;
+  return seconds(start);
+}
+
+int main(int argc, char* argv[]) {
+  uint64_t count = argc > 1 ? strtoull(argv[1], NULL, 10) : 10000000;
+  int maxProducers = argc > 2 ? atoi(argv[2]) : 8;
+  bool ok = true;
+
+  printf("%llu messages, %u hardware threads\n\n", (unsigned long long)count, thread::hardware_concurrency());
+
+  double lockFree = spscLockFree(count, ok);
+  double locked = spscMutex(count, ok);
+  printf("SPSC %9s %16s %16s %9s\n", "", "lock-free M/s", "mutex M/s", "speedup");
+  printf("     %9s %16.1f %16.1f %8.1fx\n\n", "", count / lockFree / 1e6, count / locked / 1e6, locked / lockFree);
+
+  printf("MPSC %9s %16s %16s %9s %12s %12s\n", "producers", "lock-free M/s", "mutex M/s", "speedup", "batch", "mutex batch");
+  for (int producers = 1; producers <= maxProducers; producers *= 2) {
+    vector<Message> messages(count - count % producers);
+    size_t perProducer = messages.size() / producers;
+    for (size_t i = 0; i < messages.size(); i++) {
+      messages[i].producer = (uint32_t)(i / perProducer);
+      messages[i].sequence = i % perProducer;
+    }
+
+    double batch;
+    double mutexBatch;
+    lockFree = mpscLockFree(messages, producers, batch, ok);
+    locked = mpscMutex(messages, producers, mutexBatch, ok);
+    printf("     %9d %16.1f %16.1f %8.1fx %12.1f %12.1f\n", producers, messages.size() / lockFree / 1e6, messages.size() / locked / 1e6,
+      locked / lockFree, batch, mutexBatch);
+  }
+
+  printf("\n%s\n", ok ? "all messages arrived in order" : "ERROR: messages lost or reordered");
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,126 @@
+/**
+ * Entity snapshot benchmark
+ *
+ * Simulates wandering mobs on generated terrain and encodes a snapshot of all of them every tick: without a baseline,
+ * against the previous tick and against the snapshot 'lag' ticks back (a client whose acknowledgements take that
+ * long). Every delta is decoded again and checked against the snapshot it was made from. Reports bytes per entity
+ * and tick and the encode and decode rate.
+ *
+ * usage: snapshot_bench [mobs] [ticks] [lag]
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../src/entity/systems.h"
+#include "../src/net/entity_protocol.h"
+
+using namespace std;
+
+static double seconds(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static bool sameState(const EntityState& a, const EntityState& b) {
+  return a.entity == b.entity && a.position[0] == b.position[0] && a.position[1] == b.position[1] && a.position[2] == b.position[2]
+    && a.velocity[0] == b.velocity[0] && a.velocity[1] == b.velocity[1] && a.velocity[2] == b.velocity[2] && a.yaw == b.yaw;
+}
+
+int main(int argc, char* argv[]) {
+  int mobs = argc > 1 ? atoi(argv[1]) : 256;
+  int ticks = argc > 2 ? atoi(argv[2]) : 400;
+  uint32_t lag = argc > 3 ? (uint32_t)atoi(argv[3]) : 4;
+  if (lag < 1 || lag >= SNAPSHOT_HISTORY) {
+    fprintf(stderr, "lag must be between 1 and %d\n", SNAPSHOT_HISTORY - 1);
+    return EXIT_FAILURE;
+  }
+
+  try {
+    World world(1337);
+    for (int x = -4; x < 4; x++) {
+      for (int z = -4; z < 4; z++) {
+        world.loadChunk({ x, z });
+      }
+    }
+
+    Registry registry;
+    SpatialHash grid;
+    JobSystem jobs;
+    SystemScheduler scheduler(jobs);
+    registerSystems(scheduler, world, grid);
+    for (int i = 0; i < mobs; i++) {
+      int x = (i % 32) * 2 - 32;
+      int z = (i / 32) * 2 - 32;
+      spawnMob(registry, WorldPosition::fromBlock(x, world.generator.height(x, z) + 1, z, glm::vec3(0.5f, 0.0f, 0.5f)), 1 + i * 7919);
+    }
+
+    // The server's history, and the client's copy rebuilt from the previous tick deltas
+    SnapshotHistory sent;
+    SnapshotHistory received;
+    EntitySnapshot decoded;
+    vector<uint8_t> message;
+
+    const char* names[] = { "full", "previous tick", "lagged" };
+    uint64_t bytes[3] = { 0, 0, 0 };
+    double encodeTime[3] = { 0.0, 0.0, 0.0 };
+    double decodeTime = 0.0;
+    uint64_t entityTicks = 0;
+    bool ok = true;
+
+    for (uint32_t tick = 1; tick <= (uint32_t)ticks; tick++) {
+      scheduler.run(registry, 1.0f / 20);
+
+      EntitySnapshot& snapshot = sent.add(tick);
+      registry.each<PhysicsBody, Appearance>([&snapshot](Entity entity, PhysicsBody& body, Appearance& appearance) {
+        snapshot.entities.push_back(quantizeEntity(entity, body, appearance));
+      });
+      sort(snapshot.entities.begin(), snapshot.entities.end(), [](const EntityState& a, const EntityState& b) {
+        return a.entity.index < b.entity.index;
+      });
+      entityTicks += snapshot.entities.size();
+
+      const EntitySnapshot* baselines[3] = { NULL, sent.find(tick - 1), tick > lag ? sent.find(tick - lag) : NULL };
+      for (int b = 0; b < 3; b++) {
+        message.clear();
+        auto start = chrono::steady_clock::now();
+        encodeSnapshot(snapshot, baselines[b], message);
+        encodeTime[b] += seconds(start);
+        bytes[b] += message.size();
+
+        // The client follows the previous tick deltas
+        if (b == 1) {
+          start = chrono::steady_clock::now();
+          ok &= decodeSnapshot(message.data(), message.size(), received, decoded);
+          decodeTime += seconds(start);
+
+          ok &= decoded.entities.size() == snapshot.entities.size();
+          for (size_t i = 0; ok && i < decoded.entities.size(); i++) {
+            ok &= sameState(decoded.entities[i], snapshot.entities[i]);
+          }
+          received.add(tick).entities.swap(decoded.entities);
+        }
+      }
+    }
+
+    printf("%d mobs, %d ticks, lagged baseline %u ticks back%s\n\n", mobs, ticks, lag, ok ? "" : "  ROUNDTRIP FAILED");
+    printf("%-16s %16s %14s %12s\n", "baseline", "bytes per tick", "bits/entity", "encode M/s");
+    for (int b = 0; b < 3; b++) {
+      printf("%-16s %16.1f %14.1f %12.2f\n", names[b], (double)bytes[b] / ticks, bytes[b] * 8.0 / entityTicks, entityTicks / encodeTime[b] / 1e6);
+    }
+    printf("\ndecode %.2f M entities/s\n", entityTicks / decodeTime / 1e6);
+
+    if (!ok) {
+      return EXIT_FAILURE;
+    }
+  }
+  catch (string& e) {
+    fprintf(stderr, "%s\n", e.c_str());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+/**
+ * Spatial hash benchmark
+ *
+ * Scatters entities in a 256x32x256 block area and runs one radius query per entity, as a neighbour or collision
+ * pass would every tick. Compares the naive scan over all entities with the spatial hash (including the per tick
+ * incremental update) across entity counts. The naive scan is timed on a sample of queries and extrapolated.
+ *
+ * usage: spatial_bench [query radius] [seed]
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+#include "../src/physics/spatial_hash.h"
+
+using namespace std;
+
+static const size_t counts[] = { 1000, 4000, 16000, 64000 };
+
+// Number of queries the naive scan is timed on
+#define NAIVE_SAMPLE 1000
+
+static double seconds(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static float randomFloat() {
+  return rand() / (float)RAND_MAX;
+}
+
+int main(int argc, char* argv[]) {
+  float radius = argc > 1 ? (float)atof(argv[1]) : 4.0f;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1337;
+  srand(seed);
+
+  printf("radius %.1f, one query per entity\n\n", radius);
+  printf("%10s %14s %14s %14s %12s %10s\n", "entities", "naive ms", "update ms", "hash query ms", "avg found", "speedup");
+
+  for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+    size_t count = counts[c];
+
+    vector<Entity> entities(count);
+    vector<WorldPosition> positions(count);
+    for (size_t i = 0; i < count; i++) {
+      entities[i].index = (uint32_t)i + 1;
+      entities[i].generation = 1;
+      positions[i] = WorldPosition(0, 0, glm::vec3(randomFloat() * 256.0f, randomFloat() * 32.0f, randomFloat() * 256.0f));
+    }
+
+    SpatialHash grid;
+    for (size_t i = 0; i < count; i++) {
+      grid.update(entities[i], positions[i]);
+    }
+
+    // Move everything a little, like a tick of wandering entities would
+    for (size_t i = 0; i < count; i++) {
+      positions[i] = positions[i] + glm::vec3(randomFloat() - 0.5f, 0.0f, randomFloat() - 0.5f);
+    }
+
+    auto start = chrono::steady_clock::now();
+    grid.beginUpdate();
+    for (size_t i = 0; i < count; i++) {
+      grid.update(entities[i], positions[i]);
+    }
+    grid.endUpdate();
+    double updateTime = seconds(start);
+
+    size_t found = 0;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+      grid.forEachInRadius(positions[i], radius, [&found](Entity entity, const WorldPosition& position) {
+        found++;
+      });
+    }
+    double hashTime = seconds(start);
+
+    size_t sample = count < NAIVE_SAMPLE ? count : NAIVE_SAMPLE;
+    size_t naiveFound = 0;
+    size_t sampleFound = 0;
+    float radiusSquared = radius * radius;
+    start = chrono::steady_clock::now();
+    for (size_t q = 0; q < sample; q++) {
+      const WorldPosition& center = positions[q * (count / sample)];
+      for (size_t i = 0; i < count; i++) {
+        glm::vec3 d = positions[i] - center;
+        if (d.x * d.x + d.y * d.y + d.z * d.z <= radiusSquared) {
+          naiveFound++;
+        }
+      }
+    }
+    double naiveTime = seconds(start) * count / sample;
+
+    for (size_t q = 0; q < sample; q++) {
+      grid.forEachInRadius(positions[q * (count / sample)], radius, [&sampleFound](Entity entity, const WorldPosition& position) {
+        sampleFound++;
+      });
+    }
+
+    printf("%10zu %14.2f %14.2f %14.2f %12.1f %9.1fx%s\n", count, naiveTime * 1e3, updateTime * 1e3, hashTime * 1e3,
+      (double)found / count, naiveTime / (updateTime + hashTime), naiveFound == sampleFound ? "" : "  MISMATCH");
+  }
+
+  return EXIT_SUCCESS;
+}
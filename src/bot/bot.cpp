@@ -0,0 +1,287 @@
+#include <math.h>
+#include <chrono>
+
+#include "bot.h"
+
+using namespace std;
+
+// xorshift32, the bots only need cheap and reproducible choices
+static uint32_t nextRandom(uint32_t& state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+static int randomRange(uint32_t& state, int low, int high) {
+  return low + (int)(nextRandom(state) % (uint32_t)(high - low + 1));
+}
+
+BotSwarm::Bot::Bot(uint32_t number, uint32_t seed) {
+  this->number = number;
+  this->random = (seed ^ (number * 0x9E3779B9u)) | 1;
+  this->prediction = NULL;
+  this->waypoint = 0;
+  this->blocked = false;
+  this->nextInput = 0.0;
+  this->nextPing = 0.0;
+  this->nextEdit = 0.0;
+  this->pingSequence = 0;
+  this->restore = false;
+}
+
+BotSwarm::Bot::~Bot() {
+  delete prediction;
+}
+
+BotSwarm::BotSwarm(const BotConfig& config) : config(config) {
+  world = NULL;
+  start = now();
+  time = 0.0;
+
+  stats.connected = 0;
+  stats.dropped = 0;
+  stats.chunkBytes = 0;
+  stats.snapshotBytes = 0;
+  stats.stateBytes = 0;
+  stats.inputsSent = 0;
+  stats.edits = 0;
+  stats.snapshots = 0;
+  stats.snapshotErrors = 0;
+  stats.corrections = 0;
+  stats.replayedInputs = 0;
+}
+
+BotSwarm::~BotSwarm() {
+  for (auto& entry : bots) {
+    delete entry.second;
+  }
+  delete world;
+}
+
+double BotSwarm::now() const {
+  return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void BotSwarm::run(double seconds) {
+  start = now();
+  time = 0.0;
+
+  for (int i = 0; i < config.count; i++) {
+    ConnectionId id = net.connect(config.host.c_str(), config.port);
+    if (id == CONNECTION_NONE) {
+      stats.dropped++;
+      continue;
+    }
+    bots[id] = new Bot((uint32_t)i, config.seed);
+  }
+
+  while (time < seconds) {
+    for (auto& entry : bots) {
+      update(entry.first, *entry.second);
+    }
+    net.poll(BOT_POLL_INTERVAL, *this);
+    time = now() - start;
+  }
+}
+
+void BotSwarm::send(ConnectionId id) {
+  net.send(id, message.data(), message.size());
+}
+
+void BotSwarm::onConnect(ConnectionId id) {
+  stats.connected++;
+}
+
+void BotSwarm::onDisconnect(ConnectionId id) {
+  auto it = bots.find(id);
+  if (it != bots.end()) {
+    delete it->second;
+    bots.erase(it);
+    stats.dropped++;
+  }
+}
+
+void BotSwarm::onMessage(ConnectionId id, const uint8_t* data, size_t size) {
+  auto it = bots.find(id);
+  if (it == bots.end() || size == 0) {
+    return;
+  }
+  Bot& bot = *it->second;
+
+  if (data[0] == MSG_CHUNK_BATCH) {
+    stats.chunkBytes += size;
+  }
+  else if (data[0] == MSG_ENTITY_SNAPSHOT) {
+    stats.snapshots++;
+    stats.snapshotBytes += size;
+    if (!bot.remote.apply(data, size, bot.registry)) {
+      stats.snapshotErrors++;
+      return;
+    }
+    message.clear();
+    encodeSnapshotAck(bot.remote.lastTick(), message);
+    send(id);
+  }
+  else if (data[0] == MSG_PLAYER_STATE) {
+    stats.stateBytes += size;
+    if (!world) {
+      return;
+    }
+
+    uint32_t lastInput;
+    PhysicsBody body = bot.prediction ? bot.prediction->getBody() : createBody(WorldPosition(), PLAYER_WIDTH, PLAYER_HEIGHT, PLAYER_STEP_HEIGHT);
+    if (!decodePlayerState(data, size, lastInput, body)) {
+      return;
+    }
+
+    if (!bot.prediction) {
+      // The first state is where the server spawned the player, the patrol starts from there
+      loadAround(body.position);
+      bot.prediction = new PlayerPrediction(body);
+      plan(bot, body);
+      bot.nextInput = time;
+      bot.nextPing = time;
+      bot.nextEdit = time + config.editInterval * (nextRandom(bot.random) % 1000) / 1000.0;
+      return;
+    }
+
+    uint64_t replayed = bot.prediction->replayedInputs;
+    if (bot.prediction->reconcile(*world, lastInput, body)) {
+      stats.corrections++;
+      stats.replayedInputs += bot.prediction->replayedInputs - replayed;
+    }
+  }
+  else if (data[0] == MSG_WELCOME) {
+    unsigned int seed;
+    int tickRate;
+    if (decodeWelcome(data, size, seed, tickRate) && !world) {
+      world = new World(seed);
+    }
+  }
+  else if (data[0] == MSG_PING) {
+    uint32_t sequence;
+    uint64_t sent;
+    if (decodePing(data, size, sequence, sent)) {
+      message.clear();
+      encodePing(MSG_PONG, sequence, sent, message);
+      send(id);
+    }
+  }
+  else if (data[0] == MSG_PONG) {
+    uint32_t sequence;
+    uint64_t sent;
+    if (decodePing(data, size, sequence, sent)) {
+      stats.roundTrips.push_back((float)((now() - start) * 1e3 - (double)sent / 1e3));
+    }
+  }
+}
+
+void BotSwarm::plan(Bot& bot, const PhysicsBody& body) {
+  int64_t centerX = body.position.blockX() + randomRange(bot.random, -BOT_PATROL_SPREAD, BOT_PATROL_SPREAD);
+  int64_t centerZ = body.position.blockZ() + randomRange(bot.random, -BOT_PATROL_SPREAD, BOT_PATROL_SPREAD);
+  int half = randomRange(bot.random, BOT_PATROL_MIN, BOT_PATROL_MAX) / 2;
+
+  bot.waypoints[0] = WorldPosition::fromBlock(centerX - half, 0, centerZ - half, glm::vec3(0.5f));
+  bot.waypoints[1] = WorldPosition::fromBlock(centerX + half, 0, centerZ - half, glm::vec3(0.5f));
+  bot.waypoints[2] = WorldPosition::fromBlock(centerX + half, 0, centerZ + half, glm::vec3(0.5f));
+  bot.waypoints[3] = WorldPosition::fromBlock(centerX - half, 0, centerZ + half, glm::vec3(0.5f));
+  bot.waypoint = 0;
+}
+
+void BotSwarm::loadAround(const WorldPosition& position) {
+  // Same radius the server keeps loaded around players
+  ChunkPos center = position.chunk();
+  for (int x = -1; x <= 1; x++) {
+    for (int z = -1; z <= 1; z++) {
+      world->loadChunk({ center.x + x, center.z + z });
+    }
+  }
+}
+
+void BotSwarm::update(ConnectionId id, Bot& bot) {
+  if (!bot.prediction || !net.connected(id)) {
+    return;
+  }
+
+  // After a stall the bot skips the missed inputs instead of sending a burst the server would reject
+  if (time - bot.nextInput > 1.0) {
+    bot.nextInput = time;
+  }
+
+  inputs.clear();
+  while (bot.nextInput <= time && inputs.size() < PLAYER_INPUTS_PER_MESSAGE) {
+    const PhysicsBody& body = bot.prediction->getBody();
+    loadAround(body.position);
+
+    glm::vec3 offset = bot.waypoints[bot.waypoint] - body.position;
+    offset.y = 0.0f;
+    if (glm::dot(offset, offset) < 1.0f) {
+      bot.waypoint = (bot.waypoint + 1) % BOT_WAYPOINTS;
+      offset = bot.waypoints[bot.waypoint] - body.position;
+      offset.y = 0.0f;
+    }
+
+    PlayerInput input;
+    input.sequence = 0;
+    input.yaw = atan2f(-offset.x, -offset.z);
+    input.keys = KEY_FORWARD | (bot.blocked ? KEY_JUMP : 0);
+
+    WorldPosition before = body.position;
+    inputs.push_back(bot.prediction->predict(*world, input));
+
+    // Walking into a wall or up a step, jump over it
+    glm::vec3 moved = bot.prediction->getBody().position - before;
+    moved.y = 0.0f;
+    bot.blocked = glm::length(moved) < 0.5f * PLAYER_WALK_SPEED * PLAYER_INPUT_DT;
+    bot.nextInput += PLAYER_INPUT_DT;
+  }
+
+  if (!inputs.empty()) {
+    message.clear();
+    encodePlayerInputs(inputs.data(), inputs.size(), message);
+    send(id);
+    stats.inputsSent += inputs.size();
+  }
+
+  if (config.pingInterval > 0.0 && time >= bot.nextPing) {
+    message.clear();
+    encodePing(MSG_PING, ++bot.pingSequence, (uint64_t)((now() - start) * 1e6), message);
+    send(id);
+    bot.nextPing += config.pingInterval;
+  }
+
+  if (config.editInterval > 0.0 && time >= bot.nextEdit) {
+    edit(id, bot, bot.prediction->getBody());
+    bot.nextEdit += config.editInterval;
+  }
+}
+
+void BotSwarm::edit(ConnectionId id, Bot& bot, const PhysicsBody& body) {
+  BlockEdit edit;
+  if (bot.restore) {
+    edit = bot.broken;
+    bot.restore = false;
+  }
+  else {
+    // A block next to the one the player stands on, air and unloaded blocks are skipped until the next edit
+    edit.x = (int)body.position.blockX() + randomRange(bot.random, -BOT_EDIT_RANGE, BOT_EDIT_RANGE);
+    edit.y = (int)body.position.blockY() - 1;
+    edit.z = (int)body.position.blockZ() + randomRange(bot.random, -BOT_EDIT_RANGE, BOT_EDIT_RANGE);
+    edit.id = world->getBlock(edit.x, edit.y, edit.z);
+    if (edit.id == BLOCK_AIR) {
+      return;
+    }
+
+    bot.broken = edit;
+    bot.restore = true;
+    edit.id = BLOCK_AIR;
+  }
+
+  // Applied locally right away, like a client would
+  world->setBlock(edit.x, edit.y, edit.z, edit.id);
+  message.clear();
+  encodeBlockEdit(edit, message);
+  send(id);
+  stats.edits++;
+}
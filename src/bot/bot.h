@@ -0,0 +1,138 @@
+/* bot.h */
+
+#ifndef BOT_HEADER_H
+#define BOT_HEADER_H
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../world/world.h"
+#include "../ecs/registry.h"
+#include "../entity/player.h"
+#include "../net/net_loop.h"
+#include "../net/entity_protocol.h"
+#include "../net/session_protocol.h"
+
+// Corners of the square every bot patrols, and its side length in blocks
+#define BOT_WAYPOINTS 4
+#define BOT_PATROL_MIN 12
+#define BOT_PATROL_MAX 48
+// Blocks around the spawn point the patrols are centered in
+#define BOT_PATROL_SPREAD 32
+// Blocks from the player a bot edits at, well within the server's reach
+#define BOT_EDIT_RANGE 3
+// Milliseconds between polls, short enough to send every input close to when it is due
+#define BOT_POLL_INTERVAL 5
+
+struct BotConfig {
+  std::string host;
+  uint16_t port;
+  int count;
+  // Seconds between a bot's block edits and between its pings, 0 disables them
+  double editInterval;
+  double pingInterval;
+  // Seeds the patrols and edits, the same seed replays the same bot behavior
+  uint32_t seed;
+
+  BotConfig() : host("127.0.0.1"), port(25565), count(16), editInterval(2.0), pingInterval(1.0), seed(1) {}
+};
+
+// Everything the bots measured, summed over all bots
+struct BotStats {
+  uint64_t connected;
+  // Connections that failed or that the server closed
+  uint64_t dropped;
+  // Received message bytes by message type, the totals are in the NetStats
+  uint64_t chunkBytes;
+  uint64_t snapshotBytes;
+  uint64_t stateBytes;
+  uint64_t inputsSent;
+  uint64_t edits;
+  uint64_t snapshots;
+  // Snapshots that couldn't be decoded, a correct server never causes any
+  uint64_t snapshotErrors;
+  uint64_t corrections;
+  uint64_t replayedInputs;
+  // Ping round trips in milliseconds, in the order they arrived
+  std::vector<float> roundTrips;
+};
+
+// Headless clients for load testing: every bot is a TCP connection that behaves like a player. It walks a square
+// patrol with client side prediction, sending its inputs at the player input rate, mirrors the entity snapshots it
+// receives and acknowledges them, breaks and restores blocks near its player and measures round trips with pings.
+// All bots share one NetLoop and one locally generated world for their prediction; chunk batches are only counted,
+// not decoded, which keeps the bots' CPU cost down when they run next to the server. Edits of all bots are applied
+// to the shared world too, so their predictions see the same terrain as the server.
+class BotSwarm : public NetHandler {
+public:
+  // Constructor & destructor, the destructor closes all connections
+  BotSwarm(const BotConfig& config);
+  ~BotSwarm();
+
+  // Link conditions of the bots' connections (see NetLoop::setLink())
+  void setLink(const LinkConditions& outgoing, const LinkConditions& incoming) { net.setLink(outgoing, incoming); }
+
+  // Connects all bots, then runs them for 'seconds' of wall time
+  void run(double seconds);
+
+  // Network events
+  void onConnect(ConnectionId id);
+  void onMessage(ConnectionId id, const uint8_t* data, size_t size);
+  void onDisconnect(ConnectionId id);
+
+  const BotStats& getStats() const { return stats; }
+  const NetStats& getNetStats() const { return net.getStats(); }
+  size_t active() const { return bots.size(); }
+
+private:
+  struct Bot {
+    uint32_t number;
+    uint32_t random;
+    // Created with the first player state, inputs are only sent from then on
+    PlayerPrediction* prediction;
+    Registry registry;
+    RemoteEntities remote;
+
+    WorldPosition waypoints[BOT_WAYPOINTS];
+    int waypoint;
+    // The last input barely moved the player, the next one jumps
+    bool blocked;
+
+    // Seconds since the swarm started
+    double nextInput;
+    double nextPing;
+    double nextEdit;
+    uint32_t pingSequence;
+    // The last edit broke a block, the next one puts it back
+    bool restore;
+    BlockEdit broken;
+
+    Bot(uint32_t number, uint32_t seed);
+    ~Bot();
+  };
+
+  BotConfig config;
+  NetLoop net;
+  std::unordered_map<ConnectionId, Bot*> bots;
+  // Generated from the seed the server sends, NULL until the first welcome
+  World* world;
+  BotStats stats;
+  double start;
+  double time;
+
+  std::vector<PlayerInput> inputs;
+  std::vector<uint8_t> message;
+
+  double now() const;
+  void send(ConnectionId id);
+  // Sends the bot's due inputs, pings and edits
+  void update(ConnectionId id, Bot& bot);
+  void plan(Bot& bot, const PhysicsBody& body);
+  void edit(ConnectionId id, Bot& bot, const PhysicsBody& body);
+  // Keeps the chunks around the player loaded in the shared world
+  void loadAround(const WorldPosition& position);
+};
+
+#endif
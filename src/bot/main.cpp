@@ -0,0 +1,137 @@
+/**
+ * Load test
+ *
+ * Starts a server on a temporary world and connects N bots to it over loopback (see BotSwarm). The bots walk, edit
+ * blocks and ping for the given time, every connection going through an emulated link with the given latency,
+ * jitter, loss and bandwidth in each direction. Reports the server's tick time percentiles and overruns, the round
+ * trips the bots measured and the bandwidth each bot used.
+ *
+ * usage: loadtest [bots] [seconds] [latency ms] [jitter ms] [loss %] [bandwidth KB/s]
+**/
+
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "../server/server.h"
+#include "bot.h"
+
+using namespace std;
+
+static int removeEntry(const char* path, const struct stat* info, int type, struct FTW* ftw) {
+  return remove(path);
+}
+
+// Nearest rank percentile of sorted values
+static float percentile(const vector<float>& sorted, double p) {
+  if (sorted.empty()) {
+    return 0.0f;
+  }
+  size_t rank = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+  return sorted[min(rank, sorted.size() - 1)];
+}
+
+static void report(const char* name, vector<float>& values) {
+  sort(values.begin(), values.end());
+  cout << name << ": p50 " << percentile(values, 50.0) << " ms, p90 " << percentile(values, 90.0) << " ms, p99 "
+    << percentile(values, 99.0) << " ms, max " << (values.empty() ? 0.0f : values.back()) << " ms (" << values.size()
+    << " samples)" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+  int bots = argc > 1 ? atoi(argv[1]) : 16;
+  double seconds = argc > 2 ? atof(argv[2]) : 30.0;
+
+  // Every direction of every connection gets the same conditions, round trips see the latency twice
+  LinkConditions link;
+  link.latency = argc > 3 ? atof(argv[3]) : 0.0;
+  link.jitter = argc > 4 ? atof(argv[4]) : 0.0;
+  link.loss = argc > 5 ? atof(argv[5]) / 100.0 : 0.0;
+  link.bandwidth = argc > 6 ? atof(argv[6]) * 1024.0 : 0.0;
+
+  if (bots <= 0 || seconds <= 0.0) {
+    cerr << "usage: loadtest [bots] [seconds] [latency ms] [jitter ms] [loss %] [bandwidth KB/s]" << endl;
+    return EXIT_FAILURE;
+  }
+
+  char directory[] = "/tmp/loadtest-XXXXXX";
+  if (!mkdtemp(directory)) {
+    cerr << "Can't create a temporary world directory" << endl;
+    return EXIT_FAILURE;
+  }
+
+  try
+  {
+    ServerConfig config;
+    config.directory = string(directory) + "/world";
+    config.host = "127.0.0.1";
+    config.port = 0;
+    config.reportInterval = 0.0;
+    config.logClients = false;
+
+    cout << "Load test: " << bots << " bots for " << seconds << " s, latency " << link.latency << " ms, jitter " << link.jitter
+      << " ms, loss " << link.loss * 100.0 << " %, bandwidth " << (link.bandwidth > 0.0 ? to_string((int)(link.bandwidth / 1024.0)) + " KB/s" : "unlimited")
+      << endl;
+
+    vector<float> tickTimes;
+    BotStats stats;
+    NetStats net;
+    size_t remaining;
+    {
+      // The server emulates the link towards the bots and the bots the link towards the server, so each direction is
+      // held back once, on the side whose send buffer a slow link would fill up
+      Server server(config);
+      server.getNet().setLink(link, LinkConditions());
+      server.recordTickTimes(true);
+      thread serverThread([&server]() { server.run(); });
+
+      BotConfig botConfig;
+      botConfig.port = server.getNet().listenPort();
+      botConfig.count = bots;
+      BotSwarm swarm(botConfig);
+      swarm.setLink(link, LinkConditions());
+      swarm.run(seconds);
+
+      server.stop();
+      serverThread.join();
+      server.takeTickTimes(tickTimes);
+
+      stats = swarm.getStats();
+      net = swarm.getNetStats();
+      remaining = swarm.active();
+    }
+
+    uint64_t overruns = 0;
+    for (size_t i = 0; i < tickTimes.size(); i++) {
+      if (tickTimes[i] > 1000.0f / config.tickRate) {
+        overruns++;
+      }
+    }
+
+    cout << "Bots: " << stats.connected << " connected, " << remaining << " still connected at the end, " << stats.dropped << " dropped" << endl;
+    report("Server tick", tickTimes);
+    cout << "Ticks over the " << 1000.0f / config.tickRate << " ms budget: " << overruns << endl;
+    report("Round trip", stats.roundTrips);
+
+    double perBot = (double)max(bots, 1) * seconds * 1024.0;
+    cout << "Per bot: down " << net.bytesReceived / perBot << " KB/s (chunks " << stats.chunkBytes / perBot << ", snapshots "
+      << stats.snapshotBytes / perBot << ", player state " << stats.stateBytes / perBot << "), up " << net.bytesSent / perBot << " KB/s" << endl;
+    cout << "Inputs: " << stats.inputsSent << " sent, " << stats.corrections << " corrections replaying " << stats.replayedInputs << " inputs" << endl;
+    cout << "Snapshots: " << stats.snapshots << " received, " << stats.snapshotErrors << " undecodable; " << stats.edits << " block edits; "
+      << net.emulatedLosses << " emulated losses upstream" << endl;
+  }
+  catch (string& e)
+  {
+    cerr << e << endl;
+    nftw(directory, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    return EXIT_FAILURE;
+  }
+
+  nftw(directory, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+  return EXIT_SUCCESS;
+}
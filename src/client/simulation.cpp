@@ -0,0 +1,221 @@
+#include <chrono>
+
+#include "simulation.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+// The server behind the game: only reachable from this machine, quiet, and streaming one ring of chunks more than is
+// drawn
+static ServerConfig serverConfig() {
+  ServerConfig config;
+  config.directory = WORLD_DIRECTORY;
+  config.seed = WORLD_SEED;
+  config.host = "127.0.0.1";
+  config.port = 0;
+  config.viewDistance = VIEW_DISTANCE + 1;
+  config.reportInterval = 0.0;
+  config.logClients = false;
+  return config;
+}
+
+// Where the server spawns the player, the prediction starts from the same state
+static PhysicsBody spawnBody(const World& world) {
+  return createBody(WorldPosition::fromBlock(8, world.generator.height(8, 8) + 1, 8, glm::vec3(0.5f, 0.0f, 0.5f)), PLAYER_WIDTH, PLAYER_HEIGHT,
+    PLAYER_STEP_HEIGHT);
+}
+
+Simulation::Simulation(JobSystem& jobs, int width, int height) : jobs(jobs), server(serverConfig()), world(WORLD_SEED), terrain(world, jobs),
+  prediction(spawnBody(world)), camera(width, height, prediction.getBody().position), inputs(SIMULATION_INPUT_QUEUE), running(false), ticks(0),
+  overruns(0) {
+  codec = Codec::create(CODEC_ZSTD, CODEC_LEVEL_FAST, vector<uint8_t>());
+  camera.Follow(prediction.getBody());
+
+  // Completes once the server thread accepts it
+  connection = net.connect("127.0.0.1", server.getNet().listenPort());
+}
+
+Simulation::~Simulation() {
+  stop();
+  delete codec;
+}
+
+void Simulation::start() {
+  if (!running.exchange(true)) {
+    serverThread = std::thread([this]() { server.run(); });
+    thread = std::thread(&Simulation::run, this);
+  }
+}
+
+void Simulation::stop() {
+  running.store(false);
+  if (thread.joinable()) {
+    thread.join();
+  }
+
+  server.stop();
+  if (serverThread.joinable()) {
+    serverThread.join();
+  }
+}
+
+void Simulation::run() {
+  Clock::duration interval = chrono::duration_cast<Clock::duration>(chrono::duration<double>(1.0 / PLAYER_INPUT_RATE));
+  Clock::time_point next = Clock::now();
+
+  while (running.load()) {
+    tick();
+
+    // Like the server: catch up on overruns without waiting, but give up on ticks more than a second behind
+    next += interval;
+    Clock::time_point now = Clock::now();
+    if (now > next) {
+      overruns++;
+      if (now - next > chrono::seconds(1)) {
+        next = now;
+      }
+    }
+    this_thread::sleep_until(next);
+  }
+}
+
+void Simulation::onMessage(ConnectionId id, const uint8_t* data, size_t size) {
+  if (size == 0) {
+    return;
+  }
+
+  if (data[0] == MSG_CHUNK_BATCH) {
+    // Records before a corrupt one stay applied, so their updates count either way
+    chunkUpdates.clear();
+    applyChunkBatch(data, size, *codec, world, chunkUpdates);
+    applyChunkUpdates();
+  }
+  else if (data[0] == MSG_ENTITY_SNAPSHOT) {
+    if (!remote.apply(data, size, registry)) {
+      return;
+    }
+    message.clear();
+    encodeSnapshotAck(remote.lastTick(), message);
+    net.send(id, message.data(), message.size());
+  }
+  else if (data[0] == MSG_PLAYER_STATE) {
+    // Where the server has the player after the last input it applied, a prediction that went elsewhere is reset to
+    // it and the inputs sent since are replayed
+    uint32_t lastInput;
+    PhysicsBody body = prediction.getBody();
+    if (decodePlayerState(data, size, lastInput, body)) {
+      prediction.reconcile(world, lastInput, body);
+    }
+  }
+}
+
+void Simulation::onDisconnect(ConnectionId id) {
+  // Only happens when the server stops, the world stays as it was last seen
+  connection = CONNECTION_NONE;
+  remote.clear(registry);
+}
+
+void Simulation::applyChunkUpdates() {
+  for (size_t i = 0; i < chunkUpdates.chunks.size(); i++) {
+    terrain.chunkChanged(chunkUpdates.chunks[i]);
+  }
+  for (size_t i = 0; i < chunkUpdates.sections.size(); i++) {
+    terrain.sectionChanged(chunkUpdates.sections[i].first, chunkUpdates.sections[i].second);
+  }
+  for (size_t i = 0; i < chunkUpdates.blocks.size(); i++) {
+    const BlockChange& change = chunkUpdates.blocks[i];
+    terrain.blockChanged(change.x, change.y, change.z);
+  }
+  for (size_t i = 0; i < chunkUpdates.unloaded.size(); i++) {
+    terrain.removeChunk(chunkUpdates.unloaded[i]);
+  }
+}
+
+void Simulation::tick() {
+  terrain.beginTick(ticks + 1);
+
+  // Chunks and entities the server sent since the last tick
+  net.poll(0, *this);
+
+  // Apply the newest keys and facing, and every click since the last tick
+  bool breakBlock = false;
+  bool placeBlock = false;
+  FrameInput received;
+  while (inputs.pop(received)) {
+    input = received;
+    breakBlock = breakBlock || received.breakBlock;
+    placeBlock = placeBlock || received.placeBlock;
+  }
+  camera.orientation = input.orientation;
+
+  // The player stands still until the chunk it is in arrived, missing ground would let the prediction fall through it
+  if (connection != CONNECTION_NONE && world.getChunk(prediction.getBody().position.chunk())) {
+    PlayerInput predicted = prediction.predict(world, input.player);
+    message.clear();
+    encodePlayerInputs(&predicted, 1, message);
+    net.send(connection, message.data(), message.size());
+  }
+  camera.Follow(prediction.getBody());
+  camera.UpdateMatrix(CAMERA_FOV, CAMERA_NEAR, CAMERA_FAR);
+
+  // Mesh the chunks around the camera
+  ChunkPos cameraChunk = camera.position.chunk();
+  terrain.update(cameraChunk, VIEW_DISTANCE);
+  terrain.updateLod(cameraChunk, LOD_DISTANCE);
+
+  if (breakBlock) {
+    editBlock(false);
+  }
+  if (placeBlock) {
+    editBlock(true);
+  }
+
+  // Remesh the sections edited this tick so the change shows up in this tick's snapshot
+  terrain.rebuildDirty();
+
+  RenderSnapshot& snapshot = snapshots.write();
+  snapshot.tick = ++ticks;
+  snapshot.camera = camera.position;
+  snapshot.cameraMatrix = camera.matrix;
+  terrain.cull(camera.matrix, camera.position, snapshot);
+  EntityRenderer::collect(registry, camera.position, snapshot.entities);
+  snapshots.publish();
+
+  // The tick's input, edits and acknowledgement leave together
+  net.flush();
+}
+
+void Simulation::editBlock(bool place) {
+  // Breaking removes the targeted block, placing puts planks against the targeted face
+  RayHit target = camera.Pick(world, REACH_DISTANCE);
+  if (!target.hit) {
+    return;
+  }
+
+  glm::ivec3 block = target.block;
+  BlockID id = BLOCK_AIR;
+  if (place) {
+    block += target.normal;
+    id = BLOCK_PLANKS;
+  }
+
+  // Don't place blocks inside the player, compared relative to the origin of the player chunk
+  const PhysicsBody& player = prediction.getBody();
+  AABB bounds = player.bounds();
+  glm::vec3 cell = WorldPosition::fromBlock(block.x, block.y, block.z).relativeTo(player.position.chunkX, player.position.chunkZ);
+  bool insidePlayer = cell.x + 1 > bounds.min.x && cell.x < bounds.max.x && cell.y + 1 > bounds.min.y
+    && cell.y < bounds.max.y && cell.z + 1 > bounds.min.z && cell.z < bounds.max.z;
+  if (place && (target.face == FACE_COUNT || insidePlayer)) {
+    return;
+  }
+
+  // Shown right away, the server drops the item and sends the edit back once it applied it
+  world.setBlock(block.x, block.y, block.z, id);
+  terrain.blockChanged(block.x, block.y, block.z);
+  if (connection != CONNECTION_NONE) {
+    message.clear();
+    encodeBlockEdit(BlockEdit{ block.x, block.y, block.z, id }, message);
+    net.send(connection, message.data(), message.size());
+  }
+}
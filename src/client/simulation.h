@@ -0,0 +1,142 @@
+/* simulation.h */
+
+#ifndef SIMULATION_HEADER_H
+#define SIMULATION_HEADER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+
+#include "../world/world.h"
+#include "../world/storage/codec.h"
+#include "../ecs/registry.h"
+#include "../jobs/job_system.h"
+#include "../entity/player.h"
+#include "../net/net_loop.h"
+#include "../net/chunk_protocol.h"
+#include "../net/entity_protocol.h"
+#include "../net/session_protocol.h"
+#include "../server/server.h"
+#include "../util/spsc_queue.h"
+#include "../util/triple_buffer.h"
+#include "../gfx/camera/camera.h"
+#include "../gfx/render/render_snapshot.h"
+#include "../gfx/render/terrain_view.h"
+
+// Radius in chunks around the camera that gets drawn, the server sends one ring more so the border chunks can be meshed
+#define VIEW_DISTANCE 8
+// Radius in chunks of the downsampled distant terrain
+#define LOD_DISTANCE 32
+#define WORLD_SEED 1337
+#define WORLD_DIRECTORY "./saves/world"
+// How far away blocks can be broken and placed
+#define REACH_DISTANCE 6.0f
+#define CAMERA_FOV 90.0f
+#define CAMERA_NEAR 0.1f
+#define CAMERA_FAR (LOD_DISTANCE * SECTION_SIZE * 1.5f)
+// Inputs the GL thread can get ahead of the simulation, a full queue drops the newest
+#define SIMULATION_INPUT_QUEUE 64
+
+// What the GL thread sampled from the window, sent whenever it changes
+struct FrameInput {
+  // Movement keys and facing, the sequence number is assigned by the prediction
+  PlayerInput player;
+  glm::vec3 orientation;
+  // Mouse buttons pressed since the last input sent
+  bool breakBlock;
+  bool placeBlock;
+
+  FrameInput() : orientation(0.0f, 0.0f, -1.0f), breakBlock(false), placeBlock(false) {
+    player.sequence = 0;
+    player.keys = 0;
+    player.yaw = 0.0f;
+  }
+};
+
+// The single player game without its window. The game itself runs on a Server in process, on a thread of its own and
+// with its own world and persistence, and the simulation is its client: connected over loopback like any other, it
+// mirrors the chunks and entities the server streams, predicts the player and sends its inputs and block edits. The
+// client side advances at PLAYER_INPUT_RATE on another thread, so a slow frame never slows the game down and a slow
+// tick never stalls the frame. Nothing here touches GL. The GL thread talks to it through three lock-free channels:
+// inputs go in through a queue, every tick publishes a RenderSnapshot through a triple buffer the GL thread reads the
+// newest one from, and mesh changes come out through the TerrainView's queue, which unlike snapshots loses nothing.
+class Simulation : public NetHandler {
+public:
+  // Constructor & destructor, the constructor sets up the server and connects to it, the destructor stops both and the
+  // server saves the world
+  Simulation(JobSystem& jobs, int width, int height);
+  ~Simulation();
+
+  // Starts and stops the tick thread and the server's. Only the tick thread may touch the world while it runs. The
+  // server can't be started again once stopped.
+  void start();
+  void stop();
+
+  // GL thread: false when the input queue is full
+  bool sendInput(const FrameInput& input) { return inputs.push(input); }
+
+  // GL thread: moves to the newest snapshot, false when none was published since the last call. A snapshot lists
+  // meshes sent up to its tick, so take the mesh updates after it and apply them up to its tick before drawing it.
+  bool takeSnapshot() { return snapshots.acquire(); }
+  const RenderSnapshot& snapshot() const { return snapshots.read(); }
+  MeshUpdate* takeMeshUpdates() { return terrain.takeUpdates(); }
+
+  // Network events, on the tick thread
+  void onMessage(ConnectionId id, const uint8_t* data, size_t size);
+  void onDisconnect(ConnectionId id);
+
+  // Only while the tick thread is stopped
+  const NetStats& getNetStats() const { return net.getStats(); }
+  size_t getMeshedChunks() const { return terrain.getMeshedChunks(); }
+  // Predictions the server's player state corrected
+  uint64_t getCorrections() const { return prediction.corrections; }
+  uint64_t getTicks() const { return ticks; }
+  // Ticks that started late because the previous ones took longer than the tick interval
+  uint64_t getOverruns() const { return overruns; }
+
+private:
+  JobSystem& jobs;
+
+  Server server;
+  std::thread serverThread;
+
+  NetLoop net;
+  ConnectionId connection;
+  // Decompresses the chunk batches
+  Codec* codec;
+  ChunkUpdates chunkUpdates;
+  std::vector<uint8_t> message;
+
+  // Only holds what the server sent, plus the local player's edits until the server confirms them
+  World world;
+  TerrainView terrain;
+
+  // Mirrors of the entities around the player
+  Registry registry;
+  RemoteEntities remote;
+
+  // Player, the camera follows its physics body. Inputs are predicted locally and sent to the server, the states it
+  // sends back correct the prediction.
+  PlayerPrediction prediction;
+  Camera camera;
+
+  SpscQueue<FrameInput> inputs;
+  TripleBuffer<RenderSnapshot> snapshots;
+  // Latest input received, held keys keep acting until the GL thread sends a change
+  FrameInput input;
+
+  std::thread thread;
+  std::atomic<bool> running;
+  uint64_t ticks;
+  uint64_t overruns;
+
+  void run();
+  // Advances the client by one tick
+  void tick();
+  // Hands the chunks a batch changed to the terrain view
+  void applyChunkUpdates();
+  // Breaks or places the block the camera looks at, locally and on the server
+  void editBlock(bool place);
+};
+
+#endif
@@ -0,0 +1,121 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "archetype.h"
+
+static size_t alignUp(size_t value, size_t align) {
+  return (value + align - 1) & ~(align - 1);
+}
+
+Archetype::Archetype(ComponentMask mask) : mask(mask) {
+  count = 0;
+
+  size_t rowSize = sizeof(Entity);
+  for (ComponentID id = 0; id < MAX_COMPONENTS; id++) {
+    offsets[id] = 0;
+    if (mask & ((ComponentMask)1 << id)) {
+      rowSize += Components::info(id).size;
+    }
+  }
+
+  // Fit as many rows as possible, the alignment padding between the arrays may cost a row or two
+  capacity = ARCHETYPE_CHUNK_SIZE / rowSize;
+  if (capacity == 0) {
+    capacity = 1;
+  }
+
+  while (true) {
+    size_t offset = sizeof(Entity) * capacity;
+    for (ComponentID id = 0; id < MAX_COMPONENTS; id++) {
+      if (mask & ((ComponentMask)1 << id)) {
+        const ComponentInfo& info = Components::info(id);
+        offset = alignUp(offset, info.align);
+        offsets[id] = offset;
+        offset += info.size * capacity;
+      }
+    }
+
+    chunkBytes = offset;
+    if (chunkBytes <= ARCHETYPE_CHUNK_SIZE || capacity == 1) {
+      break;
+    }
+    capacity--;
+  }
+}
+
+Archetype::~Archetype() {
+  for (size_t i = 0; i < chunks.size(); i++) {
+    free(chunks[i].data);
+  }
+}
+
+void* Archetype::component(uint32_t row, ComponentID id) const {
+  const ArchetypeChunk& chunk = chunks[row / capacity];
+  return chunk.data + offsets[id] + (row % capacity) * Components::info(id).size;
+}
+
+Entity Archetype::entity(uint32_t row) const {
+  return entities(row / capacity)[row % capacity];
+}
+
+uint32_t Archetype::push(Entity entity) {
+  if (count == chunks.size() * capacity) {
+    ArchetypeChunk chunk;
+    chunk.data = (uint8_t*)calloc(1, chunkBytes);
+    chunk.count = 0;
+    chunks.push_back(chunk);
+  }
+
+  uint32_t row = count++;
+  ArchetypeChunk& chunk = chunks[row / capacity];
+  uint32_t slot = chunk.count++;
+
+  ((Entity*)chunk.data)[slot] = entity;
+  for (ComponentID id = 0; id < MAX_COMPONENTS; id++) {
+    if (mask & ((ComponentMask)1 << id)) {
+      size_t size = Components::info(id).size;
+      memset(chunk.data + offsets[id] + slot * size, 0, size);
+    }
+  }
+
+  return row;
+}
+
+Entity Archetype::remove(uint32_t row) {
+  uint32_t last = --count;
+  ArchetypeChunk& lastChunk = chunks[last / capacity];
+  lastChunk.count--;
+
+  Entity moved = ENTITY_NULL;
+  if (row != last) {
+    ArchetypeChunk& chunk = chunks[row / capacity];
+    uint32_t slot = row % capacity;
+    uint32_t lastSlot = last % capacity;
+
+    moved = ((Entity*)lastChunk.data)[lastSlot];
+    ((Entity*)chunk.data)[slot] = moved;
+    for (ComponentID id = 0; id < MAX_COMPONENTS; id++) {
+      if (mask & ((ComponentMask)1 << id)) {
+        size_t size = Components::info(id).size;
+        memcpy(chunk.data + offsets[id] + slot * size, lastChunk.data + offsets[id] + lastSlot * size, size);
+      }
+    }
+  }
+
+  // Keep one spare chunk around so an entity bouncing around the boundary doesn't allocate every time
+  while (chunks.size() > 1 && chunks[chunks.size() - 2].count == 0) {
+    free(chunks.back().data);
+    chunks.pop_back();
+  }
+
+  return moved;
+}
+
+void Archetype::copyRow(uint32_t row, const Archetype& source, uint32_t sourceRow) {
+  ComponentMask shared = mask & source.mask;
+  for (ComponentID id = 0; id < MAX_COMPONENTS; id++) {
+    if (shared & ((ComponentMask)1 << id)) {
+      memcpy(component(row, id), source.component(sourceRow, id), Components::info(id).size);
+    }
+  }
+}
@@ -0,0 +1,62 @@
+/* archetype.h */
+
+#ifndef ARCHETYPE_HEADER_H
+#define ARCHETYPE_HEADER_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "entity.h"
+#include "component.h"
+
+// Size of the blocks entities are packed into, small enough that a chunk of the components a system touches stays
+// in L1/L2 while it is being processed
+#define ARCHETYPE_CHUNK_SIZE 16384
+
+// Fixed size block holding 'count' entities of one archetype. Every component gets its own contiguous array (SoA),
+// the arrays start at the offsets stored in the archetype.
+struct ArchetypeChunk {
+  uint8_t* data;
+  uint32_t count;
+};
+
+// Storage for all entities with exactly the same set of components. Entities are kept packed: rows are numbered
+// across chunks, every chunk but the last is full and removal moves the last row into the hole.
+class Archetype {
+public:
+  const ComponentMask mask;
+  // Entities per chunk
+  uint32_t capacity;
+
+  // Constructor & destructor
+  Archetype(ComponentMask mask);
+  ~Archetype();
+
+  uint32_t size() const { return count; }
+  size_t chunkCount() const { return chunks.size(); }
+  const ArchetypeChunk& chunk(size_t index) const { return chunks[index]; }
+
+  Entity* entities(size_t chunk) const { return (Entity*)chunks[chunk].data; }
+  void* column(size_t chunk, ComponentID id) const { return chunks[chunk].data + offsets[id]; }
+
+  // Address of one component of a row
+  void* component(uint32_t row, ComponentID id) const;
+  Entity entity(uint32_t row) const;
+
+  // Appends a zero initialized row and returns its number
+  uint32_t push(Entity entity);
+
+  // Removes a row by moving the last row into it, returns the entity that was moved or ENTITY_NULL
+  Entity remove(uint32_t row);
+
+  // Copies the components both archetypes have from a row of 'source' into a row of this archetype
+  void copyRow(uint32_t row, const Archetype& source, uint32_t sourceRow);
+
+private:
+  size_t offsets[MAX_COMPONENTS];
+  size_t chunkBytes;
+  std::vector<ArchetypeChunk> chunks;
+  uint32_t count;
+};
+
+#endif
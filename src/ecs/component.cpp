@@ -0,0 +1,27 @@
+#include <mutex>
+#include <string>
+
+#include "component.h"
+
+using namespace std;
+
+static ComponentInfo componentInfo[MAX_COMPONENTS];
+static ComponentID componentCount = 0;
+static mutex componentMutex;
+
+ComponentID Components::registerComponent(size_t size, size_t align) {
+  lock_guard<mutex> lock(componentMutex);
+
+  if (componentCount >= MAX_COMPONENTS) {
+    throw(string)"ERROR::ECS::TOO_MANY_COMPONENT_TYPES";
+  }
+
+  componentInfo[componentCount].size = size;
+  componentInfo[componentCount].align = align;
+
+  return componentCount++;
+}
+
+const ComponentInfo& Components::info(ComponentID id) {
+  return componentInfo[id];
+}
@@ -0,0 +1,55 @@
+/* component.h */
+
+#ifndef COMPONENT_HEADER_H
+#define COMPONENT_HEADER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define MAX_COMPONENTS 32
+
+typedef uint32_t ComponentID;
+// One bit per component type, an archetype is the set of components its entities have
+typedef uint32_t ComponentMask;
+
+struct ComponentInfo {
+  size_t size;
+  size_t align;
+};
+
+// Component types are plain structs, they are zero initialized on creation and moved between archetypes with memcpy
+// so they must be trivially copyable and must not own resources. Shared resources (like the spatial hash) can take an
+// id as well, no entity ever stores them but systems can declare reading or writing them through their mask.
+class Components {
+public:
+  // Returns the id of a component type, registering it on first use
+  template <typename T>
+  static ComponentID id() {
+    static const ComponentID componentID = registerComponent(sizeof(T), alignof(T));
+    return componentID;
+  }
+
+  template <typename T>
+  static ComponentMask mask() {
+    return (ComponentMask)1 << id<T>();
+  }
+
+  static const ComponentInfo& info(ComponentID id);
+
+private:
+  static ComponentID registerComponent(size_t size, size_t align);
+};
+
+// Mask of several component types
+template <typename... Ts>
+ComponentMask componentMask() {
+  ComponentMask masks[] = { 0, Components::mask<Ts>()... };
+  ComponentMask mask = 0;
+  for (size_t i = 0; i < sizeof(masks) / sizeof(masks[0]); i++) {
+    mask |= masks[i];
+  }
+
+  return mask;
+}
+
+#endif
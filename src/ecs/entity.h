@@ -0,0 +1,28 @@
+/* entity.h */
+
+#ifndef ENTITY_HEADER_H
+#define ENTITY_HEADER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Handle to an entity. The index names a slot in the registry and the generation is bumped every time the slot is
+// reused, so handles to destroyed entities can be detected instead of silently pointing at a new entity.
+struct Entity {
+  uint32_t index;
+  uint32_t generation;
+
+  bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+  bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+// Generation 0 is never handed out
+static const Entity ENTITY_NULL = { 0, 0 };
+
+struct EntityHash {
+  size_t operator()(const Entity& entity) const {
+    return ((size_t)entity.index * 0x9E3779B1u) ^ entity.generation;
+  }
+};
+
+#endif
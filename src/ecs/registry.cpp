@@ -0,0 +1,107 @@
+#include "registry.h"
+
+using namespace std;
+
+Registry::Registry() {
+  EntityRecord reserved = { 0, NULL, 0 };
+  records.push_back(reserved);
+}
+
+Registry::~Registry() {
+  for (size_t i = 0; i < archetypeList.size(); i++) {
+    delete archetypeList[i];
+  }
+}
+
+Archetype* Registry::getArchetype(ComponentMask mask) {
+  auto it = archetypes.find(mask);
+  if (it != archetypes.end()) {
+    return it->second;
+  }
+
+  Archetype* archetype = new Archetype(mask);
+  archetypes.insert({ mask, archetype });
+  archetypeList.push_back(archetype);
+
+  return archetype;
+}
+
+Entity Registry::create(ComponentMask mask) {
+  uint32_t index;
+  if (!freeSlots.empty()) {
+    index = freeSlots.back();
+    freeSlots.pop_back();
+  }
+  else {
+    index = (uint32_t)records.size();
+    EntityRecord record = { 0, NULL, 0 };
+    records.push_back(record);
+  }
+
+  EntityRecord& record = records[index];
+  record.generation++;
+  // Generation 0 marks ENTITY_NULL, skip it when the counter wraps
+  if (record.generation == 0) {
+    record.generation = 1;
+  }
+
+  Entity entity = { index, record.generation };
+  record.archetype = getArchetype(mask);
+  record.row = record.archetype->push(entity);
+
+  return entity;
+}
+
+bool Registry::alive(Entity entity) const {
+  return entity.index > 0 && entity.index < records.size() && records[entity.index].generation == entity.generation
+    && records[entity.index].archetype != NULL;
+}
+
+void Registry::removeRow(Archetype* archetype, uint32_t row) {
+  Entity moved = archetype->remove(row);
+  if (moved != ENTITY_NULL) {
+    records[moved.index].row = row;
+  }
+}
+
+void Registry::destroy(Entity entity) {
+  if (!alive(entity)) {
+    return;
+  }
+
+  EntityRecord& record = records[entity.index];
+  removeRow(record.archetype, record.row);
+
+  record.archetype = NULL;
+  freeSlots.push_back(entity.index);
+}
+
+void Registry::destroyLater(Entity entity) {
+  lock_guard<mutex> lock(pendingMutex);
+  pendingDestroys.push_back(entity);
+}
+
+void Registry::flush() {
+  lock_guard<mutex> lock(pendingMutex);
+
+  for (size_t i = 0; i < pendingDestroys.size(); i++) {
+    destroy(pendingDestroys[i]);
+  }
+  pendingDestroys.clear();
+}
+
+void Registry::setMask(Entity entity, ComponentMask mask) {
+  EntityRecord& record = records[entity.index];
+  Archetype* source = record.archetype;
+  if (source->mask == mask) {
+    return;
+  }
+
+  Archetype* target = getArchetype(mask);
+  uint32_t row = target->push(entity);
+  target->copyRow(row, *source, record.row);
+  removeRow(source, record.row);
+
+  record.archetype = target;
+  record.row = row;
+}
@@ -0,0 +1,128 @@
+/* registry.h */
+
+#ifndef REGISTRY_HEADER_H
+#define REGISTRY_HEADER_H
+
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+
+#include "entity.h"
+#include "component.h"
+#include "archetype.h"
+
+struct EntityRecord {
+  uint32_t generation;
+  Archetype* archetype;
+  uint32_t row;
+};
+
+// Owns all entities and their components, grouped by archetype. Creating, destroying and adding or removing
+// components are structural changes that move rows around, they must not happen while systems iterate; systems use
+// destroyLater() instead, which is applied by flush().
+class Registry {
+public:
+  // Constructor & destructor
+  Registry();
+  ~Registry();
+
+  Entity create(ComponentMask mask);
+  void destroy(Entity entity);
+  bool alive(Entity entity) const;
+
+  // Number of live entities
+  size_t size() const { return records.size() - freeSlots.size() - 1; }
+
+  // Queues a destroy, safe to call from systems running in parallel
+  void destroyLater(Entity entity);
+  // Applies the queued destroys
+  void flush();
+
+  template <typename... Ts>
+  Entity create() {
+    return create(componentMask<Ts...>());
+  }
+
+  // Returns the component of an entity or NULL when it is dead or doesn't have one
+  template <typename T>
+  T* get(Entity entity) const {
+    if (!alive(entity)) {
+      return NULL;
+    }
+
+    const EntityRecord& record = records[entity.index];
+    if (!(record.archetype->mask & Components::mask<T>())) {
+      return NULL;
+    }
+
+    return (T*)record.archetype->component(record.row, Components::id<T>());
+  }
+
+  // Adds a component (zero initialized) or returns the existing one
+  template <typename T>
+  T* add(Entity entity) {
+    if (!alive(entity)) {
+      return NULL;
+    }
+
+    setMask(entity, records[entity.index].archetype->mask | Components::mask<T>());
+
+    return get<T>(entity);
+  }
+
+  template <typename T>
+  void remove(Entity entity) {
+    if (alive(entity)) {
+      setMask(entity, records[entity.index].archetype->mask & ~Components::mask<T>());
+    }
+  }
+
+  // Calls f(count, entities, Ts* columns...) once per archetype chunk holding all of Ts and none of 'exclude', the
+  // columns are contiguous arrays of 'count' components
+  template <typename... Ts, typename F>
+  void eachChunk(F f, ComponentMask exclude = 0) const {
+    ComponentMask mask = componentMask<Ts...>();
+
+    for (size_t i = 0; i < archetypeList.size(); i++) {
+      const Archetype& archetype = *archetypeList[i];
+      if ((archetype.mask & mask) != mask || (archetype.mask & exclude)) {
+        continue;
+      }
+
+      for (size_t c = 0; c < archetype.chunkCount(); c++) {
+        uint32_t count = archetype.chunk(c).count;
+        if (count > 0) {
+          f((size_t)count, (const Entity*)archetype.entities(c), (Ts*)archetype.column(c, Components::id<Ts>())...);
+        }
+      }
+    }
+  }
+
+  // Calls f(entity, Ts&...) for every entity holding all of Ts
+  template <typename... Ts, typename F>
+  void each(F f) const {
+    eachChunk<Ts...>([&f](size_t count, const Entity* entities, Ts*... columns) {
+      for (size_t i = 0; i < count; i++) {
+        f(entities[i], columns[i]...);
+      }
+    });
+  }
+
+private:
+  // Slot 0 is reserved so ENTITY_NULL never refers to a live entity
+  std::vector<EntityRecord> records;
+  std::vector<uint32_t> freeSlots;
+
+  std::unordered_map<ComponentMask, Archetype*> archetypes;
+  std::vector<Archetype*> archetypeList;
+
+  std::mutex pendingMutex;
+  std::vector<Entity> pendingDestroys;
+
+  Archetype* getArchetype(ComponentMask mask);
+  void setMask(Entity entity, ComponentMask mask);
+  // Removes a row from its archetype and fixes the record of the entity moved into it
+  void removeRow(Archetype* archetype, uint32_t row);
+};
+
+#endif
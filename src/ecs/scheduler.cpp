@@ -0,0 +1,53 @@
+#include "scheduler.h"
+
+using namespace std;
+
+SystemScheduler::SystemScheduler(JobSystem& jobs) : jobs(jobs) {
+}
+
+bool SystemScheduler::conflicts(const System& a, const System& b) {
+  return (a.writes & (b.reads | b.writes)) || (b.writes & a.reads);
+}
+
+void SystemScheduler::add(const string& name, ComponentMask reads, ComponentMask writes, SystemFunction function) {
+  System system = { name, reads, writes, function, vector<size_t>() };
+
+  // Newest first, so a conflict that an already added dependency waits for (directly or further up) isn't added twice
+  vector<bool> implied(systems.size(), false);
+  for (size_t i = systems.size(); i-- > 0;) {
+    if (implied[i]) {
+      for (size_t d = 0; d < systems[i].dependencies.size(); d++) {
+        implied[systems[i].dependencies[d]] = true;
+      }
+      continue;
+    }
+
+    if (conflicts(systems[i], system)) {
+      system.dependencies.push_back(i);
+      implied[i] = true;
+      for (size_t d = 0; d < systems[i].dependencies.size(); d++) {
+        implied[systems[i].dependencies[d]] = true;
+      }
+    }
+  }
+
+  systems.push_back(system);
+}
+
+void SystemScheduler::run(Registry& registry, float dt) {
+  handles.clear();
+  for (size_t i = 0; i < systems.size(); i++) {
+    dependencies.clear();
+    for (size_t d = 0; d < systems[i].dependencies.size(); d++) {
+      dependencies.push_back(handles[systems[i].dependencies[d]]);
+    }
+
+    const SystemFunction* function = &systems[i].function;
+    Registry* target = &registry;
+    handles.push_back(jobs.submit([function, target, dt]() { (*function)(*target, dt); }, JOB_HIGH, dependencies));
+  }
+
+  jobs.wait(handles);
+  handles.clear();
+  registry.flush();
+}
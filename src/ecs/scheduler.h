@@ -0,0 +1,46 @@
+/* scheduler.h */
+
+#ifndef SCHEDULER_HEADER_H
+#define SCHEDULER_HEADER_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "registry.h"
+#include "../jobs/job_system.h"
+
+typedef std::function<void(Registry& registry, float dt)> SystemFunction;
+
+// Runs systems once per tick on the job system. Every system declares the components it reads and writes and depends
+// on every earlier system it conflicts with (one writes a component the other touches), so systems run as soon as
+// those finished instead of waiting for a whole stage, and in the order they were added where they conflict. Queued
+// destroys are applied after the last system.
+class SystemScheduler {
+public:
+  SystemScheduler(JobSystem& jobs);
+
+  void add(const std::string& name, ComponentMask reads, ComponentMask writes, SystemFunction function);
+
+  // Blocks until every system ran, the calling thread runs jobs meanwhile
+  void run(Registry& registry, float dt);
+
+private:
+  struct System {
+    std::string name;
+    ComponentMask reads;
+    ComponentMask writes;
+    SystemFunction function;
+    // Earlier systems this one has to wait for, only the ones not already implied by another dependency
+    std::vector<size_t> dependencies;
+  };
+
+  JobSystem& jobs;
+  std::vector<System> systems;
+  std::vector<JobHandle> handles;
+  std::vector<JobHandle> dependencies;
+
+  static bool conflicts(const System& a, const System& b);
+};
+
+#endif
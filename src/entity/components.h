@@ -0,0 +1,55 @@
+/* components.h */
+
+#ifndef COMPONENTS_HEADER_H
+#define COMPONENTS_HEADER_H
+
+#include <stdint.h>
+#include <glm/glm.hpp>
+
+#include "../world/block.h"
+#include "../physics/physics.h"
+
+// Component types of the game entities, PhysicsBody is used as a component as is
+
+// Mobs walk in a random direction for a while, then stop or pick a new one
+struct Wander {
+  float timer;
+  float yaw;
+  float speed;
+  uint32_t seed;
+};
+
+// A block lying on the ground after it was broken
+struct ItemDrop {
+  BlockID id;
+  float age;
+};
+
+// Bodies moved by player input instead of the physics system, one input step at a time (see player.h)
+struct PlayerControl {
+  // Sequence number of the last input applied
+  uint32_t lastInput;
+  // Seconds of movement the player may still simulate, refilled with real time so a client can't move faster by
+  // sending more inputs
+  float budget;
+};
+
+// Shapes entities are drawn with, every model is a single instanced draw
+enum ModelID : uint8_t {
+  MODEL_CUBE = 0,
+  MODEL_MOB,
+
+  MODEL_COUNT
+};
+
+// How the entity is drawn: a model scaled by 'scale', tinted with 'color' and turned by 'yaw' around the Y axis.
+// Models are textured with the atlas tiles of 'block', or left untextured for BLOCK_AIR.
+struct Appearance {
+  glm::vec3 color;
+  float scale;
+  float yaw;
+  ModelID model;
+  BlockID block;
+};
+
+#endif
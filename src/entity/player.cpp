@@ -0,0 +1,94 @@
+#include <math.h>
+
+#include "player.h"
+
+static bool matches(const PhysicsBody& a, const PhysicsBody& b) {
+  glm::vec3 offset = a.position - b.position;
+  glm::vec3 velocity = a.velocity - b.velocity;
+
+  return glm::dot(offset, offset) <= PLAYER_PREDICTION_TOLERANCE * PLAYER_PREDICTION_TOLERANCE
+    && glm::dot(velocity, velocity) <= PLAYER_PREDICTION_TOLERANCE * PLAYER_PREDICTION_TOLERANCE && a.onGround == b.onGround;
+}
+
+void applyPlayerInput(const World& world, PhysicsBody& body, const PlayerInput& input) {
+  // Same conventions as the camera: yaw 0 looks down -Z, right is forward x up
+  glm::vec3 forward = glm::vec3(-sinf(input.yaw), 0.0f, -cosf(input.yaw));
+  glm::vec3 right = glm::vec3(-forward.z, 0.0f, forward.x);
+  glm::vec3 direction = glm::vec3(0.0f);
+
+  if (input.keys & KEY_FORWARD) {
+    direction += forward;
+  }
+  if (input.keys & KEY_BACK) {
+    direction -= forward;
+  }
+  if (input.keys & KEY_LEFT) {
+    direction -= right;
+  }
+  if (input.keys & KEY_RIGHT) {
+    direction += right;
+  }
+
+  if (glm::length(direction) > 0.0f) {
+    direction = glm::normalize(direction);
+  }
+  body.velocity.x = direction.x * PLAYER_WALK_SPEED;
+  body.velocity.z = direction.z * PLAYER_WALK_SPEED;
+
+  if ((input.keys & KEY_JUMP) && body.onGround) {
+    body.velocity.y = PLAYER_JUMP_VELOCITY;
+  }
+
+  Physics::step(world, body, PLAYER_INPUT_DT);
+}
+
+PlayerPrediction::PlayerPrediction(const PhysicsBody& body) {
+  this->body = body;
+  this->nextSequence = 1;
+  this->acknowledged = 0;
+  this->corrections = 0;
+  this->replayedInputs = 0;
+}
+
+PlayerInput PlayerPrediction::predict(const World& world, PlayerInput input) {
+  input.sequence = nextSequence++;
+  applyPlayerInput(world, body, input);
+
+  Entry& entry = history[input.sequence & (PLAYER_INPUT_HISTORY - 1)];
+  entry.input = input;
+  entry.result = body;
+
+  return input;
+}
+
+bool PlayerPrediction::reconcile(const World& world, uint32_t sequence, const PhysicsBody& authoritative) {
+  // Stale or out of order acknowledgements carry nothing new
+  if (sequence <= acknowledged || sequence >= nextSequence) {
+    return false;
+  }
+  acknowledged = sequence;
+
+  // Inputs older than the history are gone, all that can be done is to take the server state
+  if (nextSequence - sequence > PLAYER_INPUT_HISTORY) {
+    body = authoritative;
+    corrections++;
+    return true;
+  }
+
+  if (matches(history[sequence & (PLAYER_INPUT_HISTORY - 1)].result, authoritative)) {
+    return false;
+  }
+
+  // Re-simulate the unacknowledged inputs on top of the server state, updating the history as they would have been
+  // predicted
+  body = authoritative;
+  for (uint32_t s = sequence + 1; s < nextSequence; s++) {
+    Entry& entry = history[s & (PLAYER_INPUT_HISTORY - 1)];
+    applyPlayerInput(world, body, entry.input);
+    entry.result = body;
+    replayedInputs++;
+  }
+
+  corrections++;
+  return true;
+}
@@ -0,0 +1,78 @@
+/* player.h */
+
+#ifndef PLAYER_HEADER_H
+#define PLAYER_HEADER_H
+
+#include <stdint.h>
+
+#include "../world/world.h"
+#include "../physics/physics.h"
+
+// Players move in fixed steps, one input per step, independent of the frame and server tick rate so the client and
+// the server run exactly the same simulation
+#define PLAYER_INPUT_RATE 60
+#define PLAYER_INPUT_DT (1.0f / PLAYER_INPUT_RATE)
+// Inputs remembered for reconciliation, a power of two. About two seconds, a round trip longer than that snaps the
+// player to the server state instead of replaying.
+#define PLAYER_INPUT_HISTORY 128
+// Predicted and authoritative positions closer than this (in blocks) count as equal
+#define PLAYER_PREDICTION_TOLERANCE 0.001f
+
+enum PlayerKey : uint8_t {
+  KEY_FORWARD = 1,
+  KEY_BACK = 2,
+  KEY_LEFT = 4,
+  KEY_RIGHT = 8,
+  KEY_JUMP = 16,
+
+  KEY_ALL = 31
+};
+
+// The keys held during one input step and the direction the player faces, in radians around Y with 0 looking
+// down -Z. This is all a client sends about its movement.
+struct PlayerInput {
+  uint32_t sequence;
+  float yaw;
+  uint8_t keys;
+};
+
+// Sets the body's velocity from the input and advances it by one input step
+void applyPlayerInput(const World& world, PhysicsBody& body, const PlayerInput& input);
+
+// Client side prediction. Inputs are applied locally right away and kept in a ring buffer together with the state
+// they produced. When the server reports the state after an input, the prediction for that input is compared with
+// it: if they match nothing happens, otherwise the player is reset to the server state and only the inputs the
+// server hasn't applied yet are replayed.
+class PlayerPrediction {
+public:
+  // Constructor, 'body' is the state the server spawned the player with
+  PlayerPrediction(const PhysicsBody& body);
+
+  // Numbers the input, applies it and remembers it, returns the numbered input to send to the server
+  PlayerInput predict(const World& world, PlayerInput input);
+
+  // Authoritative state after the server applied input 'sequence'. Returns true when the prediction was corrected.
+  bool reconcile(const World& world, uint32_t sequence, const PhysicsBody& authoritative);
+
+  const PhysicsBody& getBody() const { return body; }
+  // Inputs sent but not acknowledged yet
+  uint32_t pending() const { return nextSequence - 1 - acknowledged; }
+
+  uint64_t corrections;
+  uint64_t replayedInputs;
+
+private:
+  struct Entry {
+    PlayerInput input;
+    // State after applying the input
+    PhysicsBody result;
+  };
+
+  PhysicsBody body;
+  Entry history[PLAYER_INPUT_HISTORY];
+  // Sequence numbers start at 1, 0 means no input was acknowledged yet
+  uint32_t nextSequence;
+  uint32_t acknowledged;
+};
+
+#endif
@@ -0,0 +1,132 @@
+#include <math.h>
+
+#include "systems.h"
+
+static uint32_t nextRandom(uint32_t& state) {
+  // xorshift32
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+static float randomFloat(uint32_t& state) {
+  return (nextRandom(state) >> 8) * (1.0f / 16777216.0f);
+}
+
+static void spatialSystem(Registry& registry, SpatialHash& grid) {
+  grid.beginUpdate();
+  registry.eachChunk<PhysicsBody>([&grid](size_t count, const Entity* entities, PhysicsBody* bodies) {
+    for (size_t i = 0; i < count; i++) {
+      grid.update(entities[i], bodies[i].position);
+    }
+  });
+  grid.endUpdate();
+}
+
+static void wanderSystem(Registry& registry, const SpatialHash& grid, float dt) {
+  registry.eachChunk<Wander, PhysicsBody, Appearance>([&grid, dt](size_t count, const Entity* entities, Wander* wander, PhysicsBody* bodies, Appearance* appearance) {
+    for (size_t i = 0; i < count; i++) {
+      Wander& w = wander[i];
+      PhysicsBody& body = bodies[i];
+
+      w.timer -= dt;
+      if (w.timer <= 0.0f) {
+        w.timer = 1.0f + 3.0f * randomFloat(w.seed);
+        w.yaw = randomFloat(w.seed) * 6.2831853f;
+        // Stand still a third of the time
+        w.speed = randomFloat(w.seed) < 0.33f ? 0.0f : MOB_SPEED;
+      }
+
+      // Physics zeroes the velocity of axes that hit something, jump when walking into a wall
+      bool blocked = w.speed > 0.0f && body.velocity.x == 0.0f && body.velocity.z == 0.0f;
+      if (blocked && body.onGround) {
+        body.velocity.y = PLAYER_JUMP_VELOCITY;
+      }
+
+      body.velocity.x = sinf(w.yaw) * w.speed;
+      body.velocity.z = cosf(w.yaw) * w.speed;
+      appearance[i].yaw = w.yaw;
+
+      // Step away from mobs and items that are too close
+      Entity self = entities[i];
+      const WorldPosition& position = body.position;
+      glm::vec3 push(0.0f);
+      grid.forEachInRadius(position, MOB_SIZE, [&](Entity other, const WorldPosition& p) {
+        if (other != self) {
+          glm::vec3 away = position - p;
+          away.y = 0.0f;
+          float distance = glm::length(away);
+          push += distance > 0.001f ? away / distance : glm::vec3(1.0f, 0.0f, 0.0f);
+        }
+      });
+      body.velocity.x += push.x * MOB_SPEED * 0.5f;
+      body.velocity.z += push.z * MOB_SPEED * 0.5f;
+    }
+  });
+}
+
+static void itemSystem(Registry& registry, float dt) {
+  registry.eachChunk<ItemDrop>([&registry, dt](size_t count, const Entity* entities, ItemDrop* items) {
+    for (size_t i = 0; i < count; i++) {
+      items[i].age += dt;
+      if (items[i].age > ITEM_LIFETIME) {
+        registry.destroyLater(entities[i]);
+      }
+    }
+  });
+}
+
+void registerSystems(SystemScheduler& scheduler, const World& world, SpatialHash& grid) {
+  SpatialHash* gridPtr = &grid;
+  ComponentMask gridMask = Components::mask<SpatialHash>();
+
+  scheduler.add("spatial", componentMask<PhysicsBody>(), gridMask, [gridPtr](Registry& registry, float dt) {
+    spatialSystem(registry, *gridPtr);
+  });
+  scheduler.add("items", 0, componentMask<ItemDrop>(), itemSystem);
+  scheduler.add("wander", gridMask, componentMask<Wander, PhysicsBody, Appearance>(), [gridPtr](Registry& registry, float dt) {
+    wanderSystem(registry, *gridPtr, dt);
+  });
+
+  // Bodies are stored contiguously per archetype chunk, so whole chunks are stepped at once. Players move with their
+  // inputs instead.
+  const World* worldPtr = &world;
+  scheduler.add("physics", 0, componentMask<PhysicsBody>(), [worldPtr](Registry& registry, float dt) {
+    registry.eachChunk<PhysicsBody>([worldPtr, dt](size_t count, const Entity* entities, PhysicsBody* bodies) {
+      Physics::stepBodies(*worldPtr, bodies, count, dt);
+    }, componentMask<PlayerControl>());
+  });
+}
+
+Entity spawnMob(Registry& registry, WorldPosition position, uint32_t seed) {
+  Entity entity = registry.create<PhysicsBody, Wander, Appearance>();
+
+  *registry.get<PhysicsBody>(entity) = createBody(position, MOB_SIZE, MOB_SIZE, PLAYER_STEP_HEIGHT);
+
+  Wander* wander = registry.get<Wander>(entity);
+  wander->seed = seed ? seed : 1;
+
+  Appearance* appearance = registry.get<Appearance>(entity);
+  appearance->color = glm::vec3(0.9f, 0.6f + 0.3f * randomFloat(wander->seed), 0.5f);
+  appearance->scale = MOB_SIZE;
+  appearance->model = MODEL_MOB;
+  appearance->block = BLOCK_AIR;
+
+  return entity;
+}
+
+Entity spawnItem(Registry& registry, WorldPosition position, BlockID id) {
+  Entity entity = registry.create<PhysicsBody, ItemDrop, Appearance>();
+
+  *registry.get<PhysicsBody>(entity) = createBody(position, ITEM_SIZE, ITEM_SIZE, 0.0f);
+  registry.get<ItemDrop>(entity)->id = id;
+
+  Appearance* appearance = registry.get<Appearance>(entity);
+  appearance->color = glm::vec3(1.0f);
+  appearance->scale = ITEM_SIZE;
+  appearance->model = MODEL_CUBE;
+  appearance->block = id;
+
+  return entity;
+}
@@ -0,0 +1,27 @@
+/* systems.h */
+
+#ifndef SYSTEMS_HEADER_H
+#define SYSTEMS_HEADER_H
+
+#include "../ecs/registry.h"
+#include "../ecs/scheduler.h"
+#include "../world/world.h"
+#include "../physics/spatial_hash.h"
+#include "components.h"
+
+#define MOB_SIZE 0.9f
+#define MOB_SPEED 2.0f
+#define ITEM_SIZE 0.25f
+// Seconds before dropped items disappear
+#define ITEM_LIFETIME 300.0f
+// Distance from the player at which items are picked up
+#define ITEM_PICKUP_RADIUS 1.5f
+
+// Adds the entity systems to the scheduler. The spatial hash is refreshed from the bodies while items age, then mobs
+// wander (keeping apart from their neighbours through the hash) and physics moves everything.
+void registerSystems(SystemScheduler& scheduler, const World& world, SpatialHash& grid);
+
+Entity spawnMob(Registry& registry, WorldPosition position, uint32_t seed);
+Entity spawnItem(Registry& registry, WorldPosition position, BlockID id);
+
+#endif
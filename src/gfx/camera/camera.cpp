@@ -1,35 +1,59 @@
+#include <math.h>
+
 #include "camera.h"
 
-Camera::Camera(int width, int height, glm::vec3 position) {
+Camera::Camera(int width, int height, WorldPosition position) {
   this->width = width;
   this->height = height;
 
   this->position = position;
 }
 
-void Camera::Matrix(float fFOVdeg, float fNearPlane, float fFarPlane, Shader& shader, const char* uniform) {
+void Camera::UpdateMatrix(float fFOVdeg, float fNearPlane, float fFarPlane) {
   glm::mat4 view = glm::mat4(1.0f);
   glm::mat4 projection = glm::mat4(1.0f);
 
-  view = glm::lookAt(this->position, this->position * this->orientation, this->up);
-  projection = glm::perspective(glm::radians(fFOVdeg), (float)(this->width / this->height), fNearPlane, fFarPlane);
+  view = glm::lookAt(this->position.local, this->position.local + this->orientation, this->up);
+  projection = glm::perspective(glm::radians(fFOVdeg), (float)this->width / this->height, fNearPlane, fFarPlane);
+
+  this->matrix = projection * view;
+}
 
-  glUniformMatrix4fv(glGetUniformLocation(shader.ID, uniform), 1, GL_FALSE, glm::value_ptr(projection * view));
+void Camera::Matrix(float fFOVdeg, float fNearPlane, float fFarPlane, Shader& shader, const char* uniform) {
+  UpdateMatrix(fFOVdeg, fNearPlane, fFarPlane);
+  glUniformMatrix4fv(glGetUniformLocation(shader.ID, uniform), 1, GL_FALSE, glm::value_ptr(this->matrix));
 }
 
-void Camera::Inputs(GLFWwindow* window) {
+PlayerInput Camera::Inputs(GLFWwindow* window) {
+  PlayerInput input;
+  input.sequence = 0;
+  // Walk in the horizontal plane regardless of pitch
+  input.yaw = atan2f(-this->orientation.x, -this->orientation.z);
+  input.keys = 0;
+
   if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
-    this->position += this->speed * this->orientation;
-  };
-  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-  {
-    this->position += this->speed * -glm::normalize(glm::cross(this->orientation, this->up));
+    input.keys |= KEY_FORWARD;
+  }
+  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    input.keys |= KEY_LEFT;
   }
   if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
-    this->position += this->speed * -this->orientation;
-  };
-  if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-  {
-    this->position += this->speed * glm::normalize(glm::cross(this->orientation, this->up));
+    input.keys |= KEY_BACK;
+  }
+  if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    input.keys |= KEY_RIGHT;
   }
-}
\ No newline at end of file
+  if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
+    input.keys |= KEY_JUMP;
+  }
+
+  return input;
+}
+
+void Camera::Follow(const PhysicsBody& body) {
+  this->position = body.position + glm::vec3(0.0f, PLAYER_EYE_HEIGHT, 0.0f);
+}
+
+RayHit Camera::Pick(const World& world, float reach) {
+  return Raycaster::cast(world, this->position, this->orientation, reach);
+}
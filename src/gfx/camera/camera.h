@@ -12,28 +12,43 @@
 #include <glm/gtx/vector_angle.hpp>
 
 #include "../shader/shader.h"
+#include "../../world/raycast.h"
+#include "../../physics/physics.h"
+#include "../../entity/player.h"
 
 class Camera
 {
 public:
-  glm::vec3 position;
+  // Eye position, the view matrix is built relative to the origin of its chunk so precision does not depend on distance
+  WorldPosition position;
   glm::vec3 orientation = glm::vec3(0.0f, 0.0f, -1.0f);
   glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+  // Projection * view of the last Matrix() or UpdateMatrix() call
+  glm::mat4 matrix = glm::mat4(1.0f);
 
   int width;
   int height;
 
-  float speed = 0.1f;
   float sensitivity = 100.0f;
 
   // Constructor
-  Camera(int width, int height, glm::vec3 position);
+  Camera(int width, int height, WorldPosition position);
+
+  // Updates the camera matrix without touching GL, so the simulation thread can compute it for a render snapshot
+  void UpdateMatrix(float fFOVdeg, float fNearPlane, float fFarPlane);
 
   // Updates and exports the camera matrix to the vertex shader
   void Matrix(float fFOVdeg, float fNearPlane, float fFarPlane, Shader& shader, const char* uniform);
 
-  // Handles camera inputs
-  void Inputs(GLFWwindow* window);
+  // Reads the movement keys (WASD and space to jump) and the facing direction into a player input, the movement
+  // itself is applied by applyPlayerInput() so the client predicts exactly what the server simulates
+  PlayerInput Inputs(GLFWwindow* window);
+
+  // Moves the camera to the eye height of the body
+  void Follow(const PhysicsBody& body);
+
+  // Returns the block the camera is looking at within 'reach' blocks
+  RayHit Pick(const World& world, float reach);
 
 };
 
@@ -0,0 +1,37 @@
+#include <math.h>
+
+#include "frustum.h"
+
+void Frustum::update(const glm::mat4& matrix) {
+  // Gribb & Hartmann: every plane is the fourth row of the matrix plus or minus one of the other rows
+  for (int i = 0; i < 3; i++) {
+    for (int side = 0; side < 2; side++) {
+      glm::vec4& plane = planes[i * 2 + side];
+      float sign = side ? -1.0f : 1.0f;
+
+      for (int column = 0; column < 4; column++) {
+        plane[column] = matrix[column][3] + sign * matrix[column][i];
+      }
+
+      float length = sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+      plane = plane / length;
+    }
+  }
+}
+
+bool Frustum::intersectsBox(glm::vec3 min, glm::vec3 max) const {
+  for (int i = 0; i < 6; i++) {
+    const glm::vec4& plane = planes[i];
+
+    // Corner of the box furthest along the plane normal
+    float x = plane.x >= 0.0f ? max.x : min.x;
+    float y = plane.y >= 0.0f ? max.y : min.y;
+    float z = plane.z >= 0.0f ? max.z : min.z;
+
+    if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f) {
+      return false;
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,21 @@
+/* frustum.h */
+
+#ifndef FRUSTUM_HEADER_H
+#define FRUSTUM_HEADER_H
+
+#include <glm/glm.hpp>
+
+class Frustum {
+public:
+  // Extracts the six clip planes from a projection * view matrix
+  void update(const glm::mat4& matrix);
+
+  // Conservative test, boxes near the corners of the frustum may pass
+  bool intersectsBox(glm::vec3 min, glm::vec3 max) const;
+
+private:
+  // Normalized planes (normal, distance) facing inwards
+  glm::vec4 planes[6];
+};
+
+#endif
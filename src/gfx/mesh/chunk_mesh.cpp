@@ -0,0 +1,32 @@
+#include <stddef.h>
+
+#include "chunk_mesh.h"
+
+ChunkMesh::ChunkMesh(MeshData& mesh) :
+  vbo(mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex)),
+  ebo(mesh.indices.data(), mesh.indices.size() * sizeof(GLuint)) {
+  indexCount = (GLsizei)mesh.indices.size();
+  bytes = mesh.bytes();
+
+  // The element buffer binding is stored in the VAO, so bind it again while the VAO is bound
+  vao.bind();
+  ebo.bind();
+
+  vao.link(vbo, vertexLayout());
+
+  // Unbind all to prevent accidentally modifying them
+  vao.unbind();
+  vbo.unbind();
+  ebo.unbind();
+}
+
+void ChunkMesh::draw() {
+  vao.bind();
+  glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+}
+
+void ChunkMesh::remove() {
+  vao.remove();
+  vbo.remove();
+  ebo.remove();
+}
@@ -0,0 +1,32 @@
+/* chunk_mesh.h */
+
+#ifndef CHUNK_MESH_HEADER_H
+#define CHUNK_MESH_HEADER_H
+
+#include <glad/glad.h>
+
+#include "mesher.h"
+#include "../shader/VAO.h"
+#include "../shader/VBO.h"
+#include "../shader/EBO.h"
+
+// GPU side of a meshed section
+class ChunkMesh {
+public:
+  GLsizei indexCount;
+  // GPU memory used by the vertex and index buffers
+  size_t bytes;
+
+  // Constructor, uploads the mesh data
+  ChunkMesh(MeshData& mesh);
+
+  void draw();
+  void remove();
+
+private:
+  VAO vao;
+  VBO vbo;
+  EBO ebo;
+};
+
+#endif
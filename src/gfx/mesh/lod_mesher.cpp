@@ -0,0 +1,140 @@
+#include <string.h>
+
+#include "lod_mesher.h"
+
+void LodMesher::sample(const World& world, ChunkPos pos, ChunkHeightmap& heightmap) {
+  const Chunk* chunk = world.getChunk(pos);
+
+  for (int z = 0; z < SECTION_SIZE; z++) {
+    for (int x = 0; x < SECTION_SIZE; x++) {
+      int column = z * SECTION_SIZE + x;
+
+      if (!chunk) {
+        int height = world.generator.height(pos.x * SECTION_SIZE + x, pos.z * SECTION_SIZE + z);
+        heightmap.height[column] = (int16_t)height;
+        heightmap.top[column] = world.generator.surfaceBlock(height);
+        continue;
+      }
+
+      heightmap.height[column] = -1;
+      heightmap.top[column] = BLOCK_AIR;
+      for (int section = CHUNK_SECTIONS - 1; section >= 0 && heightmap.height[column] < 0; section--) {
+        if (chunk->sections[section].isEmpty()) {
+          continue;
+        }
+
+        for (int y = SECTION_SIZE - 1; y >= 0; y--) {
+          BlockID block = chunk->sections[section].getBlock(x, y, z);
+          if (block != BLOCK_AIR) {
+            heightmap.height[column] = (int16_t)(section * SECTION_SIZE + y);
+            heightmap.top[column] = block;
+            break;
+          }
+        }
+      }
+    }
+  }
+}
+
+// Appends a quad with corners in counter-clockwise order seen from the front, the texture is stretched over the quad
+// Impostors have no ambient occlusion, every corner is open
+static void addQuad(MeshData& mesh, const int corners[4][3], float shade, int tile) {
+  static const int uv[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+
+  GLuint base = (GLuint)mesh.vertices.size();
+  for (int c = 0; c < 4; c++) {
+    mesh.vertices.push_back(packVertex(corners[c][0], corners[c][1], corners[c][2], 3, shade, tile, uv[c][0], uv[c][1]));
+  }
+
+  GLuint quad[6] = { base, base + 1, base + 2, base, base + 2, base + 3 };
+  mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+}
+
+void LodMesher::meshChunk(const ChunkHeightmap& heightmap, int scale, MeshData& mesh) {
+  mesh.vertices.clear();
+  mesh.indices.clear();
+
+  int cells = SECTION_SIZE / scale;
+  int height[SECTION_SIZE * SECTION_SIZE];
+  BlockID top[SECTION_SIZE * SECTION_SIZE];
+
+  // Downsample: each cell keeps its highest column, so distant hills keep their silhouette
+  for (int cz = 0; cz < cells; cz++) {
+    for (int cx = 0; cx < cells; cx++) {
+      int best = -1;
+      BlockID block = BLOCK_AIR;
+      for (int z = cz * scale; z < (cz + 1) * scale; z++) {
+        for (int x = cx * scale; x < (cx + 1) * scale; x++) {
+          int column = z * SECTION_SIZE + x;
+          if (heightmap.height[column] > best) {
+            best = heightmap.height[column];
+            block = heightmap.top[column];
+          }
+        }
+      }
+      height[cz * cells + cx] = best;
+      top[cz * cells + cx] = block;
+    }
+  }
+
+  // Same directional shading as the full detail mesher
+  static const int directions[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+  static const float shades[4] = { 0.8f, 0.8f, 0.6f, 0.6f };
+
+  for (int cz = 0; cz < cells; cz++) {
+    for (int cx = 0; cx < cells; cx++) {
+      int h = height[cz * cells + cx];
+      if (h < 0) {
+        continue;
+      }
+
+      const BlockInfo& info = getBlockInfo(top[cz * cells + cx]);
+      int x0 = cx * scale, x1 = (cx + 1) * scale;
+      int z0 = cz * scale, z1 = (cz + 1) * scale;
+      int y1 = h + 1;
+
+      int topFace[4][3] = { { x0, y1, z1 }, { x1, y1, z1 }, { x1, y1, z0 }, { x0, y1, z0 } };
+      addQuad(mesh, topFace, 1.0f, info.textureTop);
+
+      for (int d = 0; d < 4; d++) {
+        int nx = cx + directions[d][0];
+        int nz = cz + directions[d][1];
+
+        // Walls down to a lower neighbour, skirts along the chunk border
+        int y0;
+        if (nx < 0 || nx >= cells || nz < 0 || nz >= cells) {
+          y0 = h + 1 - LOD_SKIRT_DEPTH;
+        }
+        else {
+          int neighbour = height[nz * cells + nx];
+          if (neighbour >= h) {
+            continue;
+          }
+          y0 = neighbour + 1;
+        }
+        if (y0 < 0) {
+          y0 = 0;
+        }
+
+        int wall[4][3];
+        if (d == 0) {
+          int corners[4][3] = { { x1, y0, z1 }, { x1, y0, z0 }, { x1, y1, z0 }, { x1, y1, z1 } };
+          memcpy(wall, corners, sizeof(wall));
+        }
+        else if (d == 1) {
+          int corners[4][3] = { { x0, y0, z0 }, { x0, y0, z1 }, { x0, y1, z1 }, { x0, y1, z0 } };
+          memcpy(wall, corners, sizeof(wall));
+        }
+        else if (d == 2) {
+          int corners[4][3] = { { x0, y0, z1 }, { x1, y0, z1 }, { x1, y1, z1 }, { x0, y1, z1 } };
+          memcpy(wall, corners, sizeof(wall));
+        }
+        else {
+          int corners[4][3] = { { x1, y0, z0 }, { x0, y0, z0 }, { x0, y1, z0 }, { x1, y1, z0 } };
+          memcpy(wall, corners, sizeof(wall));
+        }
+        addQuad(mesh, wall, shades[d], info.textureSide);
+      }
+    }
+  }
+}
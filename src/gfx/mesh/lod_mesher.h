@@ -0,0 +1,32 @@
+/* lod_mesher.h */
+
+#ifndef LOD_MESHER_HEADER_H
+#define LOD_MESHER_HEADER_H
+
+#include "mesher.h"
+
+// Blocks the walls along the chunk border reach below the surface, enough to cover the step between two LOD levels
+#define LOD_SKIRT_DEPTH 12
+// Chunks a LOD boundary has to be crossed by before the level changes
+#define LOD_HYSTERESIS 1
+
+// Surface of a chunk column by column
+struct ChunkHeightmap {
+  // Y of the highest non-air block, -1 for empty columns
+  int16_t height[SECTION_SIZE * SECTION_SIZE];
+  BlockID top[SECTION_SIZE * SECTION_SIZE];
+};
+
+// Meshes distant chunks as downsampled heightmaps. Every cell of scale x scale columns becomes one box from the
+// highest block in the cell, with walls down to lower neighbouring cells and skirts hanging down along the chunk
+// border which hide the cracks between chunks of different detail.
+class LodMesher {
+public:
+  // Reads the surface from the chunk when it is loaded, which includes edits, and from the generator otherwise
+  static void sample(const World& world, ChunkPos pos, ChunkHeightmap& heightmap);
+
+  // Builds the mesh with positions relative to the chunk origin, 'scale' is 2, 4, 8 or 16
+  static void meshChunk(const ChunkHeightmap& heightmap, int scale, MeshData& mesh);
+};
+
+#endif
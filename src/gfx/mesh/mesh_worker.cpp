@@ -0,0 +1,92 @@
+#include "mesh_worker.h"
+
+using namespace std;
+
+MeshWorker::MeshWorker(JobSystem& jobs) : jobs(jobs) {
+  ready = NULL;
+  running = 0;
+  inFlight = 0;
+}
+
+MeshWorker::~MeshWorker() {
+  // The jobs push into 'results', they have to be done before it goes away
+  jobs.helpUntil([this] { return running.load() == 0; }, JOB_NORMAL);
+
+  MeshResult* result;
+  while ((result = poll())) {
+    delete result;
+  }
+}
+
+bool MeshWorker::request(const World& world, ChunkPos pos) {
+  const Chunk* chunk = world.getChunk(pos);
+  if (!chunk || inFlight >= MESH_WORKER_QUEUE) {
+    return false;
+  }
+
+  MeshRequest* request = new MeshRequest();
+  request->pos = pos;
+  for (int dx = -1; dx <= 1; dx++) {
+    for (int dz = -1; dz <= 1; dz++) {
+      const Chunk* column = world.getChunk({ pos.x + dx, pos.z + dz });
+      request->present[dx + 1][dz + 1] = column != NULL;
+      if (column) {
+        request->columns[dx + 1][dz + 1] = column->snapshot();
+      }
+    }
+  }
+
+  inFlight++;
+  running++;
+  jobs.submit([this, request]() {
+    MeshResult* result = mesh(*request);
+    delete request;
+    results.push(result);
+    running--;
+  }, JOB_NORMAL);
+  return true;
+}
+
+MeshResult* MeshWorker::poll() {
+  if (!ready) {
+    ready = results.popAll();
+    if (!ready) {
+      return NULL;
+    }
+  }
+
+  MeshResult* result = ready;
+  ready = MpscQueue<MeshResult>::next(result);
+  inFlight--;
+  return result;
+}
+
+MeshResult* MeshWorker::mesh(const MeshRequest& request) {
+  // Private chunks sharing the snapshot's section data, dropped again once the chunk is meshed
+  Chunk* chunks[3][3];
+  const Chunk* columns[3][3];
+  for (int x = 0; x < 3; x++) {
+    for (int z = 0; z < 3; z++) {
+      chunks[x][z] = NULL;
+      if (request.present[x][z]) {
+        chunks[x][z] = new Chunk(request.columns[x][z].pos);
+        chunks[x][z]->restore(request.columns[x][z]);
+      }
+      columns[x][z] = chunks[x][z];
+    }
+  }
+
+  MeshResult* result = new MeshResult();
+  result->pos = request.pos;
+  for (int i = 0; i < CHUNK_SECTIONS; i++) {
+    result->connectivity[i] = computeConnectivity(*columns[1][1]->sections[i].share());
+    Mesher::meshSection(columns, i, result->sections[i]);
+  }
+
+  for (int x = 0; x < 3; x++) {
+    for (int z = 0; z < 3; z++) {
+      delete chunks[x][z];
+    }
+  }
+  return result;
+}
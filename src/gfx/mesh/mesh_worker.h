@@ -0,0 +1,62 @@
+/* mesh_worker.h */
+
+#ifndef MESH_WORKER_HEADER_H
+#define MESH_WORKER_HEADER_H
+
+#include <stddef.h>
+#include <atomic>
+
+#include "../../world/world.h"
+#include "../../world/visibility.h"
+#include "../../util/mpsc_queue.h"
+#include "../../jobs/job_system.h"
+#include "mesher.h"
+
+// Chunks queued, being meshed or waiting to be polled at most, bounds the memory the snapshots hold on to
+#define MESH_WORKER_QUEUE 64
+
+struct MeshRequest {
+  ChunkPos pos;
+  // The chunk at [1][1] and its neighbours, a neighbour that wasn't loaded is missing
+  ChunkSnapshot columns[3][3];
+  bool present[3][3];
+};
+
+// CPU side of a meshed chunk, ready for upload
+struct MeshResult : MpscNode {
+  ChunkPos pos;
+  MeshData sections[CHUNK_SECTIONS];
+  FaceConnectivity connectivity[CHUNK_SECTIONS];
+};
+
+// Meshes chunks as jobs on the job system. request() takes copy-on-write snapshots of the chunk and its neighbours,
+// so the mesher never reads the live world and the main thread may keep editing it; every chunk is meshed by its own
+// job, in parallel with the others, and only the GL upload is left for the main thread. Finished meshes come back
+// through an MPSC queue, in the order they finished.
+class MeshWorker {
+public:
+  // Constructor & destructor, the destructor waits for the running jobs and drops their meshes
+  MeshWorker(JobSystem& jobs);
+  ~MeshWorker();
+
+  // Queues a chunk, false when it isn't loaded or MESH_WORKER_QUEUE chunks are in flight already
+  bool request(const World& world, ChunkPos pos);
+  // The next finished mesh or NULL, the caller deletes it
+  MeshResult* poll();
+
+  // Requested and not polled yet
+  size_t pending() const { return inFlight; }
+
+private:
+  JobSystem& jobs;
+  MpscQueue<MeshResult> results;
+  // Popped from 'results' and not handed out yet, linked through MpscNode::next
+  MeshResult* ready;
+  // Jobs that didn't push their result yet
+  std::atomic<size_t> running;
+  size_t inFlight;
+
+  static MeshResult* mesh(const MeshRequest& request);
+};
+
+#endif
@@ -0,0 +1,151 @@
+#include "mesher.h"
+
+// The section is copied with a one block border so neighbour lookups never leave the cache
+#define PADDED_SIZE (SECTION_SIZE + 2)
+#define PADDED_INDEX(x, y, z) (((y) * PADDED_SIZE + (z)) * PADDED_SIZE + (x))
+
+struct FaceDef {
+  int normal[3];
+  // Corner of the block where the quad starts and the two (signed) edges spanning it, cross(u, v) == normal
+  int origin[3];
+  int u[3];
+  int v[3];
+  // Directional shading so faces stay distinguishable without lighting
+  float shade;
+};
+
+static const FaceDef faces[FACE_COUNT] = {
+  // Normal ----- Origin ----- U ---------- V ---------- Shade
+  { {  1, 0, 0 }, { 1, 0, 1 }, { 0, 0, -1 }, { 0, 1, 0 },  0.8f },  // FACE_POS_X
+  { { -1, 0, 0 }, { 0, 0, 0 }, { 0, 0,  1 }, { 0, 1, 0 },  0.8f },  // FACE_NEG_X
+  { { 0,  1, 0 }, { 0, 1, 1 }, { 1, 0,  0 }, { 0, 0, -1 }, 1.0f },  // FACE_POS_Y
+  { { 0, -1, 0 }, { 0, 0, 0 }, { 1, 0,  0 }, { 0, 0,  1 }, 0.5f },  // FACE_NEG_Y
+  { { 0, 0,  1 }, { 0, 0, 1 }, { 1, 0,  0 }, { 0, 1, 0 },  0.6f },  // FACE_POS_Z
+  { { 0, 0, -1 }, { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, 0.6f },  // FACE_NEG_Z
+};
+
+// Quad corners in (u, v) order, counter-clockwise when looking at the face
+static const int corners[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+
+static inline int vertexAO(bool side1, bool side2, bool corner) {
+  if (side1 && side2) {
+    return 0;
+  }
+
+  return 3 - (side1 + side2 + corner);
+}
+
+void Mesher::meshSection(const World& world, const Chunk& chunk, int section, MeshData& mesh) {
+  // Neighbouring columns, indexed by [dx + 1][dz + 1]
+  const Chunk* columns[3][3];
+  for (int dx = -1; dx <= 1; dx++) {
+    for (int dz = -1; dz <= 1; dz++) {
+      columns[dx + 1][dz + 1] = (dx == 0 && dz == 0) ? &chunk : world.getChunk({ chunk.pos.x + dx, chunk.pos.z + dz });
+    }
+  }
+
+  meshSection(columns, section, mesh);
+}
+
+void Mesher::meshSection(const Chunk* columns[3][3], int section, MeshData& mesh) {
+  mesh.vertices.clear();
+  mesh.indices.clear();
+
+  if (columns[1][1]->sections[section].isEmpty()) {
+    return;
+  }
+
+  static thread_local BlockID blocks[PADDED_SIZE * PADDED_SIZE * PADDED_SIZE];
+  static thread_local bool opaque[PADDED_SIZE * PADDED_SIZE * PADDED_SIZE];
+
+  int iBaseY = section * SECTION_SIZE - 1;
+  for (int y = 0; y < PADDED_SIZE; y++) {
+    for (int z = 0; z < PADDED_SIZE; z++) {
+      int lz = z - 1;
+      int cz = lz < 0 ? 0 : (lz >= SECTION_SIZE ? 2 : 1);
+
+      for (int x = 0; x < PADDED_SIZE; x++) {
+        int lx = x - 1;
+        int cx = lx < 0 ? 0 : (lx >= SECTION_SIZE ? 2 : 1);
+
+        const Chunk* column = columns[cx][cz];
+        BlockID block = column ? column->getBlock(lx & SECTION_MASK, iBaseY + y, lz & SECTION_MASK) : (BlockID)BLOCK_AIR;
+
+        blocks[PADDED_INDEX(x, y, z)] = block;
+        opaque[PADDED_INDEX(x, y, z)] = isOpaque(block);
+      }
+    }
+  }
+
+  for (int y = 1; y <= SECTION_SIZE; y++) {
+    for (int z = 1; z <= SECTION_SIZE; z++) {
+      for (int x = 1; x <= SECTION_SIZE; x++) {
+        BlockID block = blocks[PADDED_INDEX(x, y, z)];
+        if (block == BLOCK_AIR) {
+          continue;
+        }
+
+        const BlockInfo& info = getBlockInfo(block);
+
+        for (int f = 0; f < FACE_COUNT; f++) {
+          const FaceDef& face = faces[f];
+
+          // Position of the block the face looks into
+          int nx = x + face.normal[0];
+          int ny = y + face.normal[1];
+          int nz = z + face.normal[2];
+
+          if (opaque[PADDED_INDEX(nx, ny, nz)]) {
+            continue;
+          }
+
+          // Classic voxel AO: every corner is darkened by the two edge neighbours and the diagonal neighbour in the
+          // layer in front of the face, two fully occluding edges hide the corner regardless of the diagonal
+          int ao[4];
+          for (int c = 0; c < 4; c++) {
+            int su = corners[c][0] ? 1 : -1;
+            int sv = corners[c][1] ? 1 : -1;
+
+            int ux = face.u[0] * su, uy = face.u[1] * su, uz = face.u[2] * su;
+            int vx = face.v[0] * sv, vy = face.v[1] * sv, vz = face.v[2] * sv;
+
+            bool side1 = opaque[PADDED_INDEX(nx + ux, ny + uy, nz + uz)];
+            bool side2 = opaque[PADDED_INDEX(nx + vx, ny + vy, nz + vz)];
+            bool corner = opaque[PADDED_INDEX(nx + ux + vx, ny + uy + vy, nz + uz + vz)];
+
+            ao[c] = vertexAO(side1, side2, corner);
+          }
+
+          int tile = f == FACE_POS_Y ? info.textureTop : (f == FACE_NEG_Y ? info.textureBottom : info.textureSide);
+
+          GLuint base = (GLuint)mesh.vertices.size();
+
+          // The shader turns the AO value into brightness and the tile and corner into atlas coordinates
+          for (int c = 0; c < 4; c++) {
+            int cu = corners[c][0];
+            int cv = corners[c][1];
+
+            int position[3];
+            for (int axis = 0; axis < 3; axis++) {
+              int local = (axis == 0 ? x : (axis == 1 ? y : z)) - 1;
+              position[axis] = local + face.origin[axis] + face.u[axis] * cu + face.v[axis] * cv;
+            }
+
+            mesh.vertices.push_back(packVertex(position[0], position[1], position[2], ao[c], face.shade, tile, cu, cv));
+          }
+
+          // Split the quad along the diagonal with the lower AO sum, otherwise the interpolation across the two
+          // triangles makes identical occlusion look different depending on the orientation of the quad
+          if (ao[0] + ao[2] > ao[1] + ao[3]) {
+            GLuint quad[6] = { base + 1, base + 2, base + 3, base + 1, base + 3, base + 0 };
+            mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+          }
+          else {
+            GLuint quad[6] = { base + 0, base + 1, base + 2, base + 0, base + 2, base + 3 };
+            mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+          }
+        }
+      }
+    }
+  }
+}
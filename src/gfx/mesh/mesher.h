@@ -0,0 +1,66 @@
+/* mesher.h */
+
+#ifndef MESHER_HEADER_H
+#define MESHER_HEADER_H
+
+#include <stddef.h>
+#include <vector>
+#include <glad/glad.h>
+
+#include "../../world/world.h"
+#include "../shader/vertex_layout.h"
+
+#define ATLAS_TILES 16
+
+// Terrain vertex, 8 bytes instead of the 32 of a float position, color and texture coordinate. Positions are whole
+// block corners relative to the mesh origin, which both meshers only ever produce.
+struct Vertex {
+  // x, y, z in 10 bits each (0..1023 blocks) and the ambient occlusion value (0 occluded .. 3 open) in the top 2 bits
+  GLuint position;
+  // Directional face shade, normalized
+  GLubyte shade;
+  // Atlas tile, and the corner of the tile in bit 0 (u) and bit 1 (v), integers
+  GLubyte tile;
+  GLubyte corner;
+  GLubyte padding;
+};
+
+static inline Vertex packVertex(int x, int y, int z, int ao, float shade, int tile, int u, int v) {
+  Vertex vertex;
+  vertex.position = packUnsigned10_10_10_2((GLuint)x, (GLuint)y, (GLuint)z, (GLuint)ao);
+  vertex.shade = (GLubyte)(shade * 255.0f + 0.5f);
+  vertex.tile = (GLubyte)tile;
+  vertex.corner = (GLubyte)(u | (v << 1));
+  vertex.padding = 0;
+  return vertex;
+}
+
+// Attribute locations of shader.vs
+static inline VertexLayout vertexLayout() {
+  VertexLayout layout(sizeof(Vertex));
+  layout.packed(0, offsetof(Vertex, position))
+    .normalized(1, 1, GL_UNSIGNED_BYTE, offsetof(Vertex, shade))
+    .integer(2, 1, GL_UNSIGNED_BYTE, offsetof(Vertex, tile))
+    .integer(3, 1, GL_UNSIGNED_BYTE, offsetof(Vertex, corner));
+  return layout;
+}
+
+struct MeshData {
+  std::vector<Vertex> vertices;
+  std::vector<GLuint> indices;
+
+  // GPU memory the mesh takes once uploaded
+  size_t bytes() const { return vertices.size() * sizeof(Vertex) + indices.size() * sizeof(GLuint); }
+};
+
+class Mesher {
+public:
+  // Builds the mesh of one section with positions relative to the section origin. Faces between opaque blocks are
+  // skipped and every vertex gets a baked ambient occlusion term from the three blocks touching its corner.
+  static void meshSection(const World& world, const Chunk& chunk, int section, MeshData& mesh);
+  // Same from the chunk at [1][1] and its neighbours, indexed by [dx + 1][dz + 1] and NULL where missing. Doesn't
+  // touch the world, so it can run on copies of the chunks on another thread.
+  static void meshSection(const Chunk* columns[3][3], int section, MeshData& mesh);
+};
+
+#endif
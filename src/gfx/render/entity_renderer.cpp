@@ -0,0 +1,28 @@
+#include "entity_renderer.h"
+
+void EntityRenderer::collect(const Registry& registry, const WorldPosition& camera, std::vector<EntityInstance>& out) {
+  out.clear();
+
+  registry.eachChunk<PhysicsBody, Appearance>([&out, &camera](size_t count, const Entity* entities, PhysicsBody* bodies, Appearance* appearance) {
+    for (size_t i = 0; i < count; i++) {
+      EntityInstance entity;
+      entity.model = appearance[i].model;
+      glm::vec3 position = bodies[i].position.relativeTo(camera.chunkX, camera.chunkZ);
+      InstancedRenderer::setTransform(entity.instance, position, appearance[i].yaw, appearance[i].scale);
+      InstancedRenderer::setAppearance(entity.instance, appearance[i].color, appearance[i].block);
+      out.push_back(entity);
+    }
+  });
+}
+
+void EntityRenderer::draw(const std::vector<EntityInstance>& entities, Shader& shader) {
+  instanced.begin();
+  for (size_t i = 0; i < entities.size(); i++) {
+    instanced.add(entities[i].model, entities[i].instance);
+  }
+  instanced.draw(shader);
+}
+
+void EntityRenderer::remove() {
+  instanced.remove();
+}
@@ -0,0 +1,34 @@
+/* entity_renderer.h */
+
+#ifndef ENTITY_RENDERER_HEADER_H
+#define ENTITY_RENDERER_HEADER_H
+
+#include <vector>
+
+#include "../../ecs/registry.h"
+#include "../../entity/components.h"
+#include "../shader/shader.h"
+#include "instanced_renderer.h"
+
+// An entity ready to be drawn, its transform relative to the origin of the camera chunk like the camera matrix
+struct EntityInstance {
+  ModelID model;
+  ModelInstance instance;
+};
+
+// Draws every entity with a PhysicsBody and an Appearance through the instanced renderer, one draw call per model
+class EntityRenderer {
+public:
+  // Collects the instances from the registry, doesn't touch GL so it can run on the simulation thread
+  static void collect(const Registry& registry, const WorldPosition& camera, std::vector<EntityInstance>& out);
+
+  // Uploads the instances and draws them with 'shader' (entity.vs/entity.fs)
+  void draw(const std::vector<EntityInstance>& entities, Shader& shader);
+
+  void remove();
+
+private:
+  InstancedRenderer instanced;
+};
+
+#endif
@@ -0,0 +1,174 @@
+#include <math.h>
+#include <stddef.h>
+
+#include "instanced_renderer.h"
+
+// Box corners of every face (0 picks the minimum, 1 the maximum on that axis), counter-clockwise from outside
+static const int boxCorners[FACE_COUNT][4][3] = {
+  { { 1, 0, 1 }, { 1, 0, 0 }, { 1, 1, 0 }, { 1, 1, 1 } },  // FACE_POS_X
+  { { 0, 0, 0 }, { 0, 0, 1 }, { 0, 1, 1 }, { 0, 1, 0 } },  // FACE_NEG_X
+  { { 0, 1, 1 }, { 1, 1, 1 }, { 1, 1, 0 }, { 0, 1, 0 } },  // FACE_POS_Y
+  { { 0, 0, 0 }, { 1, 0, 0 }, { 1, 0, 1 }, { 0, 0, 1 } },  // FACE_NEG_Y
+  { { 0, 0, 1 }, { 1, 0, 1 }, { 1, 1, 1 }, { 0, 1, 1 } },  // FACE_POS_Z
+  { { 1, 0, 0 }, { 0, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 } },  // FACE_NEG_Z
+};
+
+// Same directional shading as the terrain
+static const float boxShade[FACE_COUNT] = { 0.8f, 0.8f, 1.0f, 0.5f, 0.6f, 0.6f };
+
+static const float boxUV[4][2] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+
+static void addBox(std::vector<ModelVertex>& vertices, std::vector<GLuint>& indices, glm::vec3 min, glm::vec3 max) {
+  for (int f = 0; f < FACE_COUNT; f++) {
+    GLuint base = (GLuint)vertices.size();
+
+    for (int c = 0; c < 4; c++) {
+      ModelVertex vertex;
+      for (int axis = 0; axis < 3; axis++) {
+        vertex.position[axis] = boxCorners[f][c][axis] ? max[axis] : min[axis];
+      }
+      vertex.shade = boxShade[f];
+      vertex.texture[0] = boxUV[c][0];
+      vertex.texture[1] = boxUV[c][1];
+      vertex.slot = f == FACE_POS_Y ? 0.0f : (f == FACE_NEG_Y ? 2.0f : 1.0f);
+      vertices.push_back(vertex);
+    }
+
+    GLuint quad[6] = { base, base + 1, base + 2, base, base + 2, base + 3 };
+    indices.insert(indices.end(), quad, quad + 6);
+  }
+}
+
+InstancedRenderer::InstancedRenderer() {
+  std::vector<ModelVertex> vertices;
+  std::vector<GLuint> indices;
+
+  // Unit cube standing on the origin
+  addBox(vertices, indices, glm::vec3(-0.5f, 0.0f, -0.5f), glm::vec3(0.5f, 1.0f, 0.5f));
+  upload(models[MODEL_CUBE], vertices, indices);
+
+  // Body with a head sticking out towards +Z, the direction a yaw of 0 faces
+  vertices.clear();
+  indices.clear();
+  addBox(vertices, indices, glm::vec3(-0.4f, 0.0f, -0.5f), glm::vec3(0.4f, 0.6f, 0.4f));
+  addBox(vertices, indices, glm::vec3(-0.25f, 0.45f, 0.3f), glm::vec3(0.25f, 0.95f, 0.7f));
+  upload(models[MODEL_MOB], vertices, indices);
+}
+
+void InstancedRenderer::upload(Model& model, std::vector<ModelVertex>& vertices, std::vector<GLuint>& indices) {
+  model.vao = new VAO();
+  model.vbo = new VBO(vertices.data(), vertices.size() * sizeof(ModelVertex));
+  model.ebo = new EBO(indices.data(), indices.size() * sizeof(GLuint));
+  model.instanceBuffer = new VBO(NULL, 0);
+  model.indexCount = (GLsizei)indices.size();
+
+  model.vao->bind();
+  model.ebo->bind();
+
+  model.vao->linkAttrib(*model.vbo, 0, 3, GL_FLOAT, sizeof(ModelVertex), (void*)offsetof(ModelVertex, position));
+  model.vao->linkAttrib(*model.vbo, 1, 1, GL_FLOAT, sizeof(ModelVertex), (void*)offsetof(ModelVertex, shade));
+  model.vao->linkAttrib(*model.vbo, 2, 2, GL_FLOAT, sizeof(ModelVertex), (void*)offsetof(ModelVertex, texture));
+  model.vao->linkAttrib(*model.vbo, 3, 1, GL_FLOAT, sizeof(ModelVertex), (void*)offsetof(ModelVertex, slot));
+
+  // The instance attributes advance once per instance
+  for (int row = 0; row < 3; row++) {
+    model.vao->linkAttrib(*model.instanceBuffer, 4 + row, 4, GL_FLOAT, sizeof(ModelInstance), (void*)(offsetof(ModelInstance, transform) + row * 4 * sizeof(GLfloat)), 1);
+  }
+  model.vao->linkAttrib(*model.instanceBuffer, 7, 4, GL_FLOAT, sizeof(ModelInstance), (void*)offsetof(ModelInstance, tint), 1);
+  model.vao->linkAttrib(*model.instanceBuffer, 8, 4, GL_FLOAT, sizeof(ModelInstance), (void*)offsetof(ModelInstance, tiles), 1);
+
+  // Unbind all to prevent accidentally modifying them
+  model.vao->unbind();
+  model.vbo->unbind();
+  model.ebo->unbind();
+}
+
+void InstancedRenderer::begin() {
+  for (int i = 0; i < MODEL_COUNT; i++) {
+    models[i].instances.clear();
+  }
+}
+
+void InstancedRenderer::add(ModelID model, const ModelInstance& instance) {
+  models[model].instances.push_back(instance);
+}
+
+size_t InstancedRenderer::instanceCount() const {
+  size_t count = 0;
+  for (int i = 0; i < MODEL_COUNT; i++) {
+    count += models[i].instances.size();
+  }
+
+  return count;
+}
+
+void InstancedRenderer::draw(Shader& shader) {
+  shader.activate();
+
+  for (int i = 0; i < MODEL_COUNT; i++) {
+    Model& model = models[i];
+    if (model.instances.empty()) {
+      continue;
+    }
+
+    model.instanceBuffer->update(model.instances.data(), model.instances.size() * sizeof(ModelInstance));
+    model.instanceBuffer->unbind();
+
+    model.vao->bind();
+    glDrawElementsInstanced(GL_TRIANGLES, model.indexCount, GL_UNSIGNED_INT, 0, (GLsizei)model.instances.size());
+  }
+
+  glBindVertexArray(0);
+}
+
+void InstancedRenderer::remove() {
+  for (int i = 0; i < MODEL_COUNT; i++) {
+    Model& model = models[i];
+    model.vao->remove();
+    model.vbo->remove();
+    model.ebo->remove();
+    model.instanceBuffer->remove();
+
+    delete model.vao;
+    delete model.vbo;
+    delete model.ebo;
+    delete model.instanceBuffer;
+    model.instances.clear();
+  }
+}
+
+void InstancedRenderer::setTransform(ModelInstance& instance, glm::vec3 position, float yaw, float scale) {
+  float s = sinf(yaw) * scale;
+  float c = cosf(yaw) * scale;
+
+  // Rotation about Y that turns +Z towards (sin(yaw), 0, cos(yaw)), matching the direction entities walk in
+  GLfloat rows[3][4] = {
+    {  c,    0.0f,  s,    position.x },
+    {  0.0f, scale, 0.0f, position.y },
+    { -s,    0.0f,  c,    position.z },
+  };
+
+  for (int row = 0; row < 3; row++) {
+    for (int column = 0; column < 4; column++) {
+      instance.transform[row][column] = rows[row][column];
+    }
+  }
+}
+
+void InstancedRenderer::setAppearance(ModelInstance& instance, glm::vec3 tint, BlockID block) {
+  instance.tint[0] = tint.x;
+  instance.tint[1] = tint.y;
+  instance.tint[2] = tint.z;
+  instance.tint[3] = 1.0f;
+
+  if (block == BLOCK_AIR) {
+    instance.tiles[0] = instance.tiles[1] = instance.tiles[2] = -1.0f;
+  }
+  else {
+    const BlockInfo& info = getBlockInfo(block);
+    instance.tiles[0] = info.textureTop;
+    instance.tiles[1] = info.textureSide;
+    instance.tiles[2] = info.textureBottom;
+  }
+  instance.tiles[3] = 0.0f;
+}
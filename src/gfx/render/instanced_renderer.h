@@ -0,0 +1,73 @@
+/* instanced_renderer.h */
+
+#ifndef INSTANCED_RENDERER_HEADER_H
+#define INSTANCED_RENDERER_HEADER_H
+
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "../../entity/components.h"
+#include "../shader/shader.h"
+#include "../shader/VAO.h"
+#include "../shader/VBO.h"
+#include "../shader/EBO.h"
+
+struct ModelVertex {
+  GLfloat position[3];
+  // Directional shading of the face
+  GLfloat shade;
+  // Position within the atlas tile
+  GLfloat texture[2];
+  // Which of the instance tiles the face uses: 0 top, 1 side, 2 bottom
+  GLfloat slot;
+};
+
+// Per instance attributes, 80 bytes
+struct ModelInstance {
+  // Rows of the affine model transform
+  GLfloat transform[3][4];
+  GLfloat tint[4];
+  // Atlas tiles for the top, side and bottom faces, negative for untextured
+  GLfloat tiles[4];
+};
+
+// Keeps one mesh per model and a per instance attribute buffer next to it. Instances are collected every frame and
+// each model is submitted with a single glDrawElementsInstanced call, regardless of how many instances it has.
+class InstancedRenderer {
+public:
+  // Constructor, builds and uploads the model meshes
+  InstancedRenderer();
+
+  // Drops the instances of the previous frame
+  void begin();
+  void add(ModelID model, const ModelInstance& instance);
+
+  // Uploads the instances and draws every model, 'shader' is entity.vs/entity.fs
+  void draw(Shader& shader);
+
+  size_t instanceCount() const;
+
+  void remove();
+
+  // Fills in a transform placing the model at 'position', turned by 'yaw' around Y and scaled uniformly
+  static void setTransform(ModelInstance& instance, glm::vec3 position, float yaw, float scale);
+  // Fills in the tint and the tiles of a block, BLOCK_AIR leaves the model untextured
+  static void setAppearance(ModelInstance& instance, glm::vec3 tint, BlockID block);
+
+private:
+  struct Model {
+    VAO* vao;
+    VBO* vbo;
+    EBO* ebo;
+    VBO* instanceBuffer;
+    GLsizei indexCount;
+    std::vector<ModelInstance> instances;
+  };
+
+  Model models[MODEL_COUNT];
+
+  void upload(Model& model, std::vector<ModelVertex>& vertices, std::vector<GLuint>& indices);
+};
+
+#endif
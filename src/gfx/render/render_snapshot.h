@@ -0,0 +1,67 @@
+/* render_snapshot.h */
+
+#ifndef RENDER_SNAPSHOT_HEADER_H
+#define RENDER_SNAPSHOT_HEADER_H
+
+#include <stdint.h>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "../../world/chunk.h"
+#include "../../world/world_position.h"
+#include "../../util/mpsc_queue.h"
+#include "../mesh/mesher.h"
+#include "entity_renderer.h"
+
+// A section the culling found visible
+struct SectionDraw {
+  ChunkPos chunk;
+  int section;
+};
+
+// Everything the GL thread needs to draw one simulation tick, produced by the simulation thread and never changed once
+// published. Vectors are cleared and refilled rather than reallocated, the snapshots are reused (see TripleBuffer).
+struct RenderSnapshot {
+  // Simulation tick the snapshot was taken at, 0 for none yet
+  uint64_t tick;
+
+  WorldPosition camera;
+  glm::mat4 cameraMatrix;
+
+  // Meshed sections that passed the visibility flood fill, front to back, and the distant terrain to draw
+  std::vector<SectionDraw> sections;
+  std::vector<ChunkPos> lods;
+  // Sections holding a mesh that the culling skipped
+  size_t culledSections;
+
+  std::vector<EntityInstance> entities;
+
+  RenderSnapshot() : tick(0), cameraMatrix(1.0f), culledSections(0) {}
+};
+
+enum MeshUpdateType : uint8_t {
+  // Replace one section's mesh, an empty mesh removes it
+  MESH_SECTION,
+  // Free every section mesh of the chunk
+  MESH_REMOVE_CHUNK,
+  // Replace the chunk's distant terrain mesh
+  MESH_LOD,
+  MESH_REMOVE_LOD
+};
+
+// A change to the GPU meshes. Unlike snapshots, which may be skipped, every update reaches the GL thread, in order.
+struct MeshUpdate : MpscNode {
+  // Simulation tick that sent it, the first snapshot that expects it applied
+  uint64_t tick;
+  MeshUpdateType type;
+  ChunkPos pos;
+  int section;
+  MeshData mesh;
+};
+
+// Origin of a section relative to the origin of the camera chunk, the difference is taken in integers first
+static inline glm::vec3 sectionOrigin(const WorldPosition& camera, int x, int y, int z) {
+  return glm::vec3((float)((x - camera.chunkX) * SECTION_SIZE), (float)(y * SECTION_SIZE), (float)((z - camera.chunkZ) * SECTION_SIZE));
+}
+
+#endif
@@ -0,0 +1,471 @@
+#include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#include "terrain_view.h"
+
+// Meshing is the expensive part of streaming and runs on the job system, the simulation thread only collects the
+// results. Both the requests and the meshes sent are capped per tick to keep the GL thread's uploads even.
+#define MAX_MESHES_PER_FRAME 8
+#define MAX_UPLOADS_PER_FRAME 8
+#define MAX_LOD_MESHES_PER_FRAME 8
+
+TerrainView::TerrainView(World& world, JobSystem& jobs) : world(world), jobs(jobs), mesher(jobs) {
+  offsetsDistance = -1;
+  center = { 0, 0 };
+  viewDistance = 0;
+  frame = 0;
+  lodOffsetsDistance = -1;
+  lodBytes = 0;
+  tick = 0;
+}
+
+TerrainView::~TerrainView() {
+  MeshUpdate* update = updates.popAll();
+  while (update) {
+    MeshUpdate* next = MpscQueue<MeshUpdate>::next(update);
+    delete update;
+    update = next;
+  }
+}
+
+MeshUpdate* TerrainView::createUpdate(MeshUpdateType type, ChunkPos pos, int section) {
+  MeshUpdate* update = new MeshUpdate();
+  update->tick = tick;
+  update->type = type;
+  update->pos = pos;
+  update->section = section;
+  return update;
+}
+
+// True when the chunk and the eight around it are loaded
+static bool neighboursLoaded(const World& world, ChunkPos pos) {
+  for (int dx = -1; dx <= 1; dx++) {
+    for (int dz = -1; dz <= 1; dz++) {
+      if (!world.getChunk({ pos.x + dx, pos.z + dz })) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+void TerrainView::update(ChunkPos center, int viewDistance) {
+  this->center = center;
+  this->viewDistance = viewDistance;
+
+  if (offsetsDistance != viewDistance) {
+    offsets.clear();
+    for (int x = -viewDistance; x <= viewDistance; x++) {
+      for (int z = -viewDistance; z <= viewDistance; z++) {
+        offsets.push_back({ x, z });
+      }
+    }
+    sort(offsets.begin(), offsets.end(), [](const ChunkPos& a, const ChunkPos& b) {
+      return a.x * a.x + a.z * a.z < b.x * b.x + b.z * b.z;
+    });
+    offsetsDistance = viewDistance;
+  }
+
+  // Edits first, they are what the player is looking at
+  rebuildDirty();
+  sendMeshes();
+
+  int requests = 0;
+  for (size_t i = 0; i < offsets.size() && requests < MAX_MESHES_PER_FRAME; i++) {
+    ChunkPos pos = { center.x + offsets[i].x, center.z + offsets[i].z };
+    if (meshes.find(pos) != meshes.end() || requested.find(pos) != requested.end() || !neighboursLoaded(world, pos)) {
+      continue;
+    }
+    if (!mesher.request(world, pos)) {
+      break;
+    }
+    requested[pos] = false;
+    requests++;
+  }
+}
+
+void TerrainView::sendMeshes() {
+  MeshResult* result;
+  for (int uploads = 0; uploads < MAX_UPLOADS_PER_FRAME && (result = mesher.poll()); ) {
+    ChunkPos pos = result->pos;
+    auto it = requested.find(pos);
+    bool outdated = it == requested.end() || it->second;
+    if (it != requested.end()) {
+      requested.erase(it);
+    }
+
+    // Outdated meshes are requested again, meshes of chunks that left the view or were evicted meanwhile dropped
+    bool inView = abs(pos.x - center.x) <= viewDistance && abs(pos.z - center.z) <= viewDistance;
+    if (!outdated && inView && world.getChunk(pos) && meshes.find(pos) == meshes.end()) {
+      ChunkMeshes entry;
+      for (int i = 0; i < CHUNK_SECTIONS; i++) {
+        entry.connectivity[i] = result->connectivity[i];
+        entry.bytes[i] = result->sections[i].bytes();
+        if (!result->sections[i].indices.empty()) {
+          MeshUpdate* update = createUpdate(MESH_SECTION, pos, i);
+          update->mesh = std::move(result->sections[i]);
+          updates.push(update);
+        }
+      }
+      meshes.insert({ pos, entry });
+      uploads++;
+    }
+
+    delete result;
+  }
+}
+
+size_t TerrainView::buildChunk(ChunkPos pos) {
+  Chunk* chunk = world.getChunk(pos);
+  if (!chunk) {
+    removeChunk(pos);
+    return 0;
+  }
+
+  auto it = meshes.find(pos);
+  if (it == meshes.end()) {
+    ChunkMeshes entry;
+    for (int i = 0; i < CHUNK_SECTIONS; i++) {
+      entry.bytes[i] = 0;
+    }
+    it = meshes.insert({ pos, entry }).first;
+  }
+
+  // The whole chunk is rebuilt, pending edits are included
+  dirty.erase(pos);
+
+  for (int i = 0; i < CHUNK_SECTIONS; i++) {
+    buildSection(*chunk, it->second, i);
+  }
+
+  return chunkBytes(it->second);
+}
+
+void TerrainView::buildSection(const Chunk& chunk, ChunkMeshes& entry, int section) {
+  entry.connectivity[section] = computeConnectivity(*chunk.sections[section].share());
+
+  // An empty mesh replaces the old one as well, it removes it
+  MeshUpdate* update = createUpdate(MESH_SECTION, chunk.pos, section);
+  Mesher::meshSection(world, chunk, section, update->mesh);
+  entry.bytes[section] = update->mesh.bytes();
+  updates.push(update);
+}
+
+size_t TerrainView::chunkBytes(const ChunkMeshes& entry) {
+  size_t bytes = 0;
+  for (int i = 0; i < CHUNK_SECTIONS; i++) {
+    bytes += entry.bytes[i];
+  }
+
+  return bytes;
+}
+
+// -1, 0 or 1 when a local coordinate lies on the low border, inside or on the high border of its section
+static inline int borderSide(int local) {
+  return local == 0 ? -1 : (local == SECTION_SIZE - 1 ? 1 : 0);
+}
+
+void TerrainView::markDirty(ChunkPos pos, int section) {
+  auto pending = requested.find(pos);
+  if (pending != requested.end()) {
+    pending->second = true;
+  }
+  if (section >= 0 && section < CHUNK_SECTIONS && meshes.find(pos) != meshes.end()) {
+    dirty[pos] |= 1u << section;
+  }
+}
+
+void TerrainView::surfaceChanged(ChunkPos pos) {
+  LodMesher::sample(world, pos, editedSurfaces[pos]);
+  auto lod = lods.find(pos);
+  if (lod != lods.end()) {
+    lod->second.dirty = true;
+  }
+}
+
+void TerrainView::blockChanged(int x, int y, int z) {
+  int sectionY = y >> SECTION_SHIFT;
+  int sideX = borderSide(blockToLocal(x));
+  int sideY = borderSide(y & SECTION_MASK);
+  int sideZ = borderSide(blockToLocal(z));
+
+  // Every section sharing a face, edge or corner with the block, the edges and corners matter for ambient occlusion
+  for (int dx = (sideX < 0 ? -1 : 0); dx <= (sideX > 0 ? 1 : 0); dx++) {
+    for (int dz = (sideZ < 0 ? -1 : 0); dz <= (sideZ > 0 ? 1 : 0); dz++) {
+      ChunkPos pos = { blockToChunk(x) + dx, blockToChunk(z) + dz };
+      for (int dy = (sideY < 0 ? -1 : 0); dy <= (sideY > 0 ? 1 : 0); dy++) {
+        markDirty(pos, sectionY + dy);
+      }
+    }
+  }
+
+  // The edit shows in the distant terrain mesh too, once it's rebuilt and after the chunk was unloaded
+  surfaceChanged({ blockToChunk(x), blockToChunk(z) });
+}
+
+void TerrainView::sectionChanged(ChunkPos pos, int section) {
+  // Any block on the section's borders may have changed, so every section touching it is affected
+  for (int dx = -1; dx <= 1; dx++) {
+    for (int dz = -1; dz <= 1; dz++) {
+      for (int dy = -1; dy <= 1; dy++) {
+        markDirty({ pos.x + dx, pos.z + dz }, section + dy);
+      }
+    }
+  }
+
+  // Sections of chunks that aren't meshed yet mostly arrive as part of loading the chunk, not as an edit
+  if (meshes.find(pos) != meshes.end()) {
+    surfaceChanged(pos);
+  }
+}
+
+void TerrainView::chunkChanged(ChunkPos pos) {
+  for (int i = 0; i < CHUNK_SECTIONS; i++) {
+    markDirty(pos, i);
+  }
+}
+
+void TerrainView::rebuildDirty() {
+  for (auto& entry : dirty) {
+    ChunkPos pos = entry.first;
+    auto it = meshes.find(pos);
+    Chunk* chunk = world.getChunk(pos);
+    if (it == meshes.end() || !chunk) {
+      continue;
+    }
+
+    for (int i = 0; i < CHUNK_SECTIONS; i++) {
+      if (entry.second & (1u << i)) {
+        buildSection(*chunk, it->second, i);
+      }
+    }
+  }
+
+  dirty.clear();
+}
+
+void TerrainView::removeChunk(ChunkPos pos) {
+  // A mesh still being built belongs to the old chunk, should it be loaded again
+  auto pending = requested.find(pos);
+  if (pending != requested.end()) {
+    pending->second = true;
+  }
+
+  auto it = meshes.find(pos);
+  if (it == meshes.end()) {
+    return;
+  }
+
+  updates.push(createUpdate(MESH_REMOVE_CHUNK, pos, 0));
+  meshes.erase(it);
+  dirty.erase(pos);
+}
+
+int TerrainView::lodScale(int distance) const {
+  if (distance <= viewDistance) {
+    return 0;
+  }
+
+  int scale = 2;
+  int limit = viewDistance * 2;
+  while (distance > limit && scale < SECTION_SIZE) {
+    scale *= 2;
+    limit *= 2;
+  }
+
+  return scale;
+}
+
+const ChunkHeightmap& TerrainView::surface(ChunkPos pos) {
+  auto edited = editedSurfaces.find(pos);
+  if (edited == editedSurfaces.end()) {
+    LodMesher::sample(world, pos, heightmap);
+    return heightmap;
+  }
+
+  if (world.getChunk(pos)) {
+    LodMesher::sample(world, pos, edited->second);
+  }
+  return edited->second;
+}
+
+void TerrainView::removeLod(ChunkPos pos) {
+  auto it = lods.find(pos);
+  if (it == lods.end()) {
+    return;
+  }
+
+  lodBytes -= it->second.bytes;
+  updates.push(createUpdate(MESH_REMOVE_LOD, pos, 0));
+  lods.erase(it);
+}
+
+void TerrainView::updateLod(ChunkPos center, int lodDistance) {
+  if (lodOffsetsDistance != lodDistance) {
+    lodOffsets.clear();
+    for (int x = -lodDistance; x <= lodDistance; x++) {
+      for (int z = -lodDistance; z <= lodDistance; z++) {
+        lodOffsets.push_back({ x, z });
+      }
+    }
+    sort(lodOffsets.begin(), lodOffsets.end(), [](const ChunkPos& a, const ChunkPos& b) {
+      return a.x * a.x + a.z * a.z < b.x * b.x + b.z * b.z;
+    });
+    lodOffsetsDistance = lodDistance;
+  }
+
+  // Drop meshes that left the range or that the full detail mesh has replaced
+  for (auto it = lods.begin(); it != lods.end();) {
+    int distance = std::max(abs(it->first.x - center.x), abs(it->first.z - center.z));
+    bool replaced = distance <= viewDistance && meshes.find(it->first) != meshes.end();
+    if (distance > lodDistance + LOD_HYSTERESIS || replaced) {
+      ChunkPos pos = it->first;
+      ++it;
+      removeLod(pos);
+    }
+    else {
+      ++it;
+    }
+  }
+
+  int built = 0;
+  for (size_t i = 0; i < lodOffsets.size() && built < MAX_LOD_MESHES_PER_FRAME; i++) {
+    ChunkPos pos = { center.x + lodOffsets[i].x, center.z + lodOffsets[i].z };
+    int distance = std::max(abs(lodOffsets[i].x), abs(lodOffsets[i].z));
+
+    auto it = lods.find(pos);
+    int scale = lodScale(distance);
+    if (scale == 0) {
+      // Only needed as a stand in until the full detail mesh is built
+      if (meshes.find(pos) != meshes.end()) {
+        continue;
+      }
+      scale = it != lods.end() ? it->second.scale : 2;
+    }
+    else if (it != lods.end() && it->second.scale != scale) {
+      // Hysteresis: keep the current level until the chunk is well past the threshold
+      int current = it->second.scale;
+      if ((scale > current && lodScale(std::max(distance - LOD_HYSTERESIS, 0)) <= current)
+        || (scale < current && lodScale(distance + LOD_HYSTERESIS) >= current)) {
+        scale = current;
+      }
+    }
+    // Edited chunks are rebuilt at their current level
+    if (it != lods.end() && it->second.scale == scale && !it->second.dirty) {
+      continue;
+    }
+
+    // Replaces the current mesh on the GL thread, no removal needed in between
+    MeshUpdate* update = createUpdate(MESH_LOD, pos, 0);
+    LodMesher::meshChunk(surface(pos), scale, update->mesh);
+
+    if (it != lods.end()) {
+      lodBytes -= it->second.bytes;
+    }
+    LodMesh lod = { scale, update->mesh.bytes(), false };
+    lodBytes += lod.bytes;
+    lods[pos] = lod;
+    updates.push(update);
+    built++;
+  }
+}
+
+// Section offsets of the faces, in BlockFace order
+static const int faceOffsets[FACE_COUNT][3] = {
+  { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+};
+
+void TerrainView::cull(const glm::mat4& cameraMatrix, const WorldPosition& camera, RenderSnapshot& snapshot) {
+  snapshot.sections.clear();
+  snapshot.lods.clear();
+  frustum.update(cameraMatrix);
+
+  int width = 2 * viewDistance + 1;
+  size_t sectionCount = (size_t)width * width * CHUNK_SECTIONS;
+  if (visited.size() != sectionCount) {
+    visited.assign(sectionCount, 0);
+    frame = 0;
+  }
+  frame++;
+
+  size_t meshedSections = 0;
+  for (auto& entry : meshes) {
+    if (abs(entry.first.x - center.x) <= viewDistance && abs(entry.first.z - center.z) <= viewDistance) {
+      for (int i = 0; i < CHUNK_SECTIONS; i++) {
+        meshedSections += entry.second.bytes[i] != 0;
+      }
+    }
+  }
+
+  // Start in the camera section, clamped into the world when flying above or below it
+  int startY = (int)camera.blockY() >> SECTION_SHIFT;
+  startY = startY < 0 ? 0 : (startY >= CHUNK_SECTIONS ? CHUNK_SECTIONS - 1 : startY);
+  VisitNode start = { (int)camera.chunkX, startY, (int)camera.chunkZ, FACE_COUNT, 0 };
+
+  queue.clear();
+  queue.push_back(start);
+  visited[((start.x - center.x + viewDistance) * width + (start.z - center.z + viewDistance)) * CHUNK_SECTIONS + start.y] = frame;
+
+  // Breadth first, so sections come out roughly front to back which helps early depth rejection
+  for (size_t head = 0; head < queue.size(); head++) {
+    VisitNode node = queue[head];
+
+    // Chunks not meshed yet have nothing to draw, but may well be open, so the fill passes through them. Only real
+    // connectivity data stops it, otherwise an unmeshed camera chunk (at startup, after a teleport) would hide everything.
+    FaceConnectivity connectivity = CONNECTIVITY_ALL;
+    auto it = meshes.find({ node.x, node.z });
+    if (it != meshes.end()) {
+      if (it->second.bytes[node.y]) {
+        SectionDraw draw = { { node.x, node.z }, node.y };
+        snapshot.sections.push_back(draw);
+      }
+      connectivity = it->second.connectivity[node.y];
+    }
+
+    for (int f = 0; f < FACE_COUNT; f++) {
+      if (node.directions & (1 << (f ^ 1))) {
+        continue;
+      }
+      if (node.from != FACE_COUNT && !facesConnected(connectivity, node.from, f)) {
+        continue;
+      }
+
+      VisitNode next = { node.x + faceOffsets[f][0], node.y + faceOffsets[f][1], node.z + faceOffsets[f][2], f ^ 1, node.directions | (1 << f) };
+      if (next.y < 0 || next.y >= CHUNK_SECTIONS || abs(next.x - center.x) > viewDistance || abs(next.z - center.z) > viewDistance) {
+        continue;
+      }
+
+      uint32_t& mark = visited[((next.x - center.x + viewDistance) * width + (next.z - center.z + viewDistance)) * CHUNK_SECTIONS + next.y];
+      if (mark == frame) {
+        continue;
+      }
+
+      glm::vec3 min = sectionOrigin(camera, next.x, next.y, next.z);
+      if (!frustum.intersectsBox(min, min + glm::vec3((float)SECTION_SIZE))) {
+        continue;
+      }
+
+      mark = frame;
+      queue.push_back(next);
+    }
+  }
+
+  snapshot.culledSections = meshedSections - snapshot.sections.size();
+
+  // Distant terrain, and stand ins for chunks whose full detail mesh isn't built yet
+  for (auto& entry : lods) {
+    ChunkPos pos = entry.first;
+    bool inView = abs(pos.x - center.x) <= viewDistance && abs(pos.z - center.z) <= viewDistance;
+    if (inView && meshes.find(pos) != meshes.end()) {
+      continue;
+    }
+
+    glm::vec3 min = sectionOrigin(camera, pos.x, 0, pos.z);
+    glm::vec3 max = min + glm::vec3((float)SECTION_SIZE, (float)CHUNK_HEIGHT, (float)SECTION_SIZE);
+    if (frustum.intersectsBox(min, max)) {
+      snapshot.lods.push_back(pos);
+    }
+  }
+}
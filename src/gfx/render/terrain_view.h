@@ -0,0 +1,154 @@
+/* terrain_view.h */
+
+#ifndef TERRAIN_VIEW_HEADER_H
+#define TERRAIN_VIEW_HEADER_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "../../world/world.h"
+#include "../../world/visibility.h"
+#include "../../world/world_position.h"
+#include "../camera/frustum.h"
+#include "../mesh/lod_mesher.h"
+#include "../mesh/mesh_worker.h"
+#include "render_snapshot.h"
+
+// Simulation side of the terrain rendering: decides which of the loaded chunks are meshed, builds their meshes and culls
+// them, without a single GL call. Which chunks are loaded is up to the world's owner, the client's world is filled by
+// the chunks the server streams (see chunkChanged(), sectionChanged() and removeChunk()). The meshes go to the GL thread as MeshUpdates (see takeUpdates() and
+// WorldRenderer::apply()), the culling result goes into the render snapshot. Only the thread owning the world may call
+// anything but takeUpdates().
+class TerrainView {
+public:
+  // Constructor & destructor, chunk generation and meshing run on 'jobs'. Updates never taken are dropped.
+  TerrainView(World& world, JobSystem& jobs);
+  ~TerrainView();
+
+  // Meshes the loaded chunks around 'center': dirty sections are rebuilt, missing meshes of chunks within the view
+  // distance are requested from the mesh worker closest first and finished ones are sent with a per tick limit. A chunk
+  // is only meshed once its eight neighbours are loaded as well, so its borders come out right; the world has to hold
+  // one ring more than the view distance.
+  void update(ChunkPos center, int viewDistance);
+
+  // Meshes the ring between the view distance and 'lodDistance' from downsampled heightmaps, without loading the
+  // chunks. Detail halves every time the distance doubles (2x, 4x, 8x, 16x cells) and a chunk only changes level once
+  // it is LOD_HYSTERESIS chunks past the threshold, so moving back and forth across it doesn't rebuild meshes. Inside
+  // the view distance the LOD mesh stays until the full detail mesh replaces it. Meshes of chunks edited since they were
+  // built (see blockChanged()) are rebuilt at their level. Call after update().
+  void updateLod(ChunkPos center, int lodDistance);
+
+  // (Re)builds the meshes of every section of a chunk right away, returns the GPU memory they will use
+  size_t buildChunk(ChunkPos pos);
+  // Drops the meshes of a chunk, call when the chunk is unloaded
+  void removeChunk(ChunkPos pos);
+
+  // A loaded chunk was replaced as a whole, its meshes are rebuilt
+  void chunkChanged(ChunkPos pos);
+  // Every block of a section may have changed, the section is remeshed together with the sections around it
+  void sectionChanged(ChunkPos pos, int section);
+
+  // Marks the section holding an edited block dirty, and the neighbouring sections when the block lies on a section
+  // border since their faces and ambient occlusion depend on the edited block too. Several edits to the same section
+  // before the next rebuild only cost one remesh.
+  void blockChanged(int x, int y, int z);
+
+  // Remeshes the dirty sections. Edits aren't subject to the per tick meshing limit, so calling this after handling
+  // input and before cull() makes an edit visible in the same tick's snapshot. update() calls it as well.
+  void rebuildDirty();
+
+  // Fills in the sections and distant terrain of the snapshot that can be visible from the camera, front to back.
+  // Sections are found with a flood fill from the camera section that only crosses sections through faces connected by
+  // open blocks, never turns back towards the camera and skips sections outside the frustum, so terrain hidden behind
+  // solid ground and cave walls is never submitted. Chunks not meshed yet count as open.
+  void cull(const glm::mat4& cameraMatrix, const WorldPosition& camera, RenderSnapshot& snapshot);
+
+  // Simulation tick the updates sent from now on are stamped with, call before anything else in the tick
+  void beginTick(uint64_t tick) { this->tick = tick; }
+
+  // Any thread (the GL thread): the mesh changes sent so far, oldest first and linked through MpscNode::next. The
+  // caller deletes them.
+  MeshUpdate* takeUpdates() { return updates.popAll(); }
+
+  size_t getLodBytes() const { return lodBytes; }
+  size_t getMeshedChunks() const { return meshes.size(); }
+
+private:
+  // What the GL thread is (or soon will be) holding for a chunk
+  struct ChunkMeshes {
+    FaceConnectivity connectivity[CHUNK_SECTIONS];
+    size_t bytes[CHUNK_SECTIONS];
+  };
+
+  struct LodMesh {
+    int scale;
+    size_t bytes;
+    // A block of the chunk changed since the mesh was built
+    bool dirty;
+  };
+
+  struct VisitNode {
+    int x, y, z;
+    // Face of the section the fill came in through, FACE_COUNT for the camera section
+    int from;
+    // Directions travelled so far, the fill never goes the opposite way
+    int directions;
+  };
+
+  World& world;
+  JobSystem& jobs;
+  MpscQueue<MeshUpdate> updates;
+  uint64_t tick;
+
+  // Bit per section of the chunk that needs a new mesh
+  std::unordered_map<ChunkPos, uint32_t, ChunkPosHash> dirty;
+
+  // Chunks handed to the mesh worker, true once an edit made the requested mesh outdated
+  MeshWorker mesher;
+  std::unordered_map<ChunkPos, bool, ChunkPosHash> requested;
+
+  // Sends the meshes the worker finished, up to the per tick limit
+  void sendMeshes();
+
+  // Rebuilds the mesh and connectivity of one section and sends the mesh
+  void buildSection(const Chunk& chunk, ChunkMeshes& entry, int section);
+  static size_t chunkBytes(const ChunkMeshes& entry);
+  MeshUpdate* createUpdate(MeshUpdateType type, ChunkPos pos, int section);
+
+  // Chunk offsets within the view distance, sorted by distance
+  std::vector<ChunkPos> offsets;
+  int offsetsDistance;
+
+  ChunkPos center;
+  int viewDistance;
+
+  std::unordered_map<ChunkPos, ChunkMeshes, ChunkPosHash> meshes;
+
+  std::unordered_map<ChunkPos, LodMesh, ChunkPosHash> lods;
+  std::vector<ChunkPos> lodOffsets;
+  int lodOffsetsDistance;
+  ChunkHeightmap heightmap;
+  size_t lodBytes;
+  // Surface of every chunk edited this session as last seen loaded. Unloaded chunks are sampled from the generator,
+  // which knows nothing of the edits.
+  std::unordered_map<ChunkPos, ChunkHeightmap, ChunkPosHash> editedSurfaces;
+
+  // Cell size for a chunk 'distance' chunks away, 0 for full detail
+  int lodScale(int distance) const;
+  // Surface for the distant terrain mesh of a chunk, valid until the next call
+  const ChunkHeightmap& surface(ChunkPos pos);
+  void removeLod(ChunkPos pos);
+  // Resamples the edited surface of a chunk and marks its distant terrain mesh for a rebuild
+  void surfaceChanged(ChunkPos pos);
+  // Marks a section of a meshed chunk dirty and makes a pending mesh request of the chunk outdated, out of range
+  // sections are ignored
+  void markDirty(ChunkPos pos, int section);
+
+  Frustum frustum;
+  std::vector<VisitNode> queue;
+  // Tick stamp per section within the view distance, saves clearing a visited set every tick
+  std::vector<uint32_t> visited;
+  uint32_t frame;
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include "world_renderer.h"
+
+WorldRenderer::~WorldRenderer() {
+  clear();
+}
+
+void WorldRenderer::replace(ChunkMesh*& mesh, MeshData& data) {
+  if (mesh) {
+    mesh->remove();
+    delete mesh;
+    mesh = NULL;
+  }
+
+  if (!data.indices.empty()) {
+    mesh = new ChunkMesh(data);
+  }
+}
+
+void WorldRenderer::apply(MeshUpdate* updates, uint64_t tick) {
+  while (updates) {
+    pending.push_back(updates);
+    updates = MpscQueue<MeshUpdate>::next(updates);
+  }
+
+  while (!pending.empty() && pending.front()->tick <= tick) {
+    MeshUpdate* update = pending.front();
+    pending.pop_front();
+
+    switch (update->type) {
+    case MESH_SECTION: {
+      auto it = meshes.find(update->pos);
+      if (it == meshes.end()) {
+        ChunkMeshes entry;
+        for (int i = 0; i < CHUNK_SECTIONS; i++) {
+          entry.sections[i] = NULL;
+        }
+        it = meshes.insert({ update->pos, entry }).first;
+      }
+      replace(it->second.sections[update->section], update->mesh);
+      break;
+    }
+    case MESH_REMOVE_CHUNK:
+      removeChunk(update->pos);
+      break;
+    case MESH_LOD:
+      replace(lods[update->pos], update->mesh);
+      break;
+    case MESH_REMOVE_LOD:
+      removeLod(update->pos);
+      break;
+    }
+
+    delete update;
+  }
+}
+
+void WorldRenderer::removeChunk(ChunkPos pos) {
+  auto it = meshes.find(pos);
+  if (it == meshes.end()) {
+    return;
+  }
+
+  for (int i = 0; i < CHUNK_SECTIONS; i++) {
+    if (it->second.sections[i]) {
+      it->second.sections[i]->remove();
+      delete it->second.sections[i];
+    }
+  }
+
+  meshes.erase(it);
+}
+
+void WorldRenderer::removeLod(ChunkPos pos) {
+  auto it = lods.find(pos);
+  if (it == lods.end()) {
+    return;
+  }
+
+  if (it->second) {
+    it->second->remove();
+    delete it->second;
+  }
+  lods.erase(it);
+}
+
+void WorldRenderer::clear() {
+  while (!pending.empty()) {
+    delete pending.front();
+    pending.pop_front();
+  }
+  while (!meshes.empty()) {
+    removeChunk(meshes.begin()->first);
+  }
+  while (!lods.empty()) {
+    removeLod(lods.begin()->first);
+  }
+}
+
+void WorldRenderer::draw(const RenderSnapshot& snapshot, Shader& shader) {
+  GLint offsetUniform = glGetUniformLocation(shader.ID, "chunkOffset");
+
+  // The culling ran against exactly the meshes sent up to the snapshot's tick, which apply() has uploaded. Sections
+  // without a mesh are skipped all the same, rather than trusting the snapshot.
+  drawnSections = 0;
+  for (size_t i = 0; i < snapshot.sections.size(); i++) {
+    const SectionDraw& section = snapshot.sections[i];
+    auto it = meshes.find(section.chunk);
+    if (it == meshes.end() || !it->second.sections[section.section]) {
+      continue;
+    }
+
+    glm::vec3 offset = sectionOrigin(snapshot.camera, section.chunk.x, section.section, section.chunk.z);
+    glUniform3f(offsetUniform, offset.x, offset.y, offset.z);
+    it->second.sections[section.section]->draw();
+    drawnSections++;
+  }
+
+  for (size_t i = 0; i < snapshot.lods.size(); i++) {
+    auto it = lods.find(snapshot.lods[i]);
+    if (it == lods.end() || !it->second) {
+      continue;
+    }
+
+    glm::vec3 offset = sectionOrigin(snapshot.camera, snapshot.lods[i].x, 0, snapshot.lods[i].z);
+    glUniform3f(offsetUniform, offset.x, 0.0f, offset.z);
+    it->second->draw();
+  }
+}
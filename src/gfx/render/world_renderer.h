@@ -0,0 +1,53 @@
+/* world_renderer.h */
+
+#ifndef WORLD_RENDERER_HEADER_H
+#define WORLD_RENDERER_HEADER_H
+
+#include <deque>
+#include <unordered_map>
+
+#include "../../world/chunk.h"
+#include "../mesh/chunk_mesh.h"
+#include "../shader/shader.h"
+#include "render_snapshot.h"
+
+// GL side of the terrain rendering: holds the GPU meshes the TerrainView sends and draws what a snapshot lists. Every
+// call has to come from the thread owning the GL context.
+class WorldRenderer {
+public:
+  ~WorldRenderer();
+
+  // Queues a list of updates (TerrainView::takeUpdates()), then uploads and frees meshes as described by the queued
+  // updates sent up to simulation tick 'tick' and deletes them. Later ones wait for the snapshot they belong to, so a
+  // snapshot is never drawn with meshes it didn't cull for, like a distant terrain mesh already replaced by sections
+  // the snapshot doesn't list yet.
+  void apply(MeshUpdate* updates, uint64_t tick);
+
+  // Draws the sections and distant terrain of the snapshot in the order listed. The section origin relative to the
+  // camera chunk is passed to the shader through the 'chunkOffset' uniform, so vertex positions stay small however far
+  // the camera is from the world origin.
+  void draw(const RenderSnapshot& snapshot, Shader& shader);
+
+  // Frees all GPU meshes, needs to happen while the GL context is still alive
+  void clear();
+
+  // Sections drawn in the last draw
+  size_t getDrawnSections() const { return drawnSections; }
+
+private:
+  struct ChunkMeshes {
+    ChunkMesh* sections[CHUNK_SECTIONS];
+  };
+
+  std::unordered_map<ChunkPos, ChunkMeshes, ChunkPosHash> meshes;
+  std::unordered_map<ChunkPos, ChunkMesh*, ChunkPosHash> lods;
+  std::deque<MeshUpdate*> pending;
+  size_t drawnSections = 0;
+
+  void removeChunk(ChunkPos pos);
+  void removeLod(ChunkPos pos);
+  // Replaces 'mesh' with an upload of 'data', or with nothing when it's empty
+  static void replace(ChunkMesh*& mesh, MeshData& data);
+};
+
+#endif
@@ -4,10 +4,30 @@ VAO::VAO() {
   glGenVertexArrays(1, &ID);
 }
 
-void VAO::linkAttrib(VBO& VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void* offset) {
+void VAO::linkAttrib(VBO& VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void* offset, GLuint divisor) {
   VBO.bind();
   glVertexAttribPointer(layout, numComponents, type, GL_FALSE, stride, offset);
   glEnableVertexAttribArray(layout);
+  glVertexAttribDivisor(layout, divisor);
+  VBO.unbind();
+}
+
+void VAO::link(VBO& VBO, const VertexLayout& layout) {
+  VBO.bind();
+  for (size_t i = 0; i < layout.attributes.size(); i++) {
+    const VertexAttrib& attribute = layout.attributes[i];
+    void* offset = (void*)(size_t)attribute.offset;
+
+    if (attribute.mode == ATTRIB_INTEGER) {
+      glVertexAttribIPointer(attribute.location, attribute.components, attribute.type, layout.stride, offset);
+    }
+    else {
+      GLboolean normalized = attribute.mode == ATTRIB_NORMALIZED ? GL_TRUE : GL_FALSE;
+      glVertexAttribPointer(attribute.location, attribute.components, attribute.type, normalized, layout.stride, offset);
+    }
+    glEnableVertexAttribArray(attribute.location);
+    glVertexAttribDivisor(attribute.location, layout.divisor);
+  }
   VBO.unbind();
 }
 
@@ -5,6 +5,7 @@
 
 #include <glad/glad.h>
 #include "VBO.h"
+#include "vertex_layout.h"
 
 class VAO {
 public:
@@ -13,7 +14,10 @@ public:
   // Constructor & destructor
   VAO();
 
-  void linkAttrib(VBO& VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void* offset);
+  // A non zero divisor makes the attribute advance once per 'divisor' instances instead of once per vertex
+  void linkAttrib(VBO& VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void* offset, GLuint divisor = 0);
+  // Links every attribute of the layout, picking the integer, normalized or float pointer for each
+  void link(VBO& VBO, const VertexLayout& layout);
   void bind();
   void unbind();
   void remove();
@@ -1,11 +1,19 @@
+#include <stddef.h>
+
 #include "VBO.h"
 
-VBO::VBO(GLfloat* vertices, GLsizeiptr size) {
+VBO::VBO(const void* vertices, GLsizeiptr size) {
   glGenBuffers(1, &ID);
   glBindBuffer(GL_ARRAY_BUFFER, ID);
   glBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
 }
 
+void VBO::update(const void* data, GLsizeiptr size) {
+  glBindBuffer(GL_ARRAY_BUFFER, ID);
+  glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+}
+
 void VBO::bind() {
   glBindBuffer(GL_ARRAY_BUFFER, ID);
 }
@@ -10,7 +10,11 @@ public:
   GLuint ID;
 
   // Constructor & destructor
-  VBO(GLfloat* vertices, GLsizeiptr size);
+  VBO(const void* vertices, GLsizeiptr size);
+
+  // Replaces the contents with data that changes every frame, the old storage is orphaned so the driver doesn't
+  // have to wait for draws still using it
+  void update(const void* data, GLsizeiptr size);
 
   void bind();
   void unbind();
@@ -1,4 +1,5 @@
 #include <glad/glad.h>
+#include <glm/gtc/type_ptr.hpp>
 
 #include "shader.h"
 
@@ -107,6 +108,11 @@ void Shader::setFloat(const std::string& name, float value) const
   glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
 }
 
+void Shader::setMat4(const std::string& name, const glm::mat4& value) const
+{
+  glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+}
+
 void Shader::checkCompilerErrors(unsigned int uiHandle, std::string sType)
 {
   int iSuccessCode;
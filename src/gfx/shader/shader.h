@@ -5,6 +5,7 @@
 
 #include <glad/glad.h>
 #include <string>
+#include <glm/glm.hpp>
 
 class Shader
 {
@@ -23,6 +24,7 @@ public:
   void setBool(const std::string& name, bool value) const;
   void setInt(const std::string& name, int value) const;
   void setFloat(const std::string& name, float value) const;
+  void setMat4(const std::string& name, const glm::mat4& value) const;
 
 private:
   void checkCompilerErrors(unsigned int shader, std::string type);
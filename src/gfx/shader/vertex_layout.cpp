@@ -0,0 +1,18 @@
+#include <string>
+
+#include "vertex_layout.h"
+
+using namespace std;
+
+VertexLayout& VertexLayout::add(GLuint location, GLint components, GLenum type, AttribMode mode, size_t offset) {
+  bool isPacked = type == GL_INT_2_10_10_10_REV || type == GL_UNSIGNED_INT_2_10_10_10_REV;
+
+  // Integer attributes can't come from float or packed data and packed data always has four components
+  if ((mode == ATTRIB_INTEGER && (type == GL_FLOAT || type == GL_HALF_FLOAT || isPacked)) || (isPacked && components != 4)) {
+    throw(string)"ERROR::VERTEX_LAYOUT::INVALID_ATTRIBUTE";
+  }
+
+  VertexAttrib attribute = { location, components, type, mode, (GLuint)offset };
+  attributes.push_back(attribute);
+  return *this;
+}
@@ -0,0 +1,69 @@
+/* vertex_layout.h */
+
+#ifndef VERTEX_LAYOUT_HEADER_H
+#define VERTEX_LAYOUT_HEADER_H
+
+#include <stddef.h>
+#include <vector>
+#include <glad/glad.h>
+
+// How the shader sees an attribute
+enum AttribMode {
+  // Converted to float as is, a GL_UNSIGNED_BYTE 200 arrives as 200.0
+  ATTRIB_FLOAT,
+  // Mapped to [0, 1] for unsigned and [-1, 1] for signed types
+  ATTRIB_NORMALIZED,
+  // Stays an integer (glVertexAttribIPointer), the shader input must be an int/uint type
+  ATTRIB_INTEGER,
+};
+
+struct VertexAttrib {
+  GLuint location;
+  GLint components;
+  GLenum type;
+  AttribMode mode;
+  GLuint offset;
+};
+
+// Describes the attributes of one interleaved vertex buffer so meshers can pick compact formats, e.g.
+//
+//   VertexLayout layout(sizeof(PackedVertex));
+//   layout.packed(0, offsetof(PackedVertex, position), false)
+//         .normalized(1, 1, GL_UNSIGNED_BYTE, offsetof(PackedVertex, shade))
+//         .integer(2, 1, GL_UNSIGNED_BYTE, offsetof(PackedVertex, tile));
+//   vao.link(vbo, layout);
+class VertexLayout {
+public:
+  GLsizei stride;
+  // Non zero advances the attributes once per 'divisor' instances instead of once per vertex
+  GLuint divisor;
+  std::vector<VertexAttrib> attributes;
+
+  VertexLayout(GLsizei stride, GLuint divisor = 0) : stride(stride), divisor(divisor) {}
+
+  VertexLayout& add(GLuint location, GLint components, GLenum type, AttribMode mode, size_t offset);
+
+  VertexLayout& floats(GLuint location, GLint components, size_t offset) {
+    return add(location, components, GL_FLOAT, ATTRIB_FLOAT, offset);
+  }
+  VertexLayout& normalized(GLuint location, GLint components, GLenum type, size_t offset) {
+    return add(location, components, type, ATTRIB_NORMALIZED, offset);
+  }
+  VertexLayout& integer(GLuint location, GLint components, GLenum type, size_t offset) {
+    return add(location, components, type, ATTRIB_INTEGER, offset);
+  }
+
+  // One 32 bit word holding x, y, z in 10 bits each and w in the top 2 bits (GL_*_INT_2_10_10_10_REV), read as a
+  // vec4. Without normalization the shader gets the raw values: 0..1023 and 0..3 unsigned, -512..511 and -2..1 signed.
+  VertexLayout& packed(GLuint location, size_t offset, bool isSigned = false, bool isNormalized = false) {
+    return add(location, 4, isSigned ? GL_INT_2_10_10_10_REV : GL_UNSIGNED_INT_2_10_10_10_REV,
+      isNormalized ? ATTRIB_NORMALIZED : ATTRIB_FLOAT, offset);
+  }
+};
+
+// Packs unsigned 10 bit x, y, z and a 2 bit w for an unsigned packed attribute, values are masked to their width
+static inline GLuint packUnsigned10_10_10_2(GLuint x, GLuint y, GLuint z, GLuint w) {
+  return (x & 0x3FF) | ((y & 0x3FF) << 10) | ((z & 0x3FF) << 20) | ((w & 0x3) << 30);
+}
+
+#endif
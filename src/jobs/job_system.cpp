@@ -0,0 +1,358 @@
+#include <algorithm>
+
+#include "job_system.h"
+
+using namespace std;
+
+// Link in the list of jobs waiting for another job
+struct Continuation {
+  JobState* job;
+  Continuation* next;
+};
+
+struct JobState {
+  JobFunction function;
+  JobPriority priority;
+  // Dependencies that didn't finish yet, plus one while submit() is still adding them
+  atomic<int> pending;
+  // Handles, plus one held by the pool until the job finished
+  atomic<int> references;
+  atomic<bool> done;
+  // Jobs depending on this one, CLOSED_LIST once it finished so late dependents don't wait for it
+  atomic<Continuation*> continuations;
+};
+
+static Continuation closedList;
+#define CLOSED_LIST (&closedList)
+
+// The pool and the index of the worker running on this thread, -1 for threads outside any pool
+static thread_local JobSystem* currentSystem = NULL;
+static thread_local int currentWorker = -1;
+// xorshift32 state for picking victims
+static thread_local uint32_t stealRandom = 0x9E3779B9u;
+// Nanoseconds the running job spent on nested jobs or asleep in a wait, not part of its own busy time
+static thread_local uint64_t excludedTime = 0;
+
+static uint64_t nanoseconds(chrono::steady_clock::time_point start) {
+  return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+}
+
+static void release(JobState* job) {
+  if (job && job->references.fetch_sub(1, memory_order_acq_rel) == 1) {
+    delete job;
+  }
+}
+
+JobHandle::JobHandle(const JobHandle& other) : job(other.job) {
+  if (job) {
+    job->references.fetch_add(1, memory_order_relaxed);
+  }
+}
+
+JobHandle& JobHandle::operator=(const JobHandle& other) {
+  if (other.job) {
+    other.job->references.fetch_add(1, memory_order_relaxed);
+  }
+  release(job);
+  job = other.job;
+  return *this;
+}
+
+JobHandle::~JobHandle() {
+  release(job);
+}
+
+bool JobHandle::finished() const {
+  return !job || job->done.load(memory_order_acquire);
+}
+
+JobSystem::JobSystem(int workers) : injectedCount(0), stopping(false) {
+  for (int p = 0; p < JOB_PRIORITY_COUNT; p++) {
+    queued[p].store(0, memory_order_relaxed);
+  }
+
+  if (workers <= 0) {
+    unsigned int cores = thread::hardware_concurrency();
+    workers = cores > 1 ? (int)cores - 1 : 1;
+  }
+
+  for (int i = 0; i < workers; i++) {
+    Worker* worker = new Worker();
+    for (int p = 0; p < JOB_PRIORITY_COUNT; p++) {
+      worker->deques[p] = new WorkStealingDeque<JobState>(JOB_DEQUE_CAPACITY);
+    }
+    this->workers.push_back(worker);
+    counters.push_back(new Counters());
+  }
+  counters.push_back(new Counters());
+  statsStart = chrono::steady_clock::now();
+
+  // Only once every deque exists, workers steal from all of them
+  for (int i = 0; i < workers; i++) {
+    this->workers[i]->thread = thread(&JobSystem::loop, this, i);
+  }
+}
+
+JobSystem::~JobSystem() {
+  stopping.store(true, memory_order_seq_cst);
+  work.notify();
+
+  for (size_t i = 0; i < workers.size(); i++) {
+    workers[i]->thread.join();
+  }
+
+  for (size_t i = 0; i < workers.size(); i++) {
+    for (int p = 0; p < JOB_PRIORITY_COUNT; p++) {
+      delete workers[i]->deques[p];
+    }
+    delete workers[i];
+  }
+  for (size_t i = 0; i < counters.size(); i++) {
+    delete counters[i];
+  }
+}
+
+JobHandle JobSystem::submit(JobFunction function, JobPriority priority) {
+  return submit(function, priority, NULL, 0);
+}
+
+JobHandle JobSystem::submit(JobFunction function, JobPriority priority, const JobHandle* dependencies, size_t count) {
+  JobState* job = new JobState();
+  job->function = move(function);
+  job->priority = priority;
+  job->pending.store(1, memory_order_relaxed);
+  job->references.store(2, memory_order_relaxed);
+  job->done.store(false, memory_order_relaxed);
+  job->continuations.store(NULL, memory_order_relaxed);
+
+  for (size_t i = 0; i < count; i++) {
+    JobState* dependency = dependencies[i].job;
+    if (!dependency) {
+      continue;
+    }
+
+    Continuation* node = new Continuation();
+    node->job = job;
+    job->pending.fetch_add(1, memory_order_relaxed);
+
+    // Once the list is closed the dependency finished (and its effects are visible through the acquire)
+    Continuation* head = dependency->continuations.load(memory_order_acquire);
+    bool added = false;
+    while (head != CLOSED_LIST) {
+      node->next = head;
+      if (dependency->continuations.compare_exchange_weak(head, node, memory_order_release, memory_order_acquire)) {
+        added = true;
+        break;
+      }
+    }
+
+    if (!added) {
+      delete node;
+      job->pending.fetch_sub(1, memory_order_relaxed);
+    }
+  }
+
+  JobHandle handle(job);
+  if (job->pending.fetch_sub(1, memory_order_acq_rel) == 1) {
+    schedule(job);
+  }
+  return handle;
+}
+
+void JobSystem::wait(const JobHandle& job) {
+  if (!job.job) {
+    return;
+  }
+  helpUntil([&job] { return job.finished(); }, job.job->priority);
+}
+
+void JobSystem::wait(const vector<JobHandle>& jobs) {
+  for (size_t i = 0; i < jobs.size(); i++) {
+    wait(jobs[i]);
+  }
+}
+
+void JobSystem::helpUntil(const function<bool()>& done, JobPriority priority) {
+  while (!done()) {
+    if (runOne(priority)) {
+      continue;
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    finished.wait([this, &done, priority] { return done() || queuedUpTo(priority) > 0; });
+    excludedTime += nanoseconds(start);
+  }
+}
+
+JobStats JobSystem::takeStats() {
+  lock_guard<mutex> lock(statsMutex);
+  chrono::steady_clock::time_point now = chrono::steady_clock::now();
+
+  JobStats stats;
+  stats.jobs = 0;
+  stats.steals = 0;
+  stats.busy = 0.0;
+  stats.helped = 0.0;
+  stats.elapsed = chrono::duration<double>(now - statsStart).count();
+  stats.workers = (int)workers.size();
+  statsStart = now;
+
+  for (size_t i = 0; i < counters.size(); i++) {
+    stats.jobs += counters[i]->jobs.exchange(0, memory_order_relaxed);
+    stats.steals += counters[i]->steals.exchange(0, memory_order_relaxed);
+    double busy = counters[i]->busy.exchange(0, memory_order_relaxed) / 1e9;
+    if (i < workers.size()) {
+      stats.busy += busy;
+    }
+    else {
+      stats.helped += busy;
+    }
+  }
+  return stats;
+}
+
+void JobSystem::schedule(JobState* job) {
+  // Counted before it's visible, so a thread that finds nothing while 'queued' > 0 looks again instead of sleeping
+  queued[job->priority].fetch_add(1, memory_order_seq_cst);
+
+  int self = currentSystem == this ? currentWorker : -1;
+  if (self < 0 || !workers[self]->deques[job->priority]->push(job)) {
+    lock_guard<mutex> lock(injectedMutex);
+    injected[job->priority].push_back(job);
+    injectedCount.fetch_add(1, memory_order_release);
+  }
+
+  work.notify();
+  finished.notify();
+}
+
+JobState* JobSystem::takeInjected(int priority) {
+  if (injectedCount.load(memory_order_acquire) == 0) {
+    return NULL;
+  }
+
+  lock_guard<mutex> lock(injectedMutex);
+  if (injected[priority].empty()) {
+    return NULL;
+  }
+  JobState* job = injected[priority].front();
+  injected[priority].pop_front();
+  injectedCount.fetch_sub(1, memory_order_relaxed);
+  return job;
+}
+
+JobState* JobSystem::steal(int priority, int self) {
+  // Starting at a random victim spreads the thieves over the workers
+  stealRandom ^= stealRandom << 13;
+  stealRandom ^= stealRandom >> 17;
+  stealRandom ^= stealRandom << 5;
+
+  size_t count = workers.size();
+  size_t start = stealRandom % count;
+  for (size_t i = 0; i < count; i++) {
+    size_t victim = (start + i) % count;
+    if ((int)victim == self) {
+      continue;
+    }
+
+    JobState* job = workers[victim]->deques[priority]->steal();
+    if (job) {
+      return job;
+    }
+  }
+  return NULL;
+}
+
+int64_t JobSystem::queuedUpTo(int priority) const {
+  int64_t count = 0;
+  for (int p = 0; p <= priority; p++) {
+    count += queued[p].load(memory_order_seq_cst);
+  }
+  return count;
+}
+
+bool JobSystem::runOne(int lowest) {
+  int self = currentSystem == this ? currentWorker : -1;
+  Counters& counters = *this->counters[self >= 0 ? (size_t)self : workers.size()];
+
+  for (int p = 0; p <= lowest; p++) {
+    JobState* job = self >= 0 ? workers[self]->deques[p]->pop() : NULL;
+    if (!job) {
+      job = takeInjected(p);
+    }
+    if (!job) {
+      job = steal(p, self);
+      if (job) {
+        counters.steals.fetch_add(1, memory_order_relaxed);
+      }
+    }
+
+    if (job) {
+      execute(job, counters);
+      return true;
+    }
+  }
+  return false;
+}
+
+void JobSystem::execute(JobState* job, Counters& counters) {
+  queued[job->priority].fetch_sub(1, memory_order_seq_cst);
+
+  uint64_t outer = excludedTime;
+  excludedTime = 0;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  job->function();
+  // Whatever the function captured goes now, not when the last handle does
+  job->function = nullptr;
+  uint64_t total = nanoseconds(start);
+  uint64_t busy = total - min(excludedTime, total);
+  excludedTime = outer + total;
+
+  counters.jobs.fetch_add(1, memory_order_relaxed);
+  counters.busy.fetch_add(busy, memory_order_relaxed);
+  finish(job);
+}
+
+void JobSystem::finish(JobState* job) {
+  job->done.store(true, memory_order_release);
+
+  Continuation* node = job->continuations.exchange(CLOSED_LIST, memory_order_acq_rel);
+  while (node) {
+    Continuation* next = node->next;
+    if (node->job->pending.fetch_sub(1, memory_order_acq_rel) == 1) {
+      schedule(node->job);
+    }
+    delete node;
+    node = next;
+  }
+
+  finished.notify();
+  release(job);
+}
+
+void JobSystem::loop(int index) {
+  currentSystem = this;
+  currentWorker = index;
+  stealRandom = ((uint32_t)index + 1) * 0x9E3779B9u;
+
+  while (true) {
+    if (runOne(JOB_LOW)) {
+      continue;
+    }
+
+    // New work usually follows shortly (the next continuation, the next frame's jobs), sleeping costs a wake up
+    bool found = false;
+    for (int i = 0; i < JOB_IDLE_SPINS && !found; i++) {
+      this_thread::yield();
+      found = queuedUpTo(JOB_LOW) > 0;
+    }
+    if (found) {
+      continue;
+    }
+
+    work.wait([this] { return queuedUpTo(JOB_LOW) > 0 || stopping.load(memory_order_seq_cst); });
+    if (stopping.load(memory_order_seq_cst) && queuedUpTo(JOB_LOW) <= 0) {
+      return;
+    }
+  }
+}
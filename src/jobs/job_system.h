@@ -0,0 +1,161 @@
+/* job_system.h */
+
+#ifndef JOB_SYSTEM_HEADER_H
+#define JOB_SYSTEM_HEADER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../util/event_count.h"
+#include "work_stealing_deque.h"
+
+// Jobs one worker can queue before further jobs go through the shared queue
+#define JOB_DEQUE_CAPACITY 4096
+// Times an idle worker looks for work again before it goes to sleep
+#define JOB_IDLE_SPINS 64
+
+// Jobs of a higher priority are always picked first, by the owner of a deque as well as by thieves
+enum JobPriority : uint8_t {
+  // Work the current frame or tick waits for (systems)
+  JOB_HIGH,
+  // Work that should land within a few frames (meshing, generation)
+  JOB_NORMAL,
+  // Background work (saving)
+  JOB_LOW,
+  JOB_PRIORITY_COUNT
+};
+
+typedef std::function<void()> JobFunction;
+
+struct JobState;
+
+// Reference to a submitted job, used to wait for it or to make other jobs depend on it. Copies share the job, an
+// empty handle counts as finished.
+class JobHandle {
+public:
+  JobHandle() : job(NULL) {}
+  JobHandle(const JobHandle& other);
+  JobHandle& operator=(const JobHandle& other);
+  ~JobHandle();
+
+  bool valid() const { return job != NULL; }
+  bool finished() const;
+
+private:
+  friend class JobSystem;
+  JobState* job;
+
+  explicit JobHandle(JobState* job) : job(job) {}
+};
+
+// Counters since the last takeStats(). Jobs and steals are summed over the workers and the threads that helped while
+// waiting, the busy times are kept apart.
+struct JobStats {
+  uint64_t jobs;
+  uint64_t steals;
+  // Time the workers spent running jobs, not counting the time a job waited for others
+  double busy;
+  // Time threads outside the pool spent running jobs while they waited
+  double helped;
+  // Wall time the counters cover
+  double elapsed;
+  int workers;
+
+  // Share of the workers' time spent running jobs
+  double utilisation() const { return elapsed > 0.0 && workers > 0 ? busy / (elapsed * workers) : 0.0; }
+};
+
+// Work-stealing thread pool shared by every subsystem. Each worker owns one Chase-Lev deque per priority: jobs
+// submitted from a worker go to the bottom of its own deque, idle workers steal from the top of the others', and
+// threads outside the pool submit through a locked queue per priority. A job can depend on other jobs; it is queued
+// once the last of them finished (the finishing thread queues it, so continuations run on a warm cache). Waiting for a
+// job runs other jobs of at least its priority in the meantime, so jobs may wait for jobs they submitted without tying
+// up a worker, and a tick waiting for its systems never ends up running a background save. A job should therefore not
+// depend on jobs of a lower priority than the jobs waiting for it. Jobs must not throw.
+class JobSystem {
+public:
+  // Constructor & destructor, 'workers' <= 0 sizes the pool to the cores left next to the thread that submits. Jobs
+  // still queued are run before the destructor returns, jobs whose dependencies never finish are dropped.
+  JobSystem(int workers = 0);
+  ~JobSystem();
+
+  JobHandle submit(JobFunction function, JobPriority priority = JOB_NORMAL);
+  // Runs 'function' once every job in 'dependencies' finished
+  JobHandle submit(JobFunction function, JobPriority priority, const JobHandle* dependencies, size_t count);
+  JobHandle submit(JobFunction function, JobPriority priority, const std::vector<JobHandle>& dependencies) {
+    return submit(function, priority, dependencies.data(), dependencies.size());
+  }
+  JobHandle then(const JobHandle& dependency, JobFunction function, JobPriority priority = JOB_NORMAL) {
+    return submit(function, priority, &dependency, 1);
+  }
+
+  // Block until the jobs finished, running queued jobs of the same or a higher priority meanwhile. Safe to call from
+  // inside a job.
+  void wait(const JobHandle& job);
+  void wait(const std::vector<JobHandle>& jobs);
+
+  // Blocks until 'done()' returns true, running queued jobs of 'priority' or higher meanwhile. 'done()' is evaluated
+  // again whenever a job finishes, so it must only depend on state jobs change.
+  void helpUntil(const std::function<bool()>& done, JobPriority priority);
+
+  int workerCount() const { return (int)workers.size(); }
+  JobStats takeStats();
+
+private:
+  struct Counters {
+    char padding0[CACHE_LINE_SIZE];
+    std::atomic<uint64_t> jobs;
+    std::atomic<uint64_t> steals;
+    std::atomic<uint64_t> busy;
+    char padding1[CACHE_LINE_SIZE];
+
+    Counters() : jobs(0), steals(0), busy(0) {}
+  };
+
+  struct Worker {
+    WorkStealingDeque<JobState>* deques[JOB_PRIORITY_COUNT];
+    std::thread thread;
+  };
+
+  std::vector<Worker*> workers;
+  // Per worker, the last entry collects threads outside the pool
+  std::vector<Counters*> counters;
+
+  // Jobs submitted from outside the pool or that didn't fit a worker's deque
+  std::mutex injectedMutex;
+  std::deque<JobState*> injected[JOB_PRIORITY_COUNT];
+  std::atomic<size_t> injectedCount;
+
+  // Jobs ready to run that no thread took yet, per priority
+  std::atomic<int64_t> queued[JOB_PRIORITY_COUNT];
+  std::atomic<bool> stopping;
+  // Idle workers sleep on 'work', waiting threads on 'finished' (which is also notified when work is queued)
+  EventCount work;
+  EventCount finished;
+
+  std::mutex statsMutex;
+  std::chrono::steady_clock::time_point statsStart;
+
+  void schedule(JobState* job);
+  JobState* takeInjected(int priority);
+  JobState* steal(int priority, int self);
+  // Ready jobs of 'priority' or higher
+  int64_t queuedUpTo(int priority) const;
+  // Runs one ready job of 'lowest' or a higher priority on the calling thread, false when there was none
+  bool runOne(int lowest);
+  void execute(JobState* job, Counters& counters);
+  void finish(JobState* job);
+  void loop(int index);
+
+  JobSystem(const JobSystem&);
+  JobSystem& operator=(const JobSystem&);
+};
+
+#endif
@@ -0,0 +1,102 @@
+/* work_stealing_deque.h */
+
+#ifndef WORK_STEALING_DEQUE_HEADER_H
+#define WORK_STEALING_DEQUE_HEADER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#include "../util/spsc_queue.h"
+
+// Chase-Lev deque of pointers with a fixed capacity. The owning thread pushes and pops at the bottom (last in, first
+// out, so it keeps working on what it just produced while it is still in the cache), any other thread steals from the
+// top (oldest first, usually the biggest piece of remaining work). Only the race for the last element and concurrent
+// steals go through a compare-and-swap on 'top'. The indices use sequentially consistent accesses where the original
+// algorithm uses fences, which keeps it simple and visible to thread sanitizers.
+template <typename T>
+class WorkStealingDeque {
+public:
+  // Constructor & destructor, the capacity is rounded up to a power of two
+  WorkStealingDeque(size_t capacity) : top(0), bottom(0) {
+    size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    slots = new std::atomic<T*>[size];
+    mask = size - 1;
+  }
+
+  ~WorkStealingDeque() {
+    delete[] slots;
+  }
+
+  // Owner: false when the deque is full
+  bool push(T* item) {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    if (b - t > (int64_t)mask) {
+      return false;
+    }
+
+    slots[b & mask].store(item, std::memory_order_relaxed);
+    bottom.store(b + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Owner: the newest item, NULL when empty
+  T* pop() {
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_seq_cst);
+
+    if (t > b) {
+      bottom.store(b + 1, std::memory_order_relaxed);
+      return NULL;
+    }
+
+    T* item = slots[b & mask].load(std::memory_order_relaxed);
+    if (t == b) {
+      // The last item, thieves may be after it as well
+      if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        item = NULL;
+      }
+      bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return item;
+  }
+
+  // Any thread: the oldest item, NULL when empty or when another thread won the race for it
+  T* steal() {
+    int64_t t = top.load(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_seq_cst);
+    if (t >= b) {
+      return NULL;
+    }
+
+    T* item = slots[t & mask].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      return NULL;
+    }
+    return item;
+  }
+
+  // Any thread, only a snapshot
+  bool empty() const { return bottom.load(std::memory_order_acquire) <= top.load(std::memory_order_acquire); }
+
+private:
+  char padding0[CACHE_LINE_SIZE];
+  // Thieves
+  std::atomic<int64_t> top;
+  char padding1[CACHE_LINE_SIZE];
+  // Owner
+  std::atomic<int64_t> bottom;
+  char padding2[CACHE_LINE_SIZE];
+  std::atomic<T*>* slots;
+  size_t mask;
+
+  WorkStealingDeque(const WorkStealingDeque&);
+  WorkStealingDeque& operator=(const WorkStealingDeque&);
+};
+
+#endif
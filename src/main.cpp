@@ -1,5 +1,7 @@
 #include <math.h>
+#include <chrono>
 #include <iostream>
+#include <thread>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <stb/stb_image.h>
@@ -9,61 +11,21 @@
 
 #include "gfx/shader/shader.h"
 #include "gfx/texture/texture.h"
-#include "gfx/shader/VAO.h"
-#include "gfx/shader/VBO.h"
-#include "gfx/shader/EBO.h"
+#include "gfx/render/world_renderer.h"
+#include "gfx/render/entity_renderer.h"
 
 #include "gfx/camera/camera.h"
 
+#include "client/simulation.h"
+#include "jobs/job_system.h"
+
 using namespace std;
 
 #define APP_VERSION "0.1.1"
 
-#define TEXTURE_NR 1
-#define TEXTURE_X1 (float) ((TEXTURE_NR % 16) * (float) 16/256)
-#define TEXTURE_X2 TEXTURE_X1 + (float) 16/256
-
-#define TEXTURE_Y2 (float) 1 - (TEXTURE_NR / 16 * (float) 16/256)
-#define TEXTURE_Y1 TEXTURE_Y2 - (float) 16/256
-
 const unsigned int uiScreenWidth = 800;
 const unsigned int uiScreenHeight = 800;
 
-// Vertices for the triangles
-GLfloat vertices[] = {
-  // Coordinates ------- Colors ----------- Texture coordinates
-  -0.5f, -0.5f, -0.5f,    0.8f, 0.3f, 0.02f, TEXTURE_X1, TEXTURE_Y1,  // Front lower left corner  0 
-  -0.5f,  0.5f, -0.5f,    1.0f, 0.6f, 0.32f, TEXTURE_X1, TEXTURE_Y2,  // Front upper left corner  1
-   0.5f,  0.5f, -0.5f,    1.0f, 0.6f, 0.32f, TEXTURE_X2, TEXTURE_Y2,  // Front upper right corner 2
-   0.5f, -0.5f, -0.5f,    0.8f, 0.3f, 0.02f, TEXTURE_X2, TEXTURE_Y1,  // Front lower right corner 3
-
-  -0.5f, -0.5f,  0.5f,    0.8f, 0.3f, 0.02f, TEXTURE_X1, TEXTURE_Y1,  // Back lower left corner   4
-  -0.5f,  0.5f,  0.5f,    1.0f, 0.6f, 0.32f, TEXTURE_X1, TEXTURE_Y2,  // Back upper left corner   5
-   0.5f,  0.5f,  0.5f,    1.0f, 0.6f, 0.32f, TEXTURE_X2, TEXTURE_Y2,  // Back upper right corner  6
-   0.5f, -0.5f,  0.5f,    0.8f, 0.3f, 0.02f, TEXTURE_X2, TEXTURE_Y1,  // Back lower right corner  7
-};
-
-// Indices for the vertex ordering
-GLuint indices[] = {
-  0, 2, 1, // Front face - lower triangle
-  0, 3, 2, // Front face - Upper triangle
-
-  1, 5, 6, // Top face
-  1, 2, 6, // Top face
-
-  0, 3, 7, // Bottom face
-  0, 4, 7, // Bottom face
-
-  2, 3, 6, // Right face
-  3, 6, 7, // Right face
-
-  0, 4, 5, // Left face
-  0, 1, 5, // Left face
-
-  4, 5, 6, // Back face
-  4, 6, 7, // Back face
-};
-
 int main(int argc, char* argv[])
 {
   try
@@ -94,6 +56,8 @@ int main(int argc, char* argv[])
 
     // Add newly created window to current context
     glfwMakeContextCurrent(window);
+    // Frames are paced by the display, the simulation keeps its own rate on its own thread
+    glfwSwapInterval(1);
 
     // GLAD is an OpenGL Loading Library is a library that loads pointers to OpenGL functions at runtime, core as well as extensions.
     // Load GLAD so it configures OpenGL
@@ -118,44 +82,72 @@ int main(int argc, char* argv[])
 
     // Construct shader object
     Shader shader("./src/resources/shaders/shader.vs", "./src/resources/shaders/shader.fs");
+    Shader entityShader("./src/resources/shaders/entity.vs", "./src/resources/shaders/entity.fs");
 
-    // Generate vertex array object and bind it
-    VAO VAO1;
-    VAO1.bind();
-
-    // Generate vertex and element buffer objects
-    VBO VBO1(vertices, sizeof(vertices));
-    // Generates Element Buffer Object and links it to indices
-    EBO EBO1(indices, sizeof(indices));
+    // Worker threads shared by chunk generation, meshing, saving and the entity systems
+    JobSystem jobs;
 
-    // Links VBO to VAO
-    VAO1.linkAttrib(VBO1, 0, 3, GL_FLOAT, 8 * sizeof(float), (void*)0);
-    VAO1.linkAttrib(VBO1, 1, 3, GL_FLOAT, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    VAO1.linkAttrib(VBO1, 2, 2, GL_FLOAT, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-
-    // Unbind all to prevent accidentally modifying them
-    VAO1.unbind();
-    VBO1.unbind();
-    EBO1.unbind();
+    // The game server and its client, each on a thread of its own. This thread only samples input and draws the
+    // snapshots the client publishes.
+    Simulation simulation(jobs, uiScreenWidth, uiScreenHeight);
+    WorldRenderer worldRenderer;
+    EntityRenderer entityRenderer;
 
     // Create/define uniform 'scale' for use in shader
     GLuint uniID = glGetUniformLocation(shader.ID, "scale");
 
+    // Only used to sample input, the simulation moves its own camera with the player
+    Camera inputCamera(uiScreenWidth, uiScreenHeight, WorldPosition());
+
     // Textures
     Texture texture("./src/resources/textures/blocks.png", GL_TEXTURE_2D, GL_TEXTURE0, GL_RGBA, GL_UNSIGNED_BYTE);
     texture.texUnit(shader, "tex0", 0);
+    texture.texUnit(entityShader, "tex0", 0);
 
     // Enables the Depth Buffer
     glEnable(GL_DEPTH_TEST);
+    // Chunk meshes are wound counter-clockwise, skip the back faces
+    glEnable(GL_CULL_FACE);
 
-    // Camera
-    Camera camera(uiScreenWidth, uiScreenHeight, glm::vec3(0.0f, 0.0f, 2.0f));
+    simulation.start();
 
-    double lasttime = glfwGetTime();
+    FrameInput sent;
+    bool leftPressed = false;
+    bool rightPressed = false;
+    uint64_t frames = 0;
 
     // Main event loop
     while (!glfwWindowShouldClose(window))
     {
+      // Handle all GLFW events
+      glfwPollEvents();
+
+      // Movement keys and facing, and clicks as they happen. Left click breaks the targeted block, right click places
+      // planks against the targeted face.
+      FrameInput input;
+      input.player = inputCamera.Inputs(window);
+      input.orientation = inputCamera.orientation;
+      bool leftDown = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+      bool rightDown = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS;
+      input.breakBlock = leftDown && !leftPressed;
+      input.placeBlock = rightDown && !rightPressed && !leftDown;
+      leftPressed = leftDown;
+      rightPressed = rightDown;
+
+      bool changed = input.player.keys != sent.player.keys || input.player.yaw != sent.player.yaw || input.orientation != sent.orientation;
+      if ((changed || input.breakBlock || input.placeBlock) && simulation.sendInput(input)) {
+        sent = input;
+      }
+
+      // Nothing new to draw, the last frame stays on screen
+      if (!simulation.takeSnapshot()) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+        continue;
+      }
+      const RenderSnapshot& snapshot = simulation.snapshot();
+      // Every mesh the snapshot lists was sent before it was published
+      worldRenderer.apply(simulation.takeMeshUpdates(), snapshot.tick);
+
       // Specify clear values for the color buffers
       glClearColor(0.07f, 0.13f, 0.17f, 1.0f);
       // Actually perform clearing of the buffers
@@ -163,40 +155,42 @@ int main(int argc, char* argv[])
 
       // Tell OpenGL which Shader Program we want to use
       shader.activate();
-
-      camera.Inputs(window);
-      camera.Matrix(90.0f, 0.1f, 100.0f, shader, "camMatrix");
+      shader.setMat4("camMatrix", snapshot.cameraMatrix);
 
       // Binds texture so that is appears in rendering
       texture.bind();
 
-      // Bind the VAO so OpenGL knows to use it
-      VAO1.bind();
-
       // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
-      // Draw primitives, number of indices, datatype of indices, index of indices
-      glDrawElements(GL_TRIANGLES, sizeof(indices) / sizeof(int), GL_UNSIGNED_INT, 0);
+      // Draw the chunk sections the simulation found visible
+      worldRenderer.draw(snapshot, shader);
+
+      // Draw all entities, one instanced call per model
+      entityShader.activate();
+      entityShader.setMat4("camMatrix", snapshot.cameraMatrix);
+      entityRenderer.draw(snapshot.entities, entityShader);
 
       // Swap the back buffer with the front buffer
       glfwSwapBuffers(window);
-
-      // Handle all GLFW events
-      glfwPollEvents();
-
-      while (glfwGetTime() < lasttime + 1.0 / 60) {
-        // TODO: Put the thread to sleep, yield, or simply do nothing
-      }
-      lasttime += 1.0 / 60;
+      frames++;
     }
 
-    VAO1.remove();
-    VBO1.remove();
-    EBO1.remove();
+    simulation.stop();
+    worldRenderer.clear();
+    entityRenderer.remove();
+
+    const NetStats& netStats = simulation.getNetStats();
+    cout << "Server: " << netStats.messagesReceived << " messages (" << netStats.bytesReceived / 1024 << " KiB) received, "
+      << simulation.getMeshedChunks() << " chunks meshed, " << simulation.getCorrections() << " predictions corrected" << endl;
+    cout << "Simulation: " << simulation.getTicks() << " ticks (" << simulation.getOverruns() << " late), " << frames << " frames drawn" << endl;
+    JobStats jobStats = jobs.takeStats();
+    cout << "Jobs: " << jobStats.jobs << " on " << jobStats.workers << " workers, " << jobStats.steals << " steals, "
+      << (int)(jobStats.utilisation() * 100.0) << " % utilisation" << endl;
     // texture.remove();
 
     // Free shader object
     shader.deactivate();
+    entityShader.deactivate();
 
     // Destruct window prior to ending program
     glfwDestroyWindow(window);
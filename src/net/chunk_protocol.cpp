@@ -0,0 +1,250 @@
+#include "chunk_protocol.h"
+#include "../world/storage/chunk_serializer.h"
+
+// Message type, codec, raw size
+#define BATCH_HEADER 6
+
+ChunkBatchWriter::ChunkBatchWriter(Codec* codec) {
+  this->codec = codec;
+  this->rawBytes = 0;
+  this->messageBytes = 0;
+}
+
+void ChunkBatchWriter::chunk(const ChunkSnapshot& chunk) {
+  uint8_t mask = 0;
+  for (int i = 0; i < CHUNK_SECTIONS; i++) {
+    if (chunk.sections[i]->nonAirCount > 0) {
+      mask |= 1 << i;
+    }
+  }
+
+  ByteWriter writer(raw);
+  writer.u8(RECORD_CHUNK);
+  writer.u32((uint32_t)chunk.pos.x);
+  writer.u32((uint32_t)chunk.pos.z);
+  writer.u8(mask);
+  recordAdded();
+
+  for (int i = 0; i < CHUNK_SECTIONS; i++) {
+    if (mask & (1 << i)) {
+      section(chunk.pos, i, *chunk.sections[i]);
+    }
+  }
+}
+
+void ChunkBatchWriter::section(ChunkPos pos, int section, const SectionData& data) {
+  ByteWriter writer(raw);
+  writeSection(writer, pos, section, data);
+  recordAdded();
+}
+
+void ChunkBatchWriter::deltas(ChunkPos pos, int section, const BlockDelta* deltas, size_t count) {
+  ByteWriter writer(raw);
+  writeDeltas(writer, pos, section, deltas, count);
+  recordAdded();
+}
+
+void ChunkBatchWriter::unload(ChunkPos pos) {
+  ByteWriter writer(raw);
+  writer.u8(RECORD_UNLOAD);
+  writer.u32((uint32_t)pos.x);
+  writer.u32((uint32_t)pos.z);
+  recordAdded();
+}
+
+void ChunkBatchWriter::records(const uint8_t* data, size_t size) {
+  raw.insert(raw.end(), data, data + size);
+  recordAdded();
+}
+
+size_t ChunkBatchWriter::pendingBytes() const {
+  size_t bytes = raw.size() + BATCH_HEADER;
+  for (size_t i = 0; i < messages.size(); i++) {
+    bytes += messages[i].size();
+  }
+
+  return bytes;
+}
+
+void ChunkBatchWriter::finish(std::vector<std::vector<uint8_t>>& out) {
+  closeBatch();
+
+  for (size_t i = 0; i < messages.size(); i++) {
+    out.push_back(std::vector<uint8_t>());
+    out.back().swap(messages[i]);
+  }
+  messages.clear();
+}
+
+void ChunkBatchWriter::writeSection(ByteWriter& writer, ChunkPos pos, int section, const SectionData& data) {
+  writer.u8(RECORD_SECTION);
+  writer.u32((uint32_t)pos.x);
+  writer.u32((uint32_t)pos.z);
+  writer.u8((uint8_t)section);
+  ChunkSerializer::writeSection(data, writer);
+}
+
+void ChunkBatchWriter::writeDeltas(ByteWriter& writer, ChunkPos pos, int section, const BlockDelta* deltas, size_t count) {
+  writer.u8(RECORD_DELTAS);
+  writer.u32((uint32_t)pos.x);
+  writer.u32((uint32_t)pos.z);
+  writer.u8((uint8_t)section);
+  writer.u16((uint16_t)count);
+  for (size_t i = 0; i < count; i++) {
+    writer.u16(deltas[i].index);
+    writer.u16(deltas[i].id);
+  }
+}
+
+void ChunkBatchWriter::recordAdded() {
+  if (raw.size() >= CHUNK_BATCH_SIZE) {
+    closeBatch();
+  }
+}
+
+void ChunkBatchWriter::closeBatch() {
+  if (raw.empty()) {
+    return;
+  }
+
+  messages.push_back(std::vector<uint8_t>());
+  std::vector<uint8_t>& message = messages.back();
+  message.reserve(BATCH_HEADER + raw.size());
+
+  ByteWriter writer(message);
+  writer.u8(MSG_CHUNK_BATCH);
+  writer.u8(CODEC_NONE);
+  writer.u32((uint32_t)raw.size());
+
+  if (codec && raw.size() >= CHUNK_COMPRESS_MIN) {
+    codec->compress(raw.data(), raw.size(), message);
+
+    // Incompressible batches (rare, sections are already bit-packed) go out raw
+    if (message.size() < BATCH_HEADER + raw.size()) {
+      message[1] = codec->id();
+    }
+    else {
+      message.resize(BATCH_HEADER);
+    }
+  }
+  if (message[1] == CODEC_NONE) {
+    writer.bytes(raw.data(), raw.size());
+  }
+
+  rawBytes += raw.size();
+  messageBytes += message.size();
+  raw.clear();
+}
+
+static bool readPos(ByteReader& reader, ChunkPos& pos) {
+  pos.x = (int)reader.u32();
+  pos.z = (int)reader.u32();
+
+  return reader.ok;
+}
+
+static bool applyRecords(ByteReader& reader, World& world, ChunkUpdates& updates) {
+  while (reader.remaining() > 0) {
+    uint8_t type = reader.u8();
+    ChunkPos pos;
+    if (!readPos(reader, pos)) {
+      return false;
+    }
+
+    if (type == RECORD_CHUNK) {
+      uint8_t mask = reader.u8();
+      if (!reader.ok) {
+        return false;
+      }
+
+      // Sections in the mask follow as their own records, clear the others now
+      Chunk* chunk = world.createChunk(pos);
+      for (int i = 0; i < CHUNK_SECTIONS; i++) {
+        if (!(mask & (1 << i))) {
+          chunk->sections[i] = Section();
+        }
+      }
+      updates.chunks.push_back(pos);
+    }
+    else if (type == RECORD_SECTION) {
+      int section = reader.u8();
+      if (!reader.ok || section >= CHUNK_SECTIONS) {
+        return false;
+      }
+
+      Chunk* chunk = world.createChunk(pos);
+      if (!ChunkSerializer::readSection(reader, chunk->sections[section].edit())) {
+        return false;
+      }
+      updates.sections.push_back(std::make_pair(pos, section));
+    }
+    else if (type == RECORD_DELTAS) {
+      int section = reader.u8();
+      int count = reader.u16();
+      if (!reader.ok || section >= CHUNK_SECTIONS) {
+        return false;
+      }
+
+      // Deltas for a chunk the client dropped in the meantime are read and ignored
+      Chunk* chunk = world.getChunk(pos);
+      for (int i = 0; i < count; i++) {
+        uint16_t index = reader.u16();
+        BlockID id = reader.u16();
+        if (index >= SECTION_VOLUME) {
+          return false;
+        }
+
+        // Straight into the section: server owned blocks never make the client's chunk dirty
+        if (chunk) {
+          int x = index & SECTION_MASK;
+          int y = index >> (2 * SECTION_SHIFT);
+          int z = (index >> SECTION_SHIFT) & SECTION_MASK;
+          chunk->sections[section].setBlock(x, y, z, id);
+          updates.blocks.push_back({ pos.x * SECTION_SIZE + x, section * SECTION_SIZE + y, pos.z * SECTION_SIZE + z, id });
+        }
+      }
+      if (!reader.ok) {
+        return false;
+      }
+    }
+    else if (type == RECORD_UNLOAD) {
+      world.unloadChunk(pos);
+      updates.unloaded.push_back(pos);
+    }
+    else {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool applyChunkBatch(const uint8_t* data, size_t size, Codec& codec, World& world, ChunkUpdates& updates) {
+  ByteReader reader(data, size);
+
+  uint8_t type = reader.u8();
+  uint8_t codecId = reader.u8();
+  uint32_t rawSize = reader.u32();
+  if (!reader.ok || type != MSG_CHUNK_BATCH || rawSize > CODEC_MAX_PAYLOAD) {
+    return false;
+  }
+
+  if (codecId == CODEC_NONE) {
+    if (reader.remaining() != rawSize) {
+      return false;
+    }
+    return applyRecords(reader, world, updates);
+  }
+
+  if (codecId != codec.id()) {
+    return false;
+  }
+
+  static thread_local std::vector<uint8_t> records;
+  if (!codec.decompress(data + BATCH_HEADER, size - BATCH_HEADER, records) || records.size() != rawSize) {
+    return false;
+  }
+
+  ByteReader recordReader(records.data(), records.size());
+  return applyRecords(recordReader, world, updates);
+}
@@ -0,0 +1,100 @@
+/* chunk_protocol.h */
+
+#ifndef CHUNK_PROTOCOL_HEADER_H
+#define CHUNK_PROTOCOL_HEADER_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "../world/world.h"
+#include "../world/storage/codec.h"
+#include "../util/byte_buffer.h"
+#include "protocol.h"
+
+// Raw record bytes after which a batch is closed, a record never exceeds the size of one palette encoded section
+// (about 15 KiB for a worst case section), so batches stay far below NET_MAX_MESSAGE even uncompressed
+#define CHUNK_BATCH_SIZE (32 * 1024)
+// Smaller batches are sent uncompressed, the frame overhead would eat the gain
+#define CHUNK_COMPRESS_MIN 128
+// Bytes of a RECORD_DELTAS record before the deltas (type, x, z, section index, count) and per delta (index, id), as
+// ChunkBatchWriter::writeDeltas() writes them
+#define DELTA_RECORD_HEADER (1 + 4 + 4 + 1 + 2)
+#define DELTA_RECORD_ENTRY (2 + 2)
+
+enum ChunkRecordType : uint8_t {
+  // x, z, section mask: the client replaces the chunk, sections outside the mask are empty, the others follow as
+  // RECORD_SECTION records
+  RECORD_CHUNK = 1,
+  // x, z, section index, palette encoded section (ChunkSerializer::writeSection)
+  RECORD_SECTION,
+  // x, z, section index, count, then count times (block index within the section, block id)
+  RECORD_DELTAS,
+  // x, z: the client drops the chunk
+  RECORD_UNLOAD,
+};
+
+struct BlockDelta {
+  // Section::index() of the block
+  uint16_t index;
+  BlockID id;
+};
+
+// Builds MSG_CHUNK_BATCH messages: [type][codec][raw size u32][records, compressed with the codec]. Records are
+// gathered until the batch reaches CHUNK_BATCH_SIZE, then the batch is closed and a new one started, so one call to
+// finish() may return several messages.
+class ChunkBatchWriter {
+public:
+  // Constructor, 'codec' may be NULL to send everything uncompressed
+  ChunkBatchWriter(Codec* codec);
+
+  // A whole chunk, empty sections cost one bit
+  void chunk(const ChunkSnapshot& chunk);
+  void section(ChunkPos pos, int section, const SectionData& data);
+  void deltas(ChunkPos pos, int section, const BlockDelta* deltas, size_t count);
+  void unload(ChunkPos pos);
+  // Appends records built elsewhere, e.g. the same section update shared by every client that sees the section
+  void records(const uint8_t* data, size_t size);
+
+  bool empty() const { return raw.empty() && messages.empty(); }
+  // Bytes written since the last finish(), an upper bound on what finish() will return
+  size_t pendingBytes() const;
+
+  // Moves the finished messages into 'out'
+  void finish(std::vector<std::vector<uint8_t>>& out);
+
+  // Record bytes before and message bytes after compression, over the writer's lifetime
+  uint64_t rawBytes;
+  uint64_t messageBytes;
+
+  // Record encoding, shared with callers building records once for many writers
+  static void writeSection(ByteWriter& writer, ChunkPos pos, int section, const SectionData& data);
+  static void writeDeltas(ByteWriter& writer, ChunkPos pos, int section, const BlockDelta* deltas, size_t count);
+
+private:
+  Codec* codec;
+  std::vector<uint8_t> raw;
+  std::vector<std::vector<uint8_t>> messages;
+
+  void closeBatch();
+  void recordAdded();
+};
+
+// What a batch changed on the client
+struct ChunkUpdates {
+  // Chunks that were replaced as a whole
+  std::vector<ChunkPos> chunks;
+  // Sections that were replaced, as (chunk, section index)
+  std::vector<std::pair<ChunkPos, int>> sections;
+  // Blocks changed by delta records, in world coordinates
+  std::vector<BlockChange> blocks;
+  std::vector<ChunkPos> unloaded;
+
+  void clear() { chunks.clear(); sections.clear(); blocks.clear(); unloaded.clear(); }
+};
+
+// Applies a MSG_CHUNK_BATCH message to the client's world. 'codec' has to decompress what the server's codec
+// produced (any zstd codec without dictionary does). Returns false for corrupt messages, records before the corrupt
+// one stay applied.
+bool applyChunkBatch(const uint8_t* data, size_t size, Codec& codec, World& world, ChunkUpdates& updates);
+
+#endif
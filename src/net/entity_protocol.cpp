@@ -0,0 +1,466 @@
+#include <math.h>
+#include <string.h>
+
+#include "entity_protocol.h"
+#include "../util/bit_buffer.h"
+
+static void writePosition(ByteWriter& writer, const WorldPosition& position) {
+  writer.u32((uint32_t)position.chunkX);
+  writer.u32((uint32_t)position.chunkZ);
+  writer.f32(position.local.x);
+  writer.f32(position.local.y);
+  writer.f32(position.local.z);
+}
+
+static void writeBody(ByteWriter& writer, const PhysicsBody& body) {
+  writePosition(writer, body.position);
+  writer.f32(body.velocity.x);
+  writer.f32(body.velocity.y);
+  writer.f32(body.velocity.z);
+}
+
+static WorldPosition readPosition(ByteReader& reader) {
+  int64_t chunkX = (int32_t)reader.u32();
+  int64_t chunkZ = (int32_t)reader.u32();
+  glm::vec3 local;
+  local.x = reader.f32();
+  local.y = reader.f32();
+  local.z = reader.f32();
+
+  return WorldPosition(chunkX, chunkZ, local);
+}
+
+static void readBody(ByteReader& reader, PhysicsBody& body) {
+  body.position = readPosition(reader);
+  body.velocity.x = reader.f32();
+  body.velocity.y = reader.f32();
+  body.velocity.z = reader.f32();
+}
+
+static int64_t toFixed(int64_t chunk, float local, int scale) {
+  return chunk * SECTION_SIZE * scale + (int64_t)lroundf(local * scale);
+}
+
+EntityState quantizeEntity(Entity entity, const PhysicsBody& body, const Appearance& appearance) {
+  EntityState state;
+  state.entity = entity;
+
+  state.position[0] = toFixed(body.position.chunkX, body.position.local.x, ENTITY_POSITION_SCALE);
+  state.position[1] = toFixed(0, body.position.local.y, ENTITY_POSITION_SCALE);
+  state.position[2] = toFixed(body.position.chunkZ, body.position.local.z, ENTITY_POSITION_SCALE);
+  for (int i = 0; i < 3; i++) {
+    state.velocity[i] = (int32_t)lroundf(body.velocity[i] * ENTITY_VELOCITY_SCALE);
+  }
+
+  // Any angle maps onto a whole number of steps of a turn
+  float turns = appearance.yaw / 6.2831853f;
+  state.yaw = (uint16_t)((int64_t)lroundf((turns - floorf(turns)) * (1 << ENTITY_YAW_BITS)) & ((1 << ENTITY_YAW_BITS) - 1));
+
+  state.width = body.width;
+  state.height = body.height;
+  state.scale = appearance.scale;
+  for (int i = 0; i < 3; i++) {
+    state.color[i] = (uint8_t)lroundf(glm::clamp(appearance.color[i], 0.0f, 1.0f) * 255.0f);
+  }
+  state.model = appearance.model;
+  state.block = appearance.block;
+
+  return state;
+}
+
+void dequantizeEntity(const EntityState& state, PhysicsBody& body, Appearance& appearance) {
+  const int64_t chunkUnits = (int64_t)SECTION_SIZE * ENTITY_POSITION_SCALE;
+  // Floor division, positions west and north of the origin have negative chunks
+  int64_t chunkX = state.position[0] >= 0 ? state.position[0] / chunkUnits : -((-state.position[0] - 1) / chunkUnits) - 1;
+  int64_t chunkZ = state.position[2] >= 0 ? state.position[2] / chunkUnits : -((-state.position[2] - 1) / chunkUnits) - 1;
+  glm::vec3 local((float)(state.position[0] - chunkX * chunkUnits) / ENTITY_POSITION_SCALE, (float)state.position[1] / ENTITY_POSITION_SCALE,
+    (float)(state.position[2] - chunkZ * chunkUnits) / ENTITY_POSITION_SCALE);
+
+  body = createBody(WorldPosition(chunkX, chunkZ, local), state.width, state.height, 0.0f);
+  for (int i = 0; i < 3; i++) {
+    body.velocity[i] = (float)state.velocity[i] / ENTITY_VELOCITY_SCALE;
+  }
+
+  appearance.color = glm::vec3(state.color[0], state.color[1], state.color[2]) / 255.0f;
+  appearance.scale = state.scale;
+  appearance.yaw = state.yaw * (6.2831853f / (1 << ENTITY_YAW_BITS));
+  appearance.model = state.model;
+  appearance.block = state.block;
+}
+
+SnapshotHistory::SnapshotHistory() {
+  for (int i = 0; i < SNAPSHOT_HISTORY; i++) {
+    snapshots[i].tick = 0;
+  }
+}
+
+EntitySnapshot& SnapshotHistory::add(uint32_t tick) {
+  EntitySnapshot& snapshot = snapshots[tick & (SNAPSHOT_HISTORY - 1)];
+  snapshot.tick = tick;
+  snapshot.entities.clear();
+
+  return snapshot;
+}
+
+const EntitySnapshot* SnapshotHistory::find(uint32_t tick) const {
+  const EntitySnapshot& snapshot = snapshots[tick & (SNAPSHOT_HISTORY - 1)];
+
+  return tick != 0 && snapshot.tick == tick ? &snapshot : NULL;
+}
+
+static uint8_t changedFields(const EntityState& state, const EntityState& baseline) {
+  uint8_t fields = 0;
+  if (state.position[0] != baseline.position[0] || state.position[1] != baseline.position[1] || state.position[2] != baseline.position[2]) {
+    fields |= FIELD_POSITION;
+  }
+  if (state.velocity[0] != baseline.velocity[0] || state.velocity[1] != baseline.velocity[1] || state.velocity[2] != baseline.velocity[2]) {
+    fields |= FIELD_VELOCITY;
+  }
+  if (state.yaw != baseline.yaw) {
+    fields |= FIELD_YAW;
+  }
+
+  return fields;
+}
+
+static void writeFloat(BitWriter& writer, float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  writer.bits(bits, 32);
+}
+
+static float readFloat(BitReader& reader) {
+  uint32_t bits = reader.bits(32);
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+
+  return value;
+}
+
+void encodeSnapshot(const EntitySnapshot& snapshot, const EntitySnapshot* baseline, std::vector<uint8_t>& out) {
+  ByteWriter header(out);
+  header.u8(MSG_ENTITY_SNAPSHOT);
+  header.u32(snapshot.tick);
+  header.u32(baseline ? baseline->tick : 0);
+
+  static const std::vector<EntityState> none;
+  const std::vector<EntityState>& before = baseline ? baseline->entities : none;
+  const std::vector<EntityState>& after = snapshot.entities;
+
+  // Both lists are sorted by index, walk them side by side. An index whose generation changed is a removal plus an
+  // addition.
+  static thread_local std::vector<uint32_t> removed;
+  static thread_local std::vector<std::pair<const EntityState*, const EntityState*>> updated;
+  removed.clear();
+  updated.clear();
+
+  size_t i = 0;
+  size_t j = 0;
+  while (i < before.size() || j < after.size()) {
+    if (j == after.size() || (i < before.size() && before[i].entity.index < after[j].entity.index)) {
+      removed.push_back(before[i++].entity.index);
+    }
+    else if (i == before.size() || after[j].entity.index < before[i].entity.index) {
+      updated.push_back(std::make_pair(&after[j++], (const EntityState*)NULL));
+    }
+    else {
+      if (before[i].entity.generation != after[j].entity.generation) {
+        removed.push_back(before[i].entity.index);
+        updated.push_back(std::make_pair(&after[j], (const EntityState*)NULL));
+      }
+      else if (changedFields(after[j], before[i])) {
+        updated.push_back(std::make_pair(&after[j], &before[i]));
+      }
+      i++;
+      j++;
+    }
+  }
+
+  BitWriter writer(out);
+  writer.varUnsigned(removed.size());
+  uint32_t previous = 0;
+  for (size_t k = 0; k < removed.size(); k++) {
+    writer.varUnsigned(removed[k] - previous);
+    previous = removed[k];
+  }
+
+  writer.varUnsigned(updated.size());
+  previous = 0;
+  for (size_t k = 0; k < updated.size(); k++) {
+    const EntityState& state = *updated[k].first;
+    const EntityState* base = updated[k].second;
+    writer.varUnsigned(state.entity.index - previous);
+    previous = state.entity.index;
+
+    writer.flag(base == NULL);
+    if (!base) {
+      writer.varUnsigned(state.entity.generation);
+      for (int a = 0; a < 3; a++) {
+        writer.varSigned(state.position[a]);
+      }
+      for (int a = 0; a < 3; a++) {
+        writer.varSigned(state.velocity[a]);
+      }
+      writer.bits(state.yaw, ENTITY_YAW_BITS);
+      writeFloat(writer, state.width);
+      writeFloat(writer, state.height);
+      writeFloat(writer, state.scale);
+      writer.bits(state.color[0], 8);
+      writer.bits(state.color[1], 8);
+      writer.bits(state.color[2], 8);
+      writer.bits(state.model, 8);
+      writer.bits(state.block, 16);
+      continue;
+    }
+
+    uint8_t fields = changedFields(state, *base);
+    writer.bits(fields, FIELD_COUNT);
+    if (fields & FIELD_POSITION) {
+      for (int a = 0; a < 3; a++) {
+        writer.varSigned(state.position[a] - base->position[a]);
+      }
+    }
+    if (fields & FIELD_VELOCITY) {
+      for (int a = 0; a < 3; a++) {
+        writer.varSigned(state.velocity[a]);
+      }
+    }
+    if (fields & FIELD_YAW) {
+      writer.bits(state.yaw, ENTITY_YAW_BITS);
+    }
+  }
+  writer.flush();
+}
+
+bool decodeSnapshot(const uint8_t* data, size_t size, const SnapshotHistory& history, EntitySnapshot& out) {
+  ByteReader header(data, size);
+  uint8_t type = header.u8();
+  uint32_t tick = header.u32();
+  uint32_t baselineTick = header.u32();
+  if (!header.ok || type != MSG_ENTITY_SNAPSHOT || tick == 0) {
+    return false;
+  }
+
+  const EntitySnapshot* baseline = NULL;
+  if (baselineTick != 0) {
+    baseline = history.find(baselineTick);
+    if (!baseline) {
+      return false;
+    }
+  }
+
+  out.tick = tick;
+  out.entities.clear();
+
+  BitReader reader(data + header.pos, size - header.pos);
+
+  // Baseline entities minus the removed ones
+  static thread_local std::vector<EntityState> kept;
+  kept.clear();
+  uint64_t removedCount = reader.varUnsigned();
+  uint32_t index = 0;
+  size_t next = 0;
+  for (uint64_t k = 0; k < removedCount && reader.ok; k++) {
+    index += (uint32_t)reader.varUnsigned();
+    while (baseline && next < baseline->entities.size() && baseline->entities[next].entity.index < index) {
+      kept.push_back(baseline->entities[next++]);
+    }
+    if (!baseline || next == baseline->entities.size() || baseline->entities[next].entity.index != index) {
+      return false;
+    }
+    next++;
+  }
+  while (baseline && next < baseline->entities.size()) {
+    kept.push_back(baseline->entities[next++]);
+  }
+
+  // Merge the updates into the kept entities, both in index order
+  uint64_t updateCount = reader.varUnsigned();
+  if (!reader.ok || updateCount > SNAPSHOT_MAX_ENTITIES) {
+    return false;
+  }
+  index = 0;
+  next = 0;
+  for (uint64_t k = 0; k < updateCount; k++) {
+    index += (uint32_t)reader.varUnsigned();
+    while (next < kept.size() && kept[next].entity.index < index) {
+      out.entities.push_back(kept[next++]);
+    }
+    bool isNew = reader.flag();
+    bool known = next < kept.size() && kept[next].entity.index == index;
+    if (!reader.ok || isNew == known) {
+      return false;
+    }
+
+    EntityState state;
+    if (isNew) {
+      state.entity.index = index;
+      state.entity.generation = (uint32_t)reader.varUnsigned();
+      for (int a = 0; a < 3; a++) {
+        state.position[a] = reader.varSigned();
+      }
+      for (int a = 0; a < 3; a++) {
+        state.velocity[a] = (int32_t)reader.varSigned();
+      }
+      state.yaw = (uint16_t)reader.bits(ENTITY_YAW_BITS);
+      state.width = readFloat(reader);
+      state.height = readFloat(reader);
+      state.scale = readFloat(reader);
+      state.color[0] = (uint8_t)reader.bits(8);
+      state.color[1] = (uint8_t)reader.bits(8);
+      state.color[2] = (uint8_t)reader.bits(8);
+      uint32_t model = reader.bits(8);
+      state.block = (BlockID)reader.bits(16);
+      if (model >= MODEL_COUNT) {
+        return false;
+      }
+      state.model = (ModelID)model;
+    }
+    else {
+      state = kept[next++];
+      uint32_t fields = reader.bits(FIELD_COUNT);
+      if (fields & FIELD_POSITION) {
+        for (int a = 0; a < 3; a++) {
+          state.position[a] += reader.varSigned();
+        }
+      }
+      if (fields & FIELD_VELOCITY) {
+        for (int a = 0; a < 3; a++) {
+          state.velocity[a] = (int32_t)reader.varSigned();
+        }
+      }
+      if (fields & FIELD_YAW) {
+        state.yaw = (uint16_t)reader.bits(ENTITY_YAW_BITS);
+      }
+    }
+
+    if (!reader.ok) {
+      return false;
+    }
+    out.entities.push_back(state);
+  }
+  while (next < kept.size()) {
+    out.entities.push_back(kept[next++]);
+  }
+
+  return reader.ok;
+}
+
+void encodeSnapshotAck(uint32_t tick, std::vector<uint8_t>& out) {
+  ByteWriter writer(out);
+  writer.u8(MSG_SNAPSHOT_ACK);
+  writer.u32(tick);
+}
+
+bool decodeSnapshotAck(const uint8_t* data, size_t size, uint32_t& tick) {
+  ByteReader reader(data, size);
+  if (reader.u8() != MSG_SNAPSHOT_ACK) {
+    return false;
+  }
+  tick = reader.u32();
+
+  return reader.ok && reader.remaining() == 0;
+}
+
+bool RemoteEntities::apply(const uint8_t* data, size_t size, Registry& registry) {
+  if (!decodeSnapshot(data, size, history, decoded) || decoded.tick <= tick) {
+    return false;
+  }
+  tick = decoded.tick;
+
+  for (size_t i = 0; i < decoded.entities.size(); i++) {
+    const EntityState& state = decoded.entities[i];
+
+    auto it = entities.find(state.entity);
+    if (it == entities.end()) {
+      Mirror mirror = { registry.create<PhysicsBody, Appearance>(), tick };
+      it = entities.insert(std::make_pair(state.entity, mirror)).first;
+    }
+    it->second.tick = tick;
+    dequantizeEntity(state, *registry.get<PhysicsBody>(it->second.local), *registry.get<Appearance>(it->second.local));
+  }
+
+  // Whatever wasn't in the snapshot left the view
+  if (entities.size() > decoded.entities.size()) {
+    for (auto it = entities.begin(); it != entities.end();) {
+      if (it->second.tick != tick) {
+        registry.destroy(it->second.local);
+        it = entities.erase(it);
+      }
+      else {
+        ++it;
+      }
+    }
+  }
+
+  history.add(tick).entities.swap(decoded.entities);
+  return true;
+}
+
+Entity RemoteEntities::find(Entity remote) const {
+  auto it = entities.find(remote);
+
+  return it == entities.end() ? ENTITY_NULL : it->second.local;
+}
+
+void RemoteEntities::clear(Registry& registry) {
+  for (auto it = entities.begin(); it != entities.end(); ++it) {
+    registry.destroy(it->second.local);
+  }
+  entities.clear();
+}
+
+void encodePlayerInputs(const PlayerInput* inputs, size_t count, std::vector<uint8_t>& out) {
+  ByteWriter writer(out);
+  writer.u8(MSG_PLAYER_INPUT);
+  writer.u8((uint8_t)count);
+  for (size_t i = 0; i < count; i++) {
+    writer.u32(inputs[i].sequence);
+    writer.f32(inputs[i].yaw);
+    writer.u8(inputs[i].keys);
+  }
+}
+
+bool decodePlayerInputs(const uint8_t* data, size_t size, std::vector<PlayerInput>& out) {
+  ByteReader reader(data, size);
+  if (reader.u8() != MSG_PLAYER_INPUT) {
+    return false;
+  }
+
+  int count = reader.u8();
+  if (count > PLAYER_INPUTS_PER_MESSAGE) {
+    return false;
+  }
+  for (int i = 0; i < count; i++) {
+    PlayerInput input;
+    input.sequence = reader.u32();
+    input.yaw = reader.f32();
+    input.keys = reader.u8();
+    if (!isfinite(input.yaw) || (input.keys & ~KEY_ALL)) {
+      return false;
+    }
+    out.push_back(input);
+  }
+
+  return reader.ok && reader.remaining() == 0;
+}
+
+void encodePlayerState(uint32_t lastInput, const PhysicsBody& body, std::vector<uint8_t>& out) {
+  ByteWriter writer(out);
+  writer.u8(MSG_PLAYER_STATE);
+  writer.u32(lastInput);
+  writeBody(writer, body);
+  writer.u8(body.onGround);
+}
+
+bool decodePlayerState(const uint8_t* data, size_t size, uint32_t& lastInput, PhysicsBody& body) {
+  ByteReader reader(data, size);
+  if (reader.u8() != MSG_PLAYER_STATE) {
+    return false;
+  }
+  lastInput = reader.u32();
+  readBody(reader, body);
+  body.onGround = reader.u8() != 0;
+
+  return reader.ok && reader.remaining() == 0;
+}
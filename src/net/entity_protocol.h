@@ -0,0 +1,132 @@
+/* entity_protocol.h */
+
+#ifndef ENTITY_PROTOCOL_HEADER_H
+#define ENTITY_PROTOCOL_HEADER_H
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+#include "../ecs/registry.h"
+#include "../entity/components.h"
+#include "../entity/player.h"
+#include "../util/byte_buffer.h"
+#include "protocol.h"
+
+// Quantization of replicated entity state: positions in 1/256 blocks, velocities in 1/64 blocks per second and the
+// yaw in 1024 steps per turn
+#define ENTITY_POSITION_SCALE 256
+#define ENTITY_VELOCITY_SCALE 64
+#define ENTITY_YAW_BITS 10
+// Snapshots remembered on both ends, a power of two. Deltas are only ever encoded against a baseline this recent.
+#define SNAPSHOT_HISTORY 32
+// Entities in one snapshot, keeps a worst case snapshot (all entities new) well below NET_MAX_MESSAGE
+#define SNAPSHOT_MAX_ENTITIES 512
+
+// Changed-field bits of an entity in a delta
+enum EntityField : uint8_t {
+  FIELD_POSITION = 1,
+  FIELD_VELOCITY = 2,
+  FIELD_YAW = 4,
+
+  FIELD_COUNT = 3
+};
+
+// Replicated state of one entity, quantized so the server and the client compute deltas from identical values
+struct EntityState {
+  // Server side handle, the generation tells a reused slot apart from the entity that held it before
+  Entity entity;
+
+  // World block coordinates times ENTITY_POSITION_SCALE, exact anywhere in the world
+  int64_t position[3];
+  int32_t velocity[3];
+  uint16_t yaw;
+
+  // Only sent when the entity enters a client's view
+  float width;
+  float height;
+  float scale;
+  uint8_t color[3];
+  ModelID model;
+  BlockID block;
+};
+
+EntityState quantizeEntity(Entity entity, const PhysicsBody& body, const Appearance& appearance);
+void dequantizeEntity(const EntityState& state, PhysicsBody& body, Appearance& appearance);
+
+// Every entity a client sees at one server tick, sorted by entity index
+struct EntitySnapshot {
+  uint32_t tick;
+  std::vector<EntityState> entities;
+};
+
+// The last SNAPSHOT_HISTORY snapshots by tick
+class SnapshotHistory {
+public:
+  SnapshotHistory();
+
+  // Slot for the snapshot of 'tick', overwrites the snapshot SNAPSHOT_HISTORY ticks older
+  EntitySnapshot& add(uint32_t tick);
+  // NULL for tick 0 and for snapshots that were overwritten or never added
+  const EntitySnapshot* find(uint32_t tick) const;
+
+private:
+  EntitySnapshot snapshots[SNAPSHOT_HISTORY];
+};
+
+// MSG_ENTITY_SNAPSHOT: [type][tick u32][baseline tick u32, 0 for none][bit-packed body]. The body lists the entities of
+// the baseline that are gone, then the entities that are new or changed. New entities carry their full state, changed
+// ones a changed-field mask followed by the fields in the mask; positions as the difference to the baseline, the rest
+// as is. Unchanged entities cost nothing. Entity indices are sent as gaps to the previous index.
+void encodeSnapshot(const EntitySnapshot& snapshot, const EntitySnapshot* baseline, std::vector<uint8_t>& out);
+// Decodes a snapshot, taking the baseline it names from 'history'. Returns false for corrupt messages and for
+// baselines that aren't in the history.
+bool decodeSnapshot(const uint8_t* data, size_t size, const SnapshotHistory& history, EntitySnapshot& out);
+
+// MSG_SNAPSHOT_ACK, client to server: [type][tick]. The newest acknowledged snapshot becomes the baseline.
+void encodeSnapshotAck(uint32_t tick, std::vector<uint8_t>& out);
+bool decodeSnapshotAck(const uint8_t* data, size_t size, uint32_t& tick);
+
+// Mirrors the server's entities in a client registry, as entities with a PhysicsBody and an Appearance
+class RemoteEntities {
+public:
+  RemoteEntities() : tick(0) {}
+
+  // Applies a MSG_ENTITY_SNAPSHOT, returns false when it couldn't be decoded. On success lastTick() is the snapshot
+  // to acknowledge.
+  bool apply(const uint8_t* data, size_t size, Registry& registry);
+
+  // Local entity of a server entity, ENTITY_NULL when it isn't in view
+  Entity find(Entity remote) const;
+  size_t size() const { return entities.size(); }
+  uint32_t lastTick() const { return tick; }
+
+  // Destroys every mirrored entity, e.g. after losing the connection
+  void clear(Registry& registry);
+
+private:
+  struct Mirror {
+    Entity local;
+    uint32_t tick;
+  };
+
+  SnapshotHistory history;
+  EntitySnapshot decoded;
+  std::unordered_map<Entity, Mirror, EntityHash> entities;
+  uint32_t tick;
+};
+
+// Most inputs in one MSG_PLAYER_INPUT message
+#define PLAYER_INPUTS_PER_MESSAGE 32
+
+// MSG_PLAYER_INPUT, client to server: [type][count u8][count times sequence, yaw, keys]
+void encodePlayerInputs(const PlayerInput* inputs, size_t count, std::vector<uint8_t>& out);
+// Appends the inputs to 'out', returns false for corrupt messages
+bool decodePlayerInputs(const uint8_t* data, size_t size, std::vector<PlayerInput>& out);
+
+// MSG_PLAYER_STATE, server to client: [type][last applied input][position, velocity, on ground]
+void encodePlayerState(uint32_t lastInput, const PhysicsBody& body, std::vector<uint8_t>& out);
+// Only the moving state of 'body' is read, its size is left alone
+bool decodePlayerState(const uint8_t* data, size_t size, uint32_t& lastInput, PhysicsBody& body);
+
+#endif
@@ -0,0 +1,820 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <algorithm>
+#include <string>
+
+#include "net_loop.h"
+
+#ifdef NET_EPOLL
+#include <sys/epoll.h>
+#endif
+
+using namespace std;
+
+// Tags of the two sockets that aren't connections, connection ids fit into the low 32 bits
+#define LISTEN_TAG (1ull << 32)
+#define DATAGRAM_TAG ((1ull << 32) + 1)
+
+// Event flags
+#define EVENT_IN 1
+#define EVENT_OUT 2
+#define EVENT_HANGUP 4
+#define EVENT_ERROR 8
+
+// Systems without it (macOS) get SO_NOSIGPIPE set on every socket instead
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define FRAME_HEADER 4
+
+// Seconds a lost stream message is late, at least this or two round trips of latency like a TCP retransmission
+#define LINK_RETRANSMIT_DELAY 0.2
+
+NetAddress NetAddress::resolve(const char* host, uint16_t port) {
+  NetAddress result;
+  memset(&result.address, 0, sizeof(result.address));
+  result.address.sin_family = AF_INET;
+  result.address.sin_port = htons(port);
+  if (inet_pton(AF_INET, host, &result.address.sin_addr) != 1) {
+    throw(string)"ERROR::NET::INVALID_ADDRESS " + host;
+  }
+
+  return result;
+}
+
+static NetAddress localAddress(int fd) {
+  NetAddress result;
+  socklen_t length = sizeof(result.address);
+  getsockname(fd, (sockaddr*)&result.address, &length);
+  return result;
+}
+
+static bool wouldBlock() {
+  return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+#ifndef __linux__
+// Makes a new socket non-blocking and close-on-exec, which Linux does through the socket() and accept4() flags
+static int configure(int fd) {
+  if (fd >= 0) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+    int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+  }
+  return fd;
+}
+#endif
+
+static int openSocket(int type) {
+#ifdef __linux__
+  return socket(AF_INET, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+#else
+  return configure(socket(AF_INET, type, 0));
+#endif
+}
+
+static int acceptSocket(int listenFd) {
+#ifdef __linux__
+  return accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+  return configure(accept(listenFd, NULL, NULL));
+#endif
+}
+
+NetLoop::Connection::Connection(ConnectionId id, int fd, bool established) :
+  id(id), fd(fd), established(established), closing(false), dirty(false), input(NET_RECEIVE_BUFFER), output(NET_SEND_BUFFER) {
+}
+
+NetLoop::NetLoop() {
+#ifdef NET_EPOLL
+  epollFd = epoll_create1(EPOLL_CLOEXEC);
+  if (epollFd < 0) {
+    throw(string)"ERROR::NET::EPOLL_FAILED";
+  }
+#endif
+
+  listenFd = -1;
+  reserveFd = -1;
+  datagramFd = -1;
+  listenAddress = NetAddress::resolve("0.0.0.0", 0);
+  datagramAddress = listenAddress;
+  nextId = CONNECTION_NONE + 1;
+  memset(&stats, 0, sizeof(stats));
+  emulating = false;
+  random = 0x9E3779B9u;
+  delayed = 0;
+}
+
+NetLoop::~NetLoop() {
+  for (auto& entry : connections) {
+    ::close(entry.second->fd);
+    delete entry.second;
+  }
+  if (listenFd >= 0) {
+    ::close(listenFd);
+  }
+  if (reserveFd >= 0) {
+    ::close(reserveFd);
+  }
+  if (datagramFd >= 0) {
+    ::close(datagramFd);
+  }
+#ifdef NET_EPOLL
+  ::close(epollFd);
+#endif
+}
+
+void NetLoop::listen(uint16_t port, const char* host) {
+  NetAddress address = NetAddress::resolve(host, port);
+
+  int fd = openSocket(SOCK_STREAM);
+  if (fd < 0) {
+    throw(string)"ERROR::NET::SOCKET_FAILED";
+  }
+
+  int enable = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+  if (bind(fd, (sockaddr*)&address.address, sizeof(address.address)) < 0 || ::listen(fd, SOMAXCONN) < 0) {
+    ::close(fd);
+    throw(string)"ERROR::NET::LISTEN_FAILED " + host + ":" + to_string(port) + " " + strerror(errno);
+  }
+
+  if (!watch(fd, LISTEN_TAG)) {
+    ::close(fd);
+    throw(string)"ERROR::NET::EPOLL_FAILED";
+  }
+
+  listenFd = fd;
+  listenAddress = localAddress(fd);
+  if (reserveFd < 0) {
+    reserveFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+  }
+}
+
+void NetLoop::openDatagram(uint16_t port, const char* host) {
+  NetAddress address = NetAddress::resolve(host, port);
+
+  int fd = openSocket(SOCK_DGRAM);
+  if (fd < 0) {
+    throw(string)"ERROR::NET::SOCKET_FAILED";
+  }
+
+  if (bind(fd, (sockaddr*)&address.address, sizeof(address.address)) < 0) {
+    ::close(fd);
+    throw(string)"ERROR::NET::BIND_FAILED " + host + ":" + to_string(port) + " " + strerror(errno);
+  }
+
+  if (!watch(fd, DATAGRAM_TAG)) {
+    ::close(fd);
+    throw(string)"ERROR::NET::EPOLL_FAILED";
+  }
+
+  datagramFd = fd;
+  datagramAddress = localAddress(fd);
+}
+
+ConnectionId NetLoop::connect(const char* host, uint16_t port) {
+  NetAddress address = NetAddress::resolve(host, port);
+
+  int fd = openSocket(SOCK_STREAM);
+  if (fd < 0) {
+    throw(string)"ERROR::NET::SOCKET_FAILED";
+  }
+
+  int result = ::connect(fd, (sockaddr*)&address.address, sizeof(address.address));
+  bool failed = result < 0 && errno != EINPROGRESS;
+
+  // Even a connect that completed right away is reported from poll(), the socket shows up as writable
+  ConnectionId id = add(fd, false);
+  if (failed && id != CONNECTION_NONE) {
+    close(find(id));
+  }
+
+  return id;
+}
+
+ConnectionId NetLoop::add(int fd, bool established) {
+  // Messages are batched by flush(), Nagle would only add latency
+  int enable = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+  ConnectionId id = nextId++;
+  if (nextId == CONNECTION_NONE) {
+    nextId++;
+  }
+
+  if (!watch(fd, id)) {
+    ::close(fd);
+    return CONNECTION_NONE;
+  }
+
+  connections[id] = new Connection(id, fd, established);
+  return id;
+}
+
+bool NetLoop::watch(int fd, uint64_t tag) {
+#ifdef NET_EPOLL
+  epoll_event event;
+  event.events = tag == LISTEN_TAG || tag == DATAGRAM_TAG ? EPOLLIN | EPOLLET : EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+  event.data.u64 = tag;
+  return epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == 0;
+#else
+  return true;
+#endif
+}
+
+void NetLoop::unwatch(int fd) {
+#ifdef NET_EPOLL
+  epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+#endif
+}
+
+int NetLoop::wait(int timeoutMs) {
+  events.clear();
+
+#ifdef NET_EPOLL
+  epoll_event ready[NET_MAX_EVENTS];
+  int count = epoll_wait(epollFd, ready, NET_MAX_EVENTS, timeoutMs);
+  if (count < 0) {
+    if (errno != EINTR) {
+      throw(string)"ERROR::NET::EPOLL_WAIT_FAILED";
+    }
+    return 0;
+  }
+
+  for (int i = 0; i < count; i++) {
+    uint32_t flags = ready[i].events;
+    Event event;
+    event.tag = ready[i].data.u64;
+    event.flags = (flags & EPOLLIN ? EVENT_IN : 0) | (flags & EPOLLOUT ? EVENT_OUT : 0) |
+      (flags & (EPOLLRDHUP | EPOLLHUP) ? EVENT_HANGUP : 0) | (flags & EPOLLERR ? EVENT_ERROR : 0);
+    events.push_back(event);
+  }
+#else
+  // Level-triggered, so writability is only asked for while there is something to write or a connect to finish
+  pollFds.clear();
+  pollTags.clear();
+  if (listenFd >= 0) {
+    pollFds.push_back({ listenFd, POLLIN, 0 });
+    pollTags.push_back(LISTEN_TAG);
+  }
+  if (datagramFd >= 0) {
+    pollFds.push_back({ datagramFd, POLLIN, 0 });
+    pollTags.push_back(DATAGRAM_TAG);
+  }
+  for (auto& entry : connections) {
+    Connection* connection = entry.second;
+    if (connection->closing) {
+      continue;
+    }
+    short wanted = !connection->established || !connection->output.empty() ? POLLIN | POLLOUT : POLLIN;
+    pollFds.push_back({ connection->fd, wanted, 0 });
+    pollTags.push_back(entry.first);
+  }
+
+  int count = ::poll(pollFds.data(), (nfds_t)pollFds.size(), timeoutMs);
+  if (count < 0) {
+    if (errno != EINTR) {
+      throw(string)"ERROR::NET::POLL_FAILED";
+    }
+    return 0;
+  }
+
+  for (size_t i = 0; i < pollFds.size(); i++) {
+    short flags = pollFds[i].revents;
+    if (flags == 0) {
+      continue;
+    }
+
+    Event event;
+    event.tag = pollTags[i];
+    event.flags = (flags & POLLIN ? EVENT_IN : 0) | (flags & POLLOUT ? EVENT_OUT : 0) |
+      (flags & POLLHUP ? EVENT_HANGUP : 0) | (flags & (POLLERR | POLLNVAL) ? EVENT_ERROR : 0);
+    events.push_back(event);
+  }
+#endif
+
+  return (int)events.size();
+}
+
+NetLoop::Connection* NetLoop::find(ConnectionId id) const {
+  auto it = connections.find(id);
+  return it == connections.end() ? NULL : it->second;
+}
+
+void NetLoop::close(Connection* connection) {
+  if (!connection->closing) {
+    connection->closing = true;
+    closing.push_back(connection->id);
+  }
+}
+
+void NetLoop::disconnect(ConnectionId id) {
+  Connection* connection = find(id);
+  if (connection) {
+    close(connection);
+  }
+}
+
+bool NetLoop::connected(ConnectionId id) const {
+  Connection* connection = find(id);
+  return connection && connection->established && !connection->closing;
+}
+
+size_t NetLoop::pendingOutput(ConnectionId id) const {
+  Connection* connection = find(id);
+  return connection ? connection->output.size() + connection->delayedOut.bytes : 0;
+}
+
+void NetLoop::setLink(const LinkConditions& outgoing, const LinkConditions& incoming) {
+  outgoingLink = outgoing;
+  incomingLink = incoming;
+  emulating = outgoing.active() || incoming.active();
+}
+
+bool NetLoop::send(ConnectionId id, const void* data, size_t size) {
+  Connection* connection = find(id);
+  if (!connection || connection->closing) {
+    return false;
+  }
+
+  if (size > NET_MAX_MESSAGE || pendingOutput(id) + FRAME_HEADER + size > connection->output.capacity()) {
+    close(connection);
+    return false;
+  }
+
+  uint8_t header[FRAME_HEADER] = { (uint8_t)size, (uint8_t)(size >> 8), (uint8_t)(size >> 16), (uint8_t)(size >> 24) };
+  stats.messagesSent++;
+
+  // Output still held back keeps later messages behind it after emulation is turned off
+  if (emulating || !connection->delayedOut.messages.empty()) {
+    Delayed message;
+    message.due = schedule(outgoingLink, &connection->delayedOut, FRAME_HEADER + size);
+    message.data.assign(header, header + FRAME_HEADER);
+    message.data.insert(message.data.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+    connection->delayedOut.bytes += message.data.size();
+    connection->delayedOut.messages.push_back(std::move(message));
+    delayed++;
+    return true;
+  }
+
+  connection->output.write(header, FRAME_HEADER);
+  connection->output.write(data, size);
+
+  if (!connection->dirty) {
+    connection->dirty = true;
+    dirty.push_back(id);
+  }
+  return true;
+}
+
+bool NetLoop::sendDatagram(const NetAddress& to, const void* data, size_t size) {
+  if (datagramFd < 0 || size > NET_MAX_DATAGRAM) {
+    return false;
+  }
+
+  if (outgoingLink.active()) {
+    // Lost on the way, as far as the sender can tell it was sent
+    if (uniform() < outgoingLink.loss) {
+      stats.emulatedLosses++;
+      return true;
+    }
+
+    DelayedDatagram datagram;
+    datagram.due = now() + (outgoingLink.latency + uniform() * outgoingLink.jitter) / 1000.0;
+    datagram.address = to;
+    datagram.data.assign((const uint8_t*)data, (const uint8_t*)data + size);
+    delayedDatagramsOut.push_back(std::move(datagram));
+    delayed++;
+    return true;
+  }
+
+  return transmitDatagram(to, data, size);
+}
+
+bool NetLoop::transmitDatagram(const NetAddress& to, const void* data, size_t size) {
+  ssize_t result = sendto(datagramFd, data, size, MSG_NOSIGNAL, (const sockaddr*)&to.address, sizeof(to.address));
+  if (result < 0) {
+    stats.datagramsDropped++;
+    return false;
+  }
+
+  stats.datagramsSent++;
+  return true;
+}
+
+int NetLoop::poll(int timeoutMs, NetHandler& handler) {
+  // Wake up for held back messages that fall due before the timeout
+  if (delayed > 0) {
+    int next = nextDelayed();
+    if (timeoutMs < 0 || next < timeoutMs) {
+      timeoutMs = next;
+    }
+  }
+
+  int count = wait(timeoutMs);
+  for (int i = 0; i < count; i++) {
+    uint64_t tag = events[i].tag;
+    uint32_t flags = events[i].flags;
+
+    if (tag == LISTEN_TAG) {
+      accept(handler);
+      continue;
+    }
+    if (tag == DATAGRAM_TAG) {
+      receiveDatagrams(handler);
+      continue;
+    }
+
+    Connection* connection = find((ConnectionId)tag);
+    if (!connection || connection->closing) {
+      continue;
+    }
+
+    if (!connection->established) {
+      int error = 0;
+      socklen_t length = sizeof(error);
+      getsockopt(connection->fd, SOL_SOCKET, SO_ERROR, &error, &length);
+      if (error != 0 || (flags & EVENT_ERROR)) {
+        close(connection);
+        continue;
+      }
+      if (!(flags & EVENT_OUT)) {
+        continue;
+      }
+
+      connection->established = true;
+      handler.onConnect(connection->id);
+    }
+
+    if (flags & (EVENT_IN | EVENT_HANGUP | EVENT_ERROR)) {
+      receive(connection, handler);
+    }
+    // Covers both the kernel taking more output after a full socket buffer and messages queued before connecting
+    if ((flags & EVENT_OUT) && !connection->closing) {
+      write(connection);
+    }
+  }
+
+  if (delayed > 0) {
+    releaseDelayed(handler);
+  }
+
+  flush();
+  reap(handler);
+  return count;
+}
+
+void NetLoop::accept(NetHandler& handler) {
+  for (;;) {
+    int fd = acceptSocket(listenFd);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      // Out of descriptors. Edge-triggered, the listener won't report the connections left in the backlog again (and
+      // with poll() it would keep reporting them), so free the spare descriptor to accept and close them one by one
+      // until the backlog is empty.
+      if ((errno == EMFILE || errno == ENFILE) && reserveFd >= 0) {
+        ::close(reserveFd);
+        fd = acceptSocket(listenFd);
+        int error = errno;
+        if (fd >= 0) {
+          ::close(fd);
+        }
+        reserveFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+        if (fd >= 0 || error == EINTR || error == ECONNABORTED) {
+          continue;
+        }
+      }
+      // EAGAIN once the backlog is empty
+      return;
+    }
+
+    ConnectionId id = add(fd, true);
+    if (id != CONNECTION_NONE) {
+      handler.onConnect(id);
+    }
+  }
+}
+
+void NetLoop::receive(Connection* connection, NetHandler& handler) {
+  // Read until the kernel has nothing left, with epoll there won't be another event for data already there
+  for (;;) {
+    struct iovec spans[2];
+    int spanCount = connection->input.freeSpans(spans);
+    if (spanCount == 0) {
+      // Only a message longer than the buffer can fill it up, and those are rejected by dispatch()
+      close(connection);
+      return;
+    }
+
+    ssize_t result = readv(connection->fd, spans, spanCount);
+    if (result > 0) {
+      connection->input.commit((size_t)result);
+      stats.bytesReceived += (uint64_t)result;
+      if (!dispatch(connection, handler)) {
+        close(connection);
+      }
+      if (connection->closing) {
+        return;
+      }
+      continue;
+    }
+
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result < 0 && wouldBlock()) {
+      return;
+    }
+
+    // Closed by the peer or failed
+    close(connection);
+    return;
+  }
+}
+
+bool NetLoop::dispatch(Connection* connection, NetHandler& handler) {
+  RingBuffer& input = connection->input;
+
+  while (!connection->closing && input.size() >= FRAME_HEADER) {
+    uint8_t header[FRAME_HEADER];
+    input.peek(header, FRAME_HEADER);
+    size_t size = (size_t)header[0] | ((size_t)header[1] << 8) | ((size_t)header[2] << 16) | ((size_t)header[3] << 24);
+    if (size > NET_MAX_MESSAGE) {
+      return false;
+    }
+    if (input.size() < FRAME_HEADER + size) {
+      break;
+    }
+
+    // Handed out in place unless the message wraps around the end of the buffer
+    const uint8_t* data = input.contiguous(FRAME_HEADER, size);
+    if (!data) {
+      scratch.resize(size);
+      input.peek(scratch.data(), size, FRAME_HEADER);
+      data = scratch.data();
+    }
+
+    stats.messagesReceived++;
+    if (emulating || !connection->delayedIn.messages.empty()) {
+      Delayed message;
+      message.due = schedule(incomingLink, &connection->delayedIn, FRAME_HEADER + size);
+      message.data.assign(data, data + size);
+      connection->delayedIn.messages.push_back(std::move(message));
+      delayed++;
+    } else {
+      handler.onMessage(connection->id, data, size);
+    }
+    input.consume(FRAME_HEADER + size);
+  }
+
+  return true;
+}
+
+void NetLoop::receiveDatagrams(NetHandler& handler) {
+  uint8_t buffer[NET_MAX_DATAGRAM];
+
+  for (;;) {
+    NetAddress from;
+    struct iovec span = { buffer, sizeof(buffer) };
+    msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_name = &from.address;
+    message.msg_namelen = sizeof(from.address);
+    message.msg_iov = &span;
+    message.msg_iovlen = 1;
+    ssize_t result = recvmsg(datagramFd, &message, 0);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+
+    // The rest of an oversized datagram is gone, it's dropped rather than delivered cut short
+    if (message.msg_flags & MSG_TRUNC) {
+      stats.datagramsDropped++;
+      continue;
+    }
+
+    stats.datagramsReceived++;
+    if (incomingLink.active()) {
+      if (uniform() < incomingLink.loss) {
+        stats.emulatedLosses++;
+        continue;
+      }
+
+      DelayedDatagram datagram;
+      datagram.due = now() + (incomingLink.latency + uniform() * incomingLink.jitter) / 1000.0;
+      datagram.address = from;
+      datagram.data.assign(buffer, buffer + result);
+      delayedDatagramsIn.push_back(std::move(datagram));
+      delayed++;
+      continue;
+    }
+
+    handler.onDatagram(from, buffer, (size_t)result);
+  }
+}
+
+void NetLoop::flush() {
+  for (size_t i = 0; i < dirty.size(); i++) {
+    Connection* connection = find(dirty[i]);
+    if (!connection) {
+      continue;
+    }
+
+    connection->dirty = false;
+    // Connections still connecting are written once the connect completes
+    if (connection->established && !connection->closing) {
+      write(connection);
+    }
+  }
+
+  dirty.clear();
+}
+
+void NetLoop::write(Connection* connection) {
+  RingBuffer& output = connection->output;
+
+  while (!output.empty()) {
+    // All queued messages in one call, the ring buffer is at most two spans
+    struct iovec spans[2];
+    msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = spans;
+    message.msg_iovlen = output.dataSpans(spans);
+
+    ssize_t result = sendmsg(connection->fd, &message, MSG_NOSIGNAL);
+    if (result >= 0) {
+      output.consume((size_t)result);
+      stats.bytesSent += (uint64_t)result;
+      stats.sendCalls++;
+      continue;
+    }
+
+    if (errno == EINTR) {
+      continue;
+    }
+    if (!wouldBlock()) {
+      close(connection);
+    }
+    // Otherwise the next writable event resumes the write
+    return;
+  }
+}
+
+void NetLoop::reap(NetHandler& handler) {
+  // onDisconnect() may close more connections, they are handled by the same loop
+  for (size_t i = 0; i < closing.size(); i++) {
+    auto it = connections.find(closing[i]);
+    if (it == connections.end()) {
+      continue;
+    }
+
+    Connection* connection = it->second;
+    delayed -= connection->delayedOut.messages.size() + connection->delayedIn.messages.size();
+    unwatch(connection->fd);
+    ::close(connection->fd);
+    connections.erase(it);
+    delete connection;
+
+    handler.onDisconnect(closing[i]);
+  }
+
+  closing.clear();
+}
+
+double NetLoop::now() const {
+  timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+double NetLoop::uniform() {
+  // xorshift32, plenty for picking delays and losses
+  random ^= random << 13;
+  random ^= random >> 17;
+  random ^= random << 5;
+  return (double)(random >> 8) / 16777216.0;
+}
+
+double NetLoop::schedule(const LinkConditions& link, DelayedQueue* queue, size_t size) {
+  // The message goes on the wire once the link is done with the previous ones and takes size / bandwidth to transmit
+  double start = max(now(), queue->linkFree);
+  queue->linkFree = start + (link.bandwidth > 0.0 ? (double)size / link.bandwidth : 0.0);
+
+  double due = queue->linkFree + (link.latency + uniform() * link.jitter) / 1000.0;
+  if (link.loss > 0.0 && uniform() < link.loss) {
+    due += max(LINK_RETRANSMIT_DELAY, 2.0 * link.latency / 1000.0);
+    stats.emulatedLosses++;
+  }
+
+  // A stream delivers in order, so jitter and retransmissions delay everything behind a late message
+  due = max(due, queue->lastDue);
+  queue->lastDue = due;
+  return due;
+}
+
+void NetLoop::releaseDelayed(NetHandler& handler) {
+  double time = now();
+
+  // The handler may connect and disconnect, so connections are looked up by id
+  released.clear();
+  for (auto& entry : connections) {
+    if (!entry.second->delayedOut.messages.empty() || !entry.second->delayedIn.messages.empty()) {
+      released.push_back(entry.first);
+    }
+  }
+
+  for (ConnectionId id : released) {
+    Connection* connection = find(id);
+
+    DelayedQueue& out = connection->delayedOut;
+    while (!out.messages.empty() && out.messages.front().due <= time) {
+      // Always fits, send() limits the output and the held back output together to the buffer size
+      Delayed& message = out.messages.front();
+      connection->output.write(message.data.data(), message.data.size());
+      out.bytes -= message.data.size();
+      out.messages.pop_front();
+      delayed--;
+
+      if (!connection->dirty) {
+        connection->dirty = true;
+        dirty.push_back(id);
+      }
+    }
+
+    DelayedQueue& in = connection->delayedIn;
+    while (!connection->closing && !in.messages.empty() && in.messages.front().due <= time) {
+      // Moved out first, the handler may send and so append to the queues
+      Delayed message = std::move(in.messages.front());
+      in.messages.pop_front();
+      delayed--;
+      handler.onMessage(id, message.data.data(), message.data.size());
+    }
+  }
+
+  for (size_t i = 0; i < delayedDatagramsOut.size();) {
+    if (delayedDatagramsOut[i].due <= time) {
+      DelayedDatagram datagram = std::move(delayedDatagramsOut[i]);
+      delayedDatagramsOut[i] = std::move(delayedDatagramsOut.back());
+      delayedDatagramsOut.pop_back();
+      delayed--;
+      transmitDatagram(datagram.address, datagram.data.data(), datagram.data.size());
+    } else {
+      i++;
+    }
+  }
+
+  for (size_t i = 0; i < delayedDatagramsIn.size();) {
+    if (delayedDatagramsIn[i].due <= time) {
+      DelayedDatagram datagram = std::move(delayedDatagramsIn[i]);
+      delayedDatagramsIn[i] = std::move(delayedDatagramsIn.back());
+      delayedDatagramsIn.pop_back();
+      delayed--;
+      handler.onDatagram(datagram.address, datagram.data.data(), datagram.data.size());
+    } else {
+      i++;
+    }
+  }
+}
+
+int NetLoop::nextDelayed() const {
+  double next = -1.0;
+  for (auto& entry : connections) {
+    const Connection* connection = entry.second;
+    if (!connection->delayedOut.messages.empty()) {
+      double due = connection->delayedOut.messages.front().due;
+      next = next < 0.0 ? due : min(next, due);
+    }
+    if (!connection->delayedIn.messages.empty()) {
+      double due = connection->delayedIn.messages.front().due;
+      next = next < 0.0 ? due : min(next, due);
+    }
+  }
+  for (const DelayedDatagram& datagram : delayedDatagramsOut) {
+    next = next < 0.0 ? datagram.due : min(next, datagram.due);
+  }
+  for (const DelayedDatagram& datagram : delayedDatagramsIn) {
+    next = next < 0.0 ? datagram.due : min(next, datagram.due);
+  }
+
+  if (next < 0.0) {
+    return -1;
+  }
+  // Rounded up, waking up early would only poll again
+  return max(0, (int)((next - now()) * 1000.0 + 0.999));
+}
@@ -0,0 +1,246 @@
+/* net_loop.h */
+
+#ifndef NET_LOOP_HEADER_H
+#define NET_LOOP_HEADER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <netinet/in.h>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "ring_buffer.h"
+
+// Linux waits on edge-triggered epoll, other systems (or a build with NET_USE_POLL) on poll() over every socket
+#if defined(__linux__) && !defined(NET_USE_POLL)
+#define NET_EPOLL
+#else
+#include <poll.h>
+#endif
+
+// Largest framed message, a bigger length prefix is a protocol error and closes the connection
+#define NET_MAX_MESSAGE (64 * 1024)
+// Per connection buffers. The receive buffer holds at least one message of the maximum size. Output that hasn't been
+// sent yet is limited to the send buffer: a connection that falls this far behind is dropped instead of buffering
+// forever, senders of bulk data should check pendingOutput() first.
+#define NET_RECEIVE_BUFFER (128 * 1024)
+#define NET_SEND_BUFFER (256 * 1024)
+#define NET_MAX_DATAGRAM 1472
+#define NET_MAX_EVENTS 256
+
+// Never reused within a NetLoop, 0 is never a valid connection
+typedef uint32_t ConnectionId;
+#define CONNECTION_NONE 0
+
+struct NetAddress {
+  sockaddr_in address;
+
+  // Throws when 'host' isn't a dotted IPv4 address
+  static NetAddress resolve(const char* host, uint16_t port);
+  uint16_t port() const { return ntohs(address.sin_port); }
+};
+
+// Conditions of an emulated link, in one direction. The defaults are a perfect link.
+struct LinkConditions {
+  // One way delay in milliseconds, every message gets a random extra delay of up to 'jitter'
+  double latency;
+  double jitter;
+  // Probability of losing a message. Streams retransmit, so a lost stream message arrives a retransmission timeout
+  // late, holding up everything behind it; a lost datagram is gone.
+  double loss;
+  // Bytes per second, 0 for unlimited. Messages queue behind each other like on a slow link.
+  double bandwidth;
+
+  LinkConditions() : latency(0.0), jitter(0.0), loss(0.0), bandwidth(0.0) {}
+
+  bool active() const { return latency > 0.0 || jitter > 0.0 || loss > 0.0 || bandwidth > 0.0; }
+};
+
+// Callbacks of NetLoop::poll(), called on the polling thread. They may send, disconnect and connect freely.
+class NetHandler {
+public:
+  virtual ~NetHandler() {}
+
+  // A connection was accepted, or an outgoing connect() completed
+  virtual void onConnect(ConnectionId id) {}
+  // 'data' is only valid during the call
+  virtual void onMessage(ConnectionId id, const uint8_t* data, size_t size) {}
+  // The peer closed, an error occurred or disconnect() was called; the id is dead from here on
+  virtual void onDisconnect(ConnectionId id) {}
+  virtual void onDatagram(const NetAddress& from, const uint8_t* data, size_t size) {}
+};
+
+struct NetStats {
+  uint64_t messagesSent;
+  uint64_t messagesReceived;
+  uint64_t bytesSent;
+  uint64_t bytesReceived;
+  // sendmsg() calls on streams, fewer than messages when small messages get batched
+  uint64_t sendCalls;
+  uint64_t datagramsSent;
+  uint64_t datagramsReceived;
+  uint64_t datagramsDropped;
+  // Messages and datagrams the link emulator lost (see NetLoop::setLink())
+  uint64_t emulatedLosses;
+};
+
+// Single threaded event loop over non-blocking sockets and edge-triggered epoll, or poll() where there is no epoll;
+// every socket is read and written until it would block either way, so both behave the same. Streams (TCP) carry
+// messages framed with a little-endian 32 bit length prefix; every connection has a receive and a send ring buffer.
+// send() only queues a message, flush() hands all queued output of a connection to the kernel in one sendmsg() call, so
+// the messages of a whole tick leave in as few packets as possible. Datagrams (UDP) are sent and delivered as is.
+// Setup failures (socket, bind, listen) throw, per connection failures just close that connection.
+class NetLoop {
+public:
+  // Constructor & destructor, the destructor closes every socket without calling the handler
+  NetLoop();
+  ~NetLoop();
+
+  // Accepts connections on the address, port 0 picks a free port (see listenPort())
+  void listen(uint16_t port, const char* host = "0.0.0.0");
+  uint16_t listenPort() const { return listenAddress.port(); }
+
+  // Starts connecting, onConnect() or onDisconnect() reports the result
+  ConnectionId connect(const char* host, uint16_t port);
+
+  // Binds a datagram socket, port 0 picks a free port (see datagramPort())
+  void openDatagram(uint16_t port, const char* host = "0.0.0.0");
+  uint16_t datagramPort() const { return datagramAddress.port(); }
+
+  // Queues a framed message. A message that is too big or doesn't fit into the send buffer closes the connection
+  // and returns false.
+  bool send(ConnectionId id, const void* data, size_t size);
+  // Sends a datagram right away, dropped (and counted) when the socket buffer is full
+  bool sendDatagram(const NetAddress& to, const void* data, size_t size);
+
+  // Closes the connection, queued output is discarded. onDisconnect() follows during the next poll().
+  void disconnect(ConnectionId id);
+  bool connected(ConnectionId id) const;
+
+  // Waits up to 'timeoutMs' (0 returns right away, -1 waits forever) for socket events, dispatches them, flushes the
+  // queued output and reports closed connections. Returns the number of events handled.
+  int poll(int timeoutMs, NetHandler& handler);
+  // Writes the queued output of every connection
+  void flush();
+
+  // Emulates a slow or lossy link for testing: messages sent and received by this loop are held back according to
+  // the conditions before they reach the socket or the handler. Applies to all connections and datagrams, existing
+  // and future; perfect conditions turn emulation off. Bandwidth is only emulated for streams, and held back input
+  // isn't limited by the receive buffer.
+  void setLink(const LinkConditions& outgoing, const LinkConditions& incoming);
+
+  // Output queued on a connection but not taken by the kernel yet, including output held back by the link emulator
+  size_t pendingOutput(ConnectionId id) const;
+  size_t connectionCount() const { return connections.size(); }
+  const NetStats& getStats() const { return stats; }
+
+private:
+  // A message held back by the link emulator
+  struct Delayed {
+    double due;
+    std::vector<uint8_t> data;
+  };
+
+  // Emulated link state of one direction of a connection
+  struct DelayedQueue {
+    std::deque<Delayed> messages;
+    size_t bytes;
+    // When the emulated link finishes transmitting what it has been given, and when the last message arrives
+    double linkFree;
+    double lastDue;
+
+    DelayedQueue() : bytes(0), linkFree(0.0), lastDue(0.0) {}
+  };
+
+  struct DelayedDatagram {
+    double due;
+    NetAddress address;
+    std::vector<uint8_t> data;
+  };
+
+  struct Connection {
+    ConnectionId id;
+    int fd;
+    // False until a non-blocking connect() completes
+    bool established;
+    bool closing;
+    // Listed in 'dirty'
+    bool dirty;
+    RingBuffer input;
+    RingBuffer output;
+    DelayedQueue delayedOut;
+    DelayedQueue delayedIn;
+
+    Connection(ConnectionId id, int fd, bool established);
+  };
+
+  // Readiness of one socket as reported by either backend, see the EVENT_ flags
+  struct Event {
+    uint64_t tag;
+    uint32_t flags;
+  };
+
+#ifdef NET_EPOLL
+  int epollFd;
+#else
+  // Rebuilt on every wait from the sockets and what each connection waits for, with the tag of each alongside
+  std::vector<pollfd> pollFds;
+  std::vector<uint64_t> pollTags;
+#endif
+  std::vector<Event> events;
+  int listenFd;
+  // Descriptor kept spare while listening, given up to accept and drop a connection when out of descriptors
+  int reserveFd;
+  int datagramFd;
+  NetAddress listenAddress;
+  NetAddress datagramAddress;
+
+  ConnectionId nextId;
+  std::unordered_map<ConnectionId, Connection*> connections;
+  // Connections with queued output and connections to close
+  std::vector<ConnectionId> dirty;
+  std::vector<ConnectionId> closing;
+
+  std::vector<uint8_t> scratch;
+  NetStats stats;
+
+  LinkConditions outgoingLink;
+  LinkConditions incomingLink;
+  bool emulating;
+  uint32_t random;
+  // Datagrams held back by the emulator, in no particular order, and the number of held back messages of any kind
+  std::vector<DelayedDatagram> delayedDatagramsOut;
+  std::vector<DelayedDatagram> delayedDatagramsIn;
+  size_t delayed;
+  std::vector<ConnectionId> released;
+
+  // Adds a socket to the epoll set, poll() looks at every socket on each wait anyway. False when that failed.
+  bool watch(int fd, uint64_t tag);
+  void unwatch(int fd);
+  // Waits for readiness and fills 'events', returns their number
+  int wait(int timeoutMs);
+
+  Connection* find(ConnectionId id) const;
+  ConnectionId add(int fd, bool established);
+  void close(Connection* connection);
+  void accept(NetHandler& handler);
+  void receive(Connection* connection, NetHandler& handler);
+  void receiveDatagrams(NetHandler& handler);
+  // Dispatches the complete messages in the receive buffer, false on a protocol error
+  bool dispatch(Connection* connection, NetHandler& handler);
+  void write(Connection* connection);
+  void reap(NetHandler& handler);
+  bool transmitDatagram(const NetAddress& to, const void* data, size_t size);
+
+  // Link emulation: seconds on a monotonic clock, the arrival time of a message, and handing over everything that is
+  // due
+  double now() const;
+  double uniform();
+  double schedule(const LinkConditions& link, DelayedQueue* queue, size_t size);
+  void releaseDelayed(NetHandler& handler);
+  // Milliseconds until the next held back message is due, -1 when nothing is held back
+  int nextDelayed() const;
+};
+
+#endif
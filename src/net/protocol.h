@@ -0,0 +1,32 @@
+/* protocol.h */
+
+#ifndef PROTOCOL_HEADER_H
+#define PROTOCOL_HEADER_H
+
+#include <stdint.h>
+
+// First byte of every message on a game connection, only append to this list
+enum MessageType : uint8_t {
+  MSG_NONE = 0,
+  // Server to client: chunk, section, block delta and unload records (see chunk_protocol.h)
+  MSG_CHUNK_BATCH,
+  // Server to client: the entities in the client's view, delta compressed (see entity_protocol.h)
+  MSG_ENTITY_SNAPSHOT,
+  // Client to server: movement inputs of the client's player
+  MSG_PLAYER_INPUT,
+  // Server to client: the client's player after the server applied its inputs
+  MSG_PLAYER_STATE,
+  // Client to server: the newest entity snapshot received
+  MSG_SNAPSHOT_ACK,
+  // Server to client, first message on a connection: world seed and tick rate
+  MSG_WELCOME,
+  // Either direction: a ping is answered with a pong carrying the same payload, right away
+  MSG_PING,
+  MSG_PONG,
+  // Client to server: place or break a block within reach of the client's player
+  MSG_BLOCK_EDIT,
+
+  MSG_COUNT
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include <string.h>
+
+#include "ring_buffer.h"
+
+RingBuffer::RingBuffer(size_t capacity) {
+  size_t size = 1;
+  while (size < capacity) {
+    size <<= 1;
+  }
+
+  data = new uint8_t[size];
+  mask = size - 1;
+  head = 0;
+  tail = 0;
+}
+
+RingBuffer::~RingBuffer() {
+  delete[] data;
+}
+
+bool RingBuffer::write(const void* source, size_t count) {
+  if (count > space()) {
+    return false;
+  }
+
+  size_t start = (size_t)tail & mask;
+  size_t first = count < capacity() - start ? count : capacity() - start;
+  memcpy(data + start, source, first);
+  memcpy(data, (const uint8_t*)source + first, count - first);
+  tail += count;
+  return true;
+}
+
+void RingBuffer::peek(void* out, size_t count, size_t offset) const {
+  size_t start = (size_t)(head + offset) & mask;
+  size_t first = count < capacity() - start ? count : capacity() - start;
+  memcpy(out, data + start, first);
+  memcpy((uint8_t*)out + first, data, count - first);
+}
+
+const uint8_t* RingBuffer::contiguous(size_t offset, size_t count) const {
+  size_t start = (size_t)(head + offset) & mask;
+  return start + count <= capacity() ? data + start : NULL;
+}
+
+void RingBuffer::consume(size_t count) {
+  head += count;
+}
+
+int RingBuffer::freeSpans(struct iovec spans[2]) {
+  size_t free = space();
+  if (free == 0) {
+    return 0;
+  }
+
+  size_t start = (size_t)tail & mask;
+  size_t first = free < capacity() - start ? free : capacity() - start;
+  spans[0].iov_base = data + start;
+  spans[0].iov_len = first;
+  if (first == free) {
+    return 1;
+  }
+
+  spans[1].iov_base = data;
+  spans[1].iov_len = free - first;
+  return 2;
+}
+
+void RingBuffer::commit(size_t count) {
+  tail += count;
+}
+
+int RingBuffer::dataSpans(struct iovec spans[2]) const {
+  size_t queued = size();
+  if (queued == 0) {
+    return 0;
+  }
+
+  size_t start = (size_t)head & mask;
+  size_t first = queued < capacity() - start ? queued : capacity() - start;
+  spans[0].iov_base = data + start;
+  spans[0].iov_len = first;
+  if (first == queued) {
+    return 1;
+  }
+
+  spans[1].iov_base = data;
+  spans[1].iov_len = queued - first;
+  return 2;
+}
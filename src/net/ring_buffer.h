@@ -0,0 +1,51 @@
+/* ring_buffer.h */
+
+#ifndef RING_BUFFER_HEADER_H
+#define RING_BUFFER_HEADER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/uio.h>
+
+// Fixed size byte queue for socket I/O. The capacity is a power of two and the read and write positions only ever
+// grow, so size and free space are plain differences. The free space and the queued data are exposed as at most two
+// iovec spans, which lets readv() fill the buffer and writev()/sendmsg() drain it without copying.
+class RingBuffer {
+public:
+  // Constructor & destructor, the capacity is rounded up to a power of two
+  RingBuffer(size_t capacity);
+  ~RingBuffer();
+
+  size_t size() const { return (size_t)(tail - head); }
+  size_t space() const { return mask + 1 - size(); }
+  size_t capacity() const { return mask + 1; }
+  bool empty() const { return head == tail; }
+
+  // Appends all of 'data' or nothing, returns false when it doesn't fit
+  bool write(const void* data, size_t count);
+
+  // Copies 'count' bytes starting 'offset' bytes into the queued data
+  void peek(void* out, size_t count, size_t offset = 0) const;
+  // Pointer to 'count' queued bytes starting at 'offset' when they don't wrap around the end, NULL otherwise
+  const uint8_t* contiguous(size_t offset, size_t count) const;
+  // Drops bytes from the front
+  void consume(size_t count);
+
+  // Spans of the free space, fill them (e.g. with readv) and commit the number of bytes written
+  int freeSpans(struct iovec spans[2]);
+  void commit(size_t count);
+
+  // Spans of the queued data, in order
+  int dataSpans(struct iovec spans[2]) const;
+
+private:
+  uint8_t* data;
+  size_t mask;
+  uint64_t head;
+  uint64_t tail;
+
+  RingBuffer(const RingBuffer&);
+  RingBuffer& operator=(const RingBuffer&);
+};
+
+#endif
@@ -0,0 +1,60 @@
+#include "session_protocol.h"
+
+void encodeWelcome(unsigned int seed, int tickRate, std::vector<uint8_t>& out) {
+  ByteWriter writer(out);
+  writer.u8(MSG_WELCOME);
+  writer.u32(seed);
+  writer.u16((uint16_t)tickRate);
+}
+
+bool decodeWelcome(const uint8_t* data, size_t size, unsigned int& seed, int& tickRate) {
+  ByteReader reader(data, size);
+  if (reader.u8() != MSG_WELCOME) {
+    return false;
+  }
+  seed = reader.u32();
+  tickRate = reader.u16();
+
+  return reader.ok && reader.remaining() == 0 && tickRate > 0;
+}
+
+void encodePing(MessageType type, uint32_t sequence, uint64_t time, std::vector<uint8_t>& out) {
+  ByteWriter writer(out);
+  writer.u8(type);
+  writer.u32(sequence);
+  writer.u64(time);
+}
+
+bool decodePing(const uint8_t* data, size_t size, uint32_t& sequence, uint64_t& time) {
+  ByteReader reader(data, size);
+  uint8_t type = reader.u8();
+  if (type != MSG_PING && type != MSG_PONG) {
+    return false;
+  }
+  sequence = reader.u32();
+  time = reader.u64();
+
+  return reader.ok && reader.remaining() == 0;
+}
+
+void encodeBlockEdit(const BlockEdit& edit, std::vector<uint8_t>& out) {
+  ByteWriter writer(out);
+  writer.u8(MSG_BLOCK_EDIT);
+  writer.u32((uint32_t)edit.x);
+  writer.u32((uint32_t)edit.y);
+  writer.u32((uint32_t)edit.z);
+  writer.u16(edit.id);
+}
+
+bool decodeBlockEdit(const uint8_t* data, size_t size, BlockEdit& edit) {
+  ByteReader reader(data, size);
+  if (reader.u8() != MSG_BLOCK_EDIT) {
+    return false;
+  }
+  edit.x = (int32_t)reader.u32();
+  edit.y = (int32_t)reader.u32();
+  edit.z = (int32_t)reader.u32();
+  edit.id = reader.u16();
+
+  return reader.ok && reader.remaining() == 0 && edit.id < BLOCK_COUNT;
+}
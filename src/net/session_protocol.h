@@ -0,0 +1,34 @@
+/* session_protocol.h */
+
+#ifndef SESSION_PROTOCOL_HEADER_H
+#define SESSION_PROTOCOL_HEADER_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "../world/block.h"
+#include "../util/byte_buffer.h"
+#include "protocol.h"
+
+// MSG_WELCOME: [type][seed u32][tick rate u16]. The seed lets clients generate terrain locally for prediction.
+void encodeWelcome(unsigned int seed, int tickRate, std::vector<uint8_t>& out);
+bool decodeWelcome(const uint8_t* data, size_t size, unsigned int& seed, int& tickRate);
+
+// MSG_PING and MSG_PONG: [type][sequence u32][time u64]. The time is whatever the pinging side put in, usually its
+// clock in microseconds, and comes back unchanged so round trips can be measured without synchronized clocks.
+void encodePing(MessageType type, uint32_t sequence, uint64_t time, std::vector<uint8_t>& out);
+bool decodePing(const uint8_t* data, size_t size, uint32_t& sequence, uint64_t& time);
+
+// MSG_BLOCK_EDIT: [type][x i32][y i32][z i32][block id u16]
+struct BlockEdit {
+  int x;
+  int y;
+  int z;
+  BlockID id;
+};
+
+void encodeBlockEdit(const BlockEdit& edit, std::vector<uint8_t>& out);
+// False for corrupt messages and unknown block ids
+bool decodeBlockEdit(const uint8_t* data, size_t size, BlockEdit& edit);
+
+#endif
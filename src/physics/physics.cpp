@@ -0,0 +1,216 @@
+#include <math.h>
+
+#include "physics.h"
+
+// Keeps boxes that rest against a block from being counted as overlapping it
+#define PHYSICS_EPSILON 1e-4f
+
+// Block lookups with the last chunk column cached, bodies rarely leave their chunk during a step
+class BlockAccess {
+public:
+  BlockAccess(const World& world) : world(world) {
+    chunk = NULL;
+    valid = false;
+    originX = 0;
+    originZ = 0;
+  }
+
+  // Relative block coordinates are offset by the origin of the chunk the current body is in
+  void setOrigin(int64_t chunkX, int64_t chunkZ) {
+    originX = (int)(chunkX * SECTION_SIZE);
+    originZ = (int)(chunkZ * SECTION_SIZE);
+  }
+
+  bool isSolidAt(int x, int y, int z) {
+    // Nothing falls out of the bottom of the world, above the top is open air
+    if (y < 0) {
+      return true;
+    }
+    if (y >= CHUNK_HEIGHT) {
+      return false;
+    }
+
+    x += originX;
+    z += originZ;
+    ChunkPos pos = { blockToChunk(x), blockToChunk(z) };
+    if (!valid || pos != cached) {
+      cached = pos;
+      chunk = world.getChunk(pos);
+      valid = true;
+    }
+
+    if (!chunk) {
+      return true;
+    }
+
+    return isSolid(chunk->getBlock(blockToLocal(x), y, blockToLocal(z)));
+  }
+
+private:
+  const World& world;
+  ChunkPos cached;
+  const Chunk* chunk;
+  bool valid;
+  int originX;
+  int originZ;
+};
+
+AABB PhysicsBody::bounds() const {
+  float half = width * 0.5f;
+
+  AABB box;
+  box.min = glm::vec3(position.local.x - half, position.local.y, position.local.z - half);
+  box.max = glm::vec3(position.local.x + half, position.local.y + height, position.local.z + half);
+
+  return box;
+}
+
+PhysicsBody createBody(WorldPosition position, float width, float height, float stepHeight) {
+  PhysicsBody body;
+  body.position = position;
+  body.velocity = glm::vec3(0.0f);
+  body.width = width;
+  body.height = height;
+  body.stepHeight = stepHeight;
+  body.onGround = false;
+
+  return body;
+}
+
+// Returns how far the box can move along 'axis' (up to 'distance') before touching a solid block
+static float sweepAxis(BlockAccess& blocks, const AABB& box, int axis, float distance) {
+  if (distance == 0.0f) {
+    return 0.0f;
+  }
+
+  int u = (axis + 1) % 3;
+  int v = (axis + 2) % 3;
+
+  int minU = (int)floorf(box.min[u] + PHYSICS_EPSILON);
+  int maxU = (int)floorf(box.max[u] - PHYSICS_EPSILON);
+  int minV = (int)floorf(box.min[v] + PHYSICS_EPSILON);
+  int maxV = (int)floorf(box.max[v] - PHYSICS_EPSILON);
+
+  glm::ivec3 cell;
+
+  // Walk the layers of blocks in front of the leading face, the first layer with a solid block limits the motion.
+  // Blocks the box already overlaps are ignored so a body stuck inside terrain can still move out.
+  if (distance > 0.0f) {
+    float lead = box.max[axis];
+    for (int layer = (int)ceilf(lead - PHYSICS_EPSILON); layer < lead + distance; layer++) {
+      cell[axis] = layer;
+      for (cell[u] = minU; cell[u] <= maxU; cell[u]++) {
+        for (cell[v] = minV; cell[v] <= maxV; cell[v]++) {
+          if (blocks.isSolidAt(cell.x, cell.y, cell.z)) {
+            return fmaxf(0.0f, layer - lead);
+          }
+        }
+      }
+    }
+  }
+  else {
+    float lead = box.min[axis];
+    for (int layer = (int)floorf(lead + PHYSICS_EPSILON) - 1; layer + 1 > lead + distance; layer--) {
+      cell[axis] = layer;
+      for (cell[u] = minU; cell[u] <= maxU; cell[u]++) {
+        for (cell[v] = minV; cell[v] <= maxV; cell[v]++) {
+          if (blocks.isSolidAt(cell.x, cell.y, cell.z)) {
+            return fminf(0.0f, layer + 1 - lead);
+          }
+        }
+      }
+    }
+  }
+
+  return distance;
+}
+
+static void offset(AABB& box, int axis, float distance) {
+  box.min[axis] += distance;
+  box.max[axis] += distance;
+}
+
+// Sweeps Y, X and Z in turn and returns the motion that was actually possible
+static glm::vec3 sweep(BlockAccess& blocks, AABB& box, glm::vec3 motion) {
+  glm::vec3 moved;
+
+  moved.y = sweepAxis(blocks, box, 1, motion.y);
+  offset(box, 1, moved.y);
+  moved.x = sweepAxis(blocks, box, 0, motion.x);
+  offset(box, 0, moved.x);
+  moved.z = sweepAxis(blocks, box, 2, motion.z);
+  offset(box, 2, moved.z);
+
+  return moved;
+}
+
+static void moveBody(BlockAccess& blocks, PhysicsBody& body, glm::vec3 motion) {
+  blocks.setOrigin(body.position.chunkX, body.position.chunkZ);
+
+  AABB start = body.bounds();
+  AABB box = start;
+  glm::vec3 moved = sweep(blocks, box, motion);
+
+  bool blockedHorizontally = moved.x != motion.x || moved.z != motion.z;
+  bool grounded = body.onGround || (motion.y < 0.0f && moved.y != motion.y);
+
+  // Blocked by a ledge while walking: retry the horizontal motion lifted by the step height and settle back down,
+  // keep whichever attempt got further
+  if (blockedHorizontally && grounded && body.stepHeight > 0.0f) {
+    AABB stepped = start;
+    glm::vec3 steppedMoved;
+
+    steppedMoved.y = sweepAxis(blocks, stepped, 1, body.stepHeight);
+    offset(stepped, 1, steppedMoved.y);
+    steppedMoved.x = sweepAxis(blocks, stepped, 0, motion.x);
+    offset(stepped, 0, steppedMoved.x);
+    steppedMoved.z = sweepAxis(blocks, stepped, 2, motion.z);
+    offset(stepped, 2, steppedMoved.z);
+
+    float down = sweepAxis(blocks, stepped, 1, -steppedMoved.y + fminf(motion.y, 0.0f));
+    offset(stepped, 1, down);
+    steppedMoved.y += down;
+
+    float steppedDistance = steppedMoved.x * steppedMoved.x + steppedMoved.z * steppedMoved.z;
+    float movedDistance = moved.x * moved.x + moved.z * moved.z;
+    if (steppedDistance > movedDistance + PHYSICS_EPSILON) {
+      box = stepped;
+      moved = steppedMoved;
+    }
+  }
+
+  body.position = WorldPosition(body.position.chunkX, body.position.chunkZ,
+    glm::vec3((box.min.x + box.max.x) * 0.5f, box.min.y, (box.min.z + box.max.z) * 0.5f));
+
+  // A downward sweep that got cut short means the body landed on something, this includes settling onto a step
+  body.onGround = motion.y < 0.0f && moved.y > motion.y;
+
+  for (int axis = 0; axis < 3; axis++) {
+    if (moved[axis] != motion[axis]) {
+      body.velocity[axis] = 0.0f;
+    }
+  }
+}
+
+static void stepBody(BlockAccess& blocks, PhysicsBody& body, float dt) {
+  body.velocity.y = fmaxf(body.velocity.y - PHYSICS_GRAVITY * dt, -PHYSICS_TERMINAL_VELOCITY);
+
+  moveBody(blocks, body, body.velocity * dt);
+}
+
+void Physics::step(const World& world, PhysicsBody& body, float dt) {
+  BlockAccess blocks(world);
+  stepBody(blocks, body, dt);
+}
+
+void Physics::stepBodies(const World& world, PhysicsBody* bodies, size_t count, float dt) {
+  BlockAccess blocks(world);
+  for (size_t i = 0; i < count; i++) {
+    stepBody(blocks, bodies[i], dt);
+  }
+}
+
+void Physics::move(const World& world, PhysicsBody& body, glm::vec3 motion) {
+  BlockAccess blocks(world);
+  moveBody(blocks, body, motion);
+}
@@ -0,0 +1,65 @@
+/* physics.h */
+
+#ifndef PHYSICS_HEADER_H
+#define PHYSICS_HEADER_H
+
+#include <stddef.h>
+#include <glm/glm.hpp>
+
+#include "../world/world.h"
+#include "../world/world_position.h"
+
+// Blocks per second squared and blocks per second
+#define PHYSICS_GRAVITY 32.0f
+#define PHYSICS_TERMINAL_VELOCITY 78.0f
+
+#define PLAYER_WIDTH 0.6f
+#define PLAYER_HEIGHT 1.8f
+#define PLAYER_EYE_HEIGHT 1.62f
+// Highest ledge walked onto without jumping, less than a block so full blocks take a jump
+#define PLAYER_STEP_HEIGHT 0.6f
+#define PLAYER_WALK_SPEED 4.3f
+#define PLAYER_JUMP_VELOCITY 9.0f
+
+struct AABB {
+  glm::vec3 min;
+  glm::vec3 max;
+};
+
+// An axis aligned box moving through the world, 'position' is the center of its bottom face
+struct PhysicsBody {
+  WorldPosition position;
+  glm::vec3 velocity;
+
+  // Horizontal width and height of the box
+  float width;
+  float height;
+
+  // Ledges up to this height are climbed without jumping
+  float stepHeight;
+
+  bool onGround;
+
+  // Box relative to the origin of the chunk column the body is in
+  AABB bounds() const;
+};
+
+PhysicsBody createBody(WorldPosition position, float width, float height, float stepHeight);
+
+// Moves bodies through the voxel grid. Motion is resolved one axis at a time (Y first, then X and Z), each axis sweep
+// only looks at the blocks between the box and its destination and stops at the first solid layer. Unloaded chunks
+// count as solid so nothing falls through the world before it is streamed in. Sweeps work relative to the chunk the
+// body is in, so they are as precise far from the origin as near it.
+class Physics {
+public:
+  // Applies gravity and moves the body by its velocity
+  static void step(const World& world, PhysicsBody& body, float dt);
+
+  // Steps many bodies, consecutive bodies in the same chunk share the chunk lookup
+  static void stepBodies(const World& world, PhysicsBody* bodies, size_t count, float dt);
+
+  // Moves the body by 'motion' without gravity, zeroes the velocity on axes that collided and updates 'onGround'
+  static void move(const World& world, PhysicsBody& body, glm::vec3 motion);
+};
+
+#endif
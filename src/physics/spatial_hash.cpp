@@ -0,0 +1,132 @@
+#include "spatial_hash.h"
+
+using namespace std;
+
+// Slot.cell of entities that aren't in the grid
+#define NO_CELL 0xFFFFFFFFu
+
+SpatialHash::SpatialHash(int cellShift) {
+  this->cellShift = cellShift;
+  count = 0;
+  stamp = 0;
+}
+
+uint32_t SpatialHash::acquireCell(uint64_t key) {
+  auto it = cellIndex.find(key);
+  if (it != cellIndex.end()) {
+    return it->second;
+  }
+
+  uint32_t index;
+  if (!freeCells.empty()) {
+    index = freeCells.back();
+    freeCells.pop_back();
+  }
+  else {
+    index = (uint32_t)cells.size();
+    cells.push_back(Cell());
+  }
+
+  cells[index].key = key;
+  cellIndex.insert({ key, index });
+
+  return index;
+}
+
+void SpatialHash::removeItem(Slot& slot) {
+  Cell& cell = cells[slot.cell];
+
+  // Swap the last item into the hole and point its slot at the new place
+  if (slot.item != cell.items.size() - 1) {
+    cell.items[slot.item] = cell.items.back();
+    slots[cell.items[slot.item].entity.index].item = slot.item;
+  }
+  cell.items.pop_back();
+
+  // Empty cells are recycled so entities roaming the world don't grow the table forever
+  if (cell.items.empty()) {
+    cellIndex.erase(cell.key);
+    freeCells.push_back(slot.cell);
+  }
+
+  slot.cell = NO_CELL;
+  count--;
+}
+
+void SpatialHash::update(Entity entity, const WorldPosition& position) {
+  if (entity.index >= slots.size()) {
+    Slot empty = { 0, NO_CELL, 0, 0 };
+    slots.resize(entity.index + 1, empty);
+  }
+
+  Slot& slot = slots[entity.index];
+  // A slot still holding an older entity with the same index
+  if (slot.cell != NO_CELL && slot.generation != entity.generation) {
+    removeItem(slot);
+  }
+
+  slot.generation = entity.generation;
+  slot.stamp = stamp;
+
+  uint64_t key = cellKey(cellOf(position));
+  if (slot.cell != NO_CELL) {
+    Cell& cell = cells[slot.cell];
+    if (cell.key == key) {
+      cell.items[slot.item].position = position;
+      return;
+    }
+
+    removeItem(slot);
+  }
+
+  uint32_t index = acquireCell(key);
+  Item item = { entity, position };
+
+  slot.cell = index;
+  slot.item = (uint32_t)cells[index].items.size();
+  cells[index].items.push_back(item);
+  count++;
+}
+
+void SpatialHash::remove(Entity entity) {
+  if (contains(entity)) {
+    removeItem(slots[entity.index]);
+  }
+}
+
+bool SpatialHash::contains(Entity entity) const {
+  return entity.index < slots.size() && slots[entity.index].cell != NO_CELL
+    && slots[entity.index].generation == entity.generation;
+}
+
+void SpatialHash::clear() {
+  cellIndex.clear();
+  cells.clear();
+  freeCells.clear();
+  slots.clear();
+  count = 0;
+}
+
+void SpatialHash::beginUpdate() {
+  stamp++;
+}
+
+void SpatialHash::endUpdate() {
+  for (size_t i = 0; i < slots.size(); i++) {
+    if (slots[i].cell != NO_CELL && slots[i].stamp != stamp) {
+      removeItem(slots[i]);
+    }
+  }
+}
+
+void SpatialHash::queryBox(const WorldPosition& center, glm::vec3 halfExtent, vector<Entity>& out) const {
+  forEachInBox(center, halfExtent, [&out](Entity entity, const WorldPosition& position) {
+    out.push_back(entity);
+  });
+}
+
+void SpatialHash::queryRadius(const WorldPosition& center, float radius, vector<Entity>& out) const {
+  forEachInRadius(center, radius, [&out](Entity entity, const WorldPosition& position) {
+    out.push_back(entity);
+  });
+}
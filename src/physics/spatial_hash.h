@@ -0,0 +1,138 @@
+/* spatial_hash.h */
+
+#ifndef SPATIAL_HASH_HEADER_H
+#define SPATIAL_HASH_HEADER_H
+
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+#include "../ecs/entity.h"
+#include "../world/world_position.h"
+
+// Cells are 4 blocks wide, about the size of the largest neighbour queries
+#define SPATIAL_CELL_SHIFT 2
+
+// Uniform grid of entity positions hashed by cell. Inserting, moving and removing an entity are O(1): every entity
+// remembers its cell and slot, and removal swaps the last entry of the cell into the hole. Queries only visit the
+// cells overlapping the query box and test the positions stored in the grid, they never touch the registry.
+// Queries are const and may run from several threads at once as long as nothing modifies the grid meanwhile.
+// Positions are stored as WorldPositions and compared through their differences, so far away entities are found
+// exactly like ones near the origin. Cell keys wrap around every 2^21 cells, which only adds candidates to a cell.
+class SpatialHash {
+public:
+  // Constructor, cells are (1 << cellShift) blocks wide
+  SpatialHash(int cellShift = SPATIAL_CELL_SHIFT);
+
+  // Inserts the entity or moves it to a new position
+  void update(Entity entity, const WorldPosition& position);
+  void remove(Entity entity);
+  bool contains(Entity entity) const;
+
+  size_t size() const { return count; }
+  void clear();
+
+  // Incremental per tick update: entities not passed to update() between the two calls are removed, which drops
+  // entities that were destroyed without the grid having to hear about it
+  void beginUpdate();
+  void endUpdate();
+
+  // Calls f(entity, position) for every entity inside the box center +- halfExtent or the sphere
+  template <typename F>
+  void forEachInBox(const WorldPosition& center, glm::vec3 halfExtent, F f) const {
+    glm::ivec3 from = cellOf(center + -halfExtent);
+    glm::ivec3 to = cellOf(center + halfExtent);
+
+    // A box covering more cells than are occupied (a client's whole view, the full height of the world) scans the
+    // occupied cells instead of looking up every cell it covers
+    size_t boxCells = (size_t)(to.x - from.x + 1) * (size_t)(to.y - from.y + 1) * (size_t)(to.z - from.z + 1);
+    if (boxCells > cellIndex.size()) {
+      for (size_t i = 0; i < cells.size(); i++) {
+        visitBox(cells[i].items, center, halfExtent, f);
+      }
+      return;
+    }
+
+    for (int x = from.x; x <= to.x; x++) {
+      for (int z = from.z; z <= to.z; z++) {
+        for (int y = from.y; y <= to.y; y++) {
+          auto it = cellIndex.find(cellKey(glm::ivec3(x, y, z)));
+          if (it != cellIndex.end()) {
+            visitBox(cells[it->second].items, center, halfExtent, f);
+          }
+        }
+      }
+    }
+  }
+
+  template <typename F>
+  void forEachInRadius(const WorldPosition& center, float radius, F f) const {
+    float radiusSquared = radius * radius;
+    forEachInBox(center, glm::vec3(radius), [&](Entity entity, const WorldPosition& p) {
+      glm::vec3 d = p - center;
+      if (d.x * d.x + d.y * d.y + d.z * d.z <= radiusSquared) {
+        f(entity, p);
+      }
+    });
+  }
+
+  // Appends the entities found to 'out'
+  void queryBox(const WorldPosition& center, glm::vec3 halfExtent, std::vector<Entity>& out) const;
+  void queryRadius(const WorldPosition& center, float radius, std::vector<Entity>& out) const;
+
+private:
+  struct Item {
+    Entity entity;
+    WorldPosition position;
+  };
+
+  struct Cell {
+    uint64_t key;
+    std::vector<Item> items;
+  };
+
+  // Where an entity is stored, indexed by entity index
+  struct Slot {
+    uint32_t generation;
+    uint32_t cell;
+    uint32_t item;
+    uint32_t stamp;
+  };
+
+  int cellShift;
+  size_t count;
+  uint32_t stamp;
+
+  std::unordered_map<uint64_t, uint32_t> cellIndex;
+  std::vector<Cell> cells;
+  std::vector<uint32_t> freeCells;
+  std::vector<Slot> slots;
+
+  glm::ivec3 cellOf(const WorldPosition& position) const {
+    return glm::ivec3((int)(position.blockX() >> cellShift), (int)(position.blockY() >> cellShift), (int)(position.blockZ() >> cellShift));
+  }
+
+  // 21 bits per axis
+  static uint64_t cellKey(glm::ivec3 cell) {
+    return ((uint64_t)(cell.x & 0x1FFFFF) << 42) | ((uint64_t)(cell.y & 0x1FFFFF) << 21) | (uint64_t)(cell.z & 0x1FFFFF);
+  }
+
+  // Calls f for the items of a cell inside the box, free cells have none
+  template <typename F>
+  static void visitBox(const std::vector<Item>& items, const WorldPosition& center, glm::vec3 halfExtent, F& f) {
+    for (size_t i = 0; i < items.size(); i++) {
+      const WorldPosition& p = items[i].position;
+      glm::vec3 d = p - center;
+      if (fabsf(d.x) <= halfExtent.x && fabsf(d.y) <= halfExtent.y && fabsf(d.z) <= halfExtent.z) {
+        f(items[i].entity, p);
+      }
+    }
+  }
+
+  uint32_t acquireCell(uint64_t key);
+  void removeItem(Slot& slot);
+};
+
+#endif
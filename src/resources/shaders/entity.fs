@@ -0,0 +1,15 @@
+#version 330 core
+
+out vec4 fragColor;
+
+in vec3 color;
+in vec2 texCoord;
+flat in int textured;
+
+uniform sampler2D tex0;
+
+void main()
+{
+   vec4 base = textured != 0 ? texture(tex0, texCoord) : vec4(1.0f);
+   fragColor = vec4(color, 1.0f) * base;
+};
\ No newline at end of file
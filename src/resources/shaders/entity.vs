@@ -0,0 +1,33 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPosition;
+layout (location = 1) in float aShade;
+layout (location = 2) in vec2 aTexture;
+layout (location = 3) in float aSlot;
+// Per instance: rows of the model transform, tint and atlas tiles (top, side, bottom)
+layout (location = 4) in vec4 iRow0;
+layout (location = 5) in vec4 iRow1;
+layout (location = 6) in vec4 iRow2;
+layout (location = 7) in vec4 iTint;
+layout (location = 8) in vec4 iTiles;
+
+out vec3 color;
+out vec2 texCoord;
+flat out int textured;
+
+uniform mat4 camMatrix;
+
+void main()
+{
+   vec4 position = vec4(aPosition, 1.0f);
+   gl_Position = camMatrix * vec4(dot(iRow0, position), dot(iRow1, position), dot(iRow2, position), 1.0f);
+
+   color = aShade * iTint.rgb;
+
+   // Same 16x16 atlas layout as the terrain
+   float tile = iTiles[int(aSlot)];
+   textured = tile >= 0.0f ? 1 : 0;
+   float column = mod(tile, 16.0f);
+   float row = floor(tile / 16.0f);
+   texCoord = vec2((column + aTexture.x) / 16.0f, 1.0f - (row + 1.0f - aTexture.y) / 16.0f);
+};
\ No newline at end of file
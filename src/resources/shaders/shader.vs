@@ -1,19 +1,33 @@
 #version 330 core
 
-layout (location = 0) in vec3 aPosition;
-layout (location = 1) in vec3 aColor;
-layout (location = 2) in vec2 aTexture;
+// Packed 10_10_10_2: block corner in xyz, ambient occlusion (0 occluded .. 3 open) in w
+layout (location = 0) in vec4 aPosition;
+layout (location = 1) in float aShade;
+layout (location = 2) in uint aTile;
+// Bit 0 is u, bit 1 is v
+layout (location = 3) in uint aCorner;
 
 // Output color and texture coords for fragment shader
 out vec3 color;
 out vec2 texCoord;
 
 uniform mat4 camMatrix;
+// Origin of the section being drawn, mesh positions are section local
+uniform vec3 chunkOffset;
+
+#define ATLAS_TILES 16.0f
+
+// Brightness for each ambient occlusion value
+const float aoCurve[4] = float[4](0.45f, 0.65f, 0.82f, 1.0f);
 
 void main()
 {
-   gl_Position = camMatrix * vec4(aPosition, 1.0f);
+   gl_Position = camMatrix * vec4(aPosition.xyz + chunkOffset, 1.0f);
+
+   // Face shading and baked ambient occlusion
+   color = vec3(aShade * aoCurve[int(aPosition.w)]);
 
-   color = aColor;
-   texCoord = aTexture;
+   // Atlas rows start at the top of the texture
+   vec2 tile = vec2(float(aTile % 16u), 15.0f - float(aTile / 16u));
+   texCoord = (tile + vec2(float(aCorner & 1u), float(aCorner >> 1u))) / ATLAS_TILES;
 };
\ No newline at end of file
@@ -0,0 +1,239 @@
+#include <algorithm>
+
+#include "chunk_streamer.h"
+
+// Below this many edits a section always goes out as deltas, above it the encoded section is built to compare sizes
+#define DELTA_COMPARE_MIN 16
+
+struct SortedChange {
+  ChunkPos pos;
+  int section;
+  BlockDelta delta;
+};
+
+static bool changeBefore(const SortedChange& a, const SortedChange& b) {
+  if (a.pos.x != b.pos.x) {
+    return a.pos.x < b.pos.x;
+  }
+  if (a.pos.z != b.pos.z) {
+    return a.pos.z < b.pos.z;
+  }
+  if (a.section != b.section) {
+    return a.section < b.section;
+  }
+  return a.delta.index < b.delta.index;
+}
+
+ChunkStreamer::ChunkStreamer(World& world, ChunkCache& cache, NetLoop& net, JobSystem& jobs) :
+  world(world),
+  cache(cache),
+  net(net),
+  jobs(jobs),
+  codec(Codec::create(CODEC_ZSTD, CODEC_LEVEL_FAST, std::vector<uint8_t>())),
+  writer(codec) {
+  stats = { 0, 0, 0, 0, 0, 0 };
+}
+
+ChunkStreamer::~ChunkStreamer() {
+  delete codec;
+}
+
+void ChunkStreamer::addClient(ConnectionId id) {
+  clients[id];
+}
+
+void ChunkStreamer::removeClient(ConnectionId id) {
+  clients.erase(id);
+}
+
+void ChunkStreamer::subscribe(ConnectionId id, ChunkPos pos) {
+  auto it = clients.find(id);
+  if (it == clients.end()) {
+    return;
+  }
+
+  Client& client = it->second;
+  if (client.sent.count(pos) || !client.waiting.insert(pos).second) {
+    return;
+  }
+  client.queue.push_back(pos);
+}
+
+void ChunkStreamer::unsubscribe(ConnectionId id, ChunkPos pos) {
+  auto it = clients.find(id);
+  if (it == clients.end()) {
+    return;
+  }
+
+  Client& client = it->second;
+  if (client.sent.erase(pos)) {
+    client.unloads.push_back(pos);
+  }
+  else {
+    client.waiting.erase(pos);
+  }
+}
+
+bool ChunkStreamer::subscribed(ConnectionId id, ChunkPos pos) const {
+  auto it = clients.find(id);
+  if (it == clients.end()) {
+    return false;
+  }
+
+  return it->second.sent.count(pos) || it->second.waiting.count(pos);
+}
+
+size_t ChunkStreamer::queued(ConnectionId id) const {
+  auto it = clients.find(id);
+
+  return it == clients.end() ? 0 : it->second.waiting.size();
+}
+
+StreamStats ChunkStreamer::getStats() const {
+  StreamStats result = stats;
+  result.rawBytes = writer.rawBytes;
+  result.wireBytes = writer.messageBytes;
+
+  return result;
+}
+
+void ChunkStreamer::update() {
+  buildRecords();
+  loadQueued();
+
+  for (auto it = clients.begin(); it != clients.end(); ++it) {
+    if (net.connected(it->first)) {
+      sendClient(it->first, it->second);
+    }
+  }
+}
+
+void ChunkStreamer::loadQueued() {
+  // The chunks sendClient() is going to take off the queues. Most are outside the area the server keeps loaded, loading
+  // them one by one as they are written would generate them serially on the tick thread.
+  loadList.clear();
+  for (auto it = clients.begin(); it != clients.end(); ++it) {
+    const Client& client = it->second;
+    if (!net.connected(it->first) || net.pendingOutput(it->first) >= STREAM_OUTPUT_LIMIT) {
+      continue;
+    }
+
+    int count = 0;
+    for (size_t i = 0; i < client.queue.size() && count < STREAM_CHUNKS_PER_TICK; i++) {
+      if (client.waiting.count(client.queue[i])) {
+        loadList.push_back(client.queue[i]);
+        count++;
+      }
+    }
+  }
+
+  if (!loadList.empty()) {
+    cache.acquire(loadList, jobs);
+  }
+}
+
+void ChunkStreamer::buildRecords() {
+  records.clear();
+  recordList.clear();
+
+  world.takeChanges(changes);
+  if (changes.empty()) {
+    return;
+  }
+
+  // Group by section, the stable sort keeps repeated edits of a block in order so the last one wins
+  static thread_local std::vector<SortedChange> sorted;
+  sorted.clear();
+  for (size_t i = 0; i < changes.size(); i++) {
+    const BlockChange& change = changes[i];
+    SortedChange entry;
+    entry.pos = { blockToChunk(change.x), blockToChunk(change.z) };
+    entry.section = change.y >> SECTION_SHIFT;
+    entry.delta.index = (uint16_t)Section::index(blockToLocal(change.x), change.y & SECTION_MASK, blockToLocal(change.z));
+    entry.delta.id = change.id;
+    sorted.push_back(entry);
+  }
+  std::stable_sort(sorted.begin(), sorted.end(), changeBefore);
+
+  static thread_local std::vector<BlockDelta> deltas;
+  ByteWriter out(records);
+
+  size_t i = 0;
+  while (i < sorted.size()) {
+    ChunkPos pos = sorted[i].pos;
+    int section = sorted[i].section;
+
+    deltas.clear();
+    for (; i < sorted.size() && sorted[i].pos == pos && sorted[i].section == section; i++) {
+      if (!deltas.empty() && deltas.back().index == sorted[i].delta.index) {
+        deltas.back() = sorted[i].delta;
+      }
+      else {
+        deltas.push_back(sorted[i].delta);
+      }
+    }
+
+    Record record;
+    record.pos = pos;
+    record.offset = records.size();
+
+    // Many edits (an explosion, a fill) are cheaper as the whole section, its palette usually shrinks them a lot
+    Chunk* chunk = world.getChunk(pos);
+    bool resend = false;
+    if (chunk && deltas.size() >= DELTA_COMPARE_MIN) {
+      scratch.clear();
+      ByteWriter sectionWriter(scratch);
+      ChunkBatchWriter::writeSection(sectionWriter, pos, section, *chunk->sections[section].share());
+      resend = scratch.size() < DELTA_RECORD_HEADER + deltas.size() * DELTA_RECORD_ENTRY;
+    }
+
+    if (resend) {
+      out.bytes(scratch.data(), scratch.size());
+      stats.sectionRecords++;
+    }
+    else {
+      ChunkBatchWriter::writeDeltas(out, pos, section, deltas.data(), deltas.size());
+      stats.deltaRecords++;
+    }
+
+    record.size = records.size() - record.offset;
+    recordList.push_back(record);
+  }
+}
+
+void ChunkStreamer::sendClient(ConnectionId id, Client& client) {
+  for (size_t i = 0; i < client.unloads.size(); i++) {
+    writer.unload(client.unloads[i]);
+  }
+  stats.unloadsSent += client.unloads.size();
+  client.unloads.clear();
+
+  // Edits only matter for chunks the client has, queued chunks pick them up when they are sent
+  for (size_t i = 0; i < recordList.size(); i++) {
+    const Record& record = recordList[i];
+    if (client.sent.count(record.pos)) {
+      writer.records(records.data() + record.offset, record.size);
+    }
+  }
+
+  size_t pending = net.pendingOutput(id);
+  int sentChunks = 0;
+  while (!client.queue.empty() && sentChunks < STREAM_CHUNKS_PER_TICK && pending + writer.pendingBytes() < STREAM_OUTPUT_LIMIT) {
+    ChunkPos pos = client.queue.front();
+    client.queue.pop_front();
+    if (!client.waiting.erase(pos)) {
+      continue;
+    }
+
+    writer.chunk(cache.acquire(pos)->snapshot());
+    client.sent.insert(pos);
+    sentChunks++;
+  }
+  stats.chunksSent += sentChunks;
+
+  messages.clear();
+  writer.finish(messages);
+  for (size_t i = 0; i < messages.size(); i++) {
+    net.send(id, messages[i].data(), messages[i].size());
+  }
+}
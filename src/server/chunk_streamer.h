@@ -0,0 +1,102 @@
+/* chunk_streamer.h */
+
+#ifndef CHUNK_STREAMER_HEADER_H
+#define CHUNK_STREAMER_HEADER_H
+
+#include <stdint.h>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../world/world.h"
+#include "../world/chunk_cache.h"
+#include "../jobs/job_system.h"
+#include "../net/net_loop.h"
+#include "../net/chunk_protocol.h"
+
+// Whole chunks sent to one client per tick, and the queued output above which a client gets no new chunks this tick.
+// Together they keep a worst case tick (8 incompressible full sections per chunk) within NET_SEND_BUFFER.
+#define STREAM_CHUNKS_PER_TICK 8
+#define STREAM_OUTPUT_LIMIT (96 * 1024)
+
+struct StreamStats {
+  uint64_t chunksSent;
+  uint64_t unloadsSent;
+  // Edited sections sent as block deltas and as a complete section
+  uint64_t deltaRecords;
+  uint64_t sectionRecords;
+  // Record bytes before compression, and bytes handed to the network
+  uint64_t rawBytes;
+  uint64_t wireBytes;
+};
+
+// Sends each client the chunks it subscribed to and keeps them up to date. A chunk goes out once as palette encoded
+// sections (empty sections only cost a bit in the mask), after that the block edits of a tick are grouped per
+// section and sent as one delta record, or as the whole section again when that's smaller. Records for a section
+// are built once per tick and shared by every client that has the chunk. The chunks about to be sent are loaded in one
+// batch on the job system first. Needs the world's change log enabled.
+class ChunkStreamer {
+public:
+  // Constructor & destructor
+  ChunkStreamer(World& world, ChunkCache& cache, NetLoop& net, JobSystem& jobs);
+  ~ChunkStreamer();
+
+  void addClient(ConnectionId id);
+  void removeClient(ConnectionId id);
+
+  // Queues the chunk for the client, chunks go out in subscription order
+  void subscribe(ConnectionId id, ChunkPos pos);
+  // Drops the chunk from the queue, or tells the client to unload it when it was sent already
+  void unsubscribe(ConnectionId id, ChunkPos pos);
+  bool subscribed(ConnectionId id, ChunkPos pos) const;
+
+  // Sends this tick's block edits and as many queued chunks as the budgets allow. Call once per tick after the
+  // simulation and before NetLoop::flush().
+  void update();
+
+  // Chunks still waiting to be sent to the client
+  size_t queued(ConnectionId id) const;
+  StreamStats getStats() const;
+
+private:
+  struct Client {
+    std::deque<ChunkPos> queue;
+    // Subscribed chunks not sent yet, chunks in 'queue' but not here were unsubscribed meanwhile
+    std::unordered_set<ChunkPos, ChunkPosHash> waiting;
+    std::unordered_set<ChunkPos, ChunkPosHash> sent;
+    std::vector<ChunkPos> unloads;
+  };
+
+  // A finished record in 'records'
+  struct Record {
+    ChunkPos pos;
+    size_t offset;
+    size_t size;
+  };
+
+  World& world;
+  ChunkCache& cache;
+  NetLoop& net;
+  JobSystem& jobs;
+  Codec* codec;
+  ChunkBatchWriter writer;
+
+  std::unordered_map<ConnectionId, Client> clients;
+
+  // Chunks the clients are sent this tick, loaded before the first one is written
+  std::vector<ChunkPos> loadList;
+  std::vector<BlockChange> changes;
+  std::vector<uint8_t> records;
+  std::vector<Record> recordList;
+  std::vector<uint8_t> scratch;
+  std::vector<std::vector<uint8_t>> messages;
+
+  StreamStats stats;
+
+  void buildRecords();
+  void loadQueued();
+  void sendClient(ConnectionId id, Client& client);
+};
+
+#endif
@@ -0,0 +1,104 @@
+#include <algorithm>
+
+#include "interest.h"
+
+// Appends the chunks of the square around 'a' that aren't in the square around 'b'. Columns outside the other square
+// are taken whole, the others only contribute the chunks above and below it.
+static void squareDifference(ChunkPos a, ChunkPos b, int radius, std::vector<ChunkPos>& out) {
+  for (int x = a.x - radius; x <= a.x + radius; x++) {
+    if (x < b.x - radius || x > b.x + radius) {
+      for (int z = a.z - radius; z <= a.z + radius; z++) {
+        out.push_back({ x, z });
+      }
+      continue;
+    }
+
+    for (int z = a.z - radius; z <= a.z + radius && z < b.z - radius; z++) {
+      out.push_back({ x, z });
+    }
+    for (int z = std::max(a.z - radius, b.z + radius + 1); z <= a.z + radius; z++) {
+      out.push_back({ x, z });
+    }
+  }
+}
+
+static void sortByDistance(std::vector<ChunkPos>& chunks, ChunkPos center) {
+  std::sort(chunks.begin(), chunks.end(), [center](const ChunkPos& a, const ChunkPos& b) {
+    int da = (a.x - center.x) * (a.x - center.x) + (a.z - center.z) * (a.z - center.z);
+    int db = (b.x - center.x) * (b.x - center.x) + (b.z - center.z) * (b.z - center.z);
+    return da < db;
+  });
+}
+
+ClientInterest::ClientInterest(int viewDistance, int entityDistance) {
+  this->viewDistance = viewDistance;
+  this->entityDistance = std::min(entityDistance, viewDistance);
+  this->valid = false;
+  this->center = { 0, 0 };
+  this->stamp = 0;
+}
+
+bool ClientInterest::updateChunks(const WorldPosition& position, ChunkInterestDiff& diff) {
+  diff.clear();
+
+  ChunkPos next = position.chunk();
+  if (valid && next == center) {
+    return false;
+  }
+
+  if (!valid) {
+    // Any position far enough away makes the whole square new
+    ChunkPos outside = { next.x + 2 * viewDistance + 1, next.z };
+    squareDifference(next, outside, viewDistance, diff.added);
+  }
+  else {
+    squareDifference(next, center, viewDistance, diff.added);
+    squareDifference(center, next, viewDistance, diff.removed);
+  }
+  sortByDistance(diff.added, next);
+
+  center = next;
+  valid = true;
+  return true;
+}
+
+void ClientInterest::updateEntities(const SpatialHash& grid, const WorldPosition& position, Entity ignore, EntityInterestDiff& diff) {
+  diff.clear();
+  stamp++;
+
+  // Whole chunks around the player's chunk, the full height of the world
+  WorldPosition middle = WorldPosition(position.chunkX, position.chunkZ, glm::vec3(SECTION_SIZE / 2.0f, CHUNK_HEIGHT / 2.0f, SECTION_SIZE / 2.0f));
+  float halfWidth = (entityDistance + 0.5f) * SECTION_SIZE;
+  grid.forEachInBox(middle, glm::vec3(halfWidth, CHUNK_HEIGHT / 2.0f, halfWidth), [&](Entity entity, const WorldPosition& p) {
+    if (entity == ignore) {
+      return;
+    }
+
+    auto it = entities.find(entity);
+    if (it == entities.end()) {
+      entities[entity] = stamp;
+      diff.entered.push_back(entity);
+    }
+    else {
+      it->second = stamp;
+      diff.stayed.push_back(entity);
+    }
+  });
+
+  // Only entities that were visible before can have left
+  if (entities.size() > diff.entered.size() + diff.stayed.size()) {
+    for (auto it = entities.begin(); it != entities.end();) {
+      if (it->second != stamp) {
+        diff.left.push_back(it->first);
+        it = entities.erase(it);
+      }
+      else {
+        ++it;
+      }
+    }
+  }
+}
+
+bool ClientInterest::sees(Entity entity) const {
+  return entities.count(entity) > 0;
+}
@@ -0,0 +1,74 @@
+/* interest.h */
+
+#ifndef INTEREST_HEADER_H
+#define INTEREST_HEADER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <unordered_map>
+#include <vector>
+
+#include "../world/chunk.h"
+#include "../world/world_position.h"
+#include "../physics/spatial_hash.h"
+
+// Radius in chunks of the square of chunks a client is sent, and of the smaller square it sees entities in
+#define INTEREST_VIEW_DISTANCE 8
+#define INTEREST_ENTITY_DISTANCE 4
+
+// Chunks entering and leaving a client's view, 'added' is sorted nearest first
+struct ChunkInterestDiff {
+  std::vector<ChunkPos> added;
+  std::vector<ChunkPos> removed;
+
+  void clear() { added.clear(); removed.clear(); }
+};
+
+struct EntityInterestDiff {
+  std::vector<Entity> entered;
+  // Entities that were visible before and still are
+  std::vector<Entity> stayed;
+  // Entities that moved out of view or were destroyed
+  std::vector<Entity> left;
+
+  void clear() { entered.clear(); stayed.clear(); left.clear(); }
+};
+
+// What one client can see: the chunks within the view distance of the chunk its player is in, and the entities
+// within the entity distance. The chunk set only changes when the player crosses a chunk border, and then only the
+// strips of chunks entering and leaving the square are visited, not the whole square. The entity set is rebuilt
+// from a spatial hash query every tick and diffed against the previous one.
+class ClientInterest {
+public:
+  // Constructor, distances in chunks
+  ClientInterest(int viewDistance = INTEREST_VIEW_DISTANCE, int entityDistance = INTEREST_ENTITY_DISTANCE);
+
+  // Centers the view on the chunk 'position' is in. The first call adds the whole square, later calls only report
+  // the difference and return false when the player stayed in the same chunk.
+  bool updateChunks(const WorldPosition& position, ChunkInterestDiff& diff);
+
+  bool contains(ChunkPos pos) const {
+    return valid && abs(pos.x - center.x) <= viewDistance && abs(pos.z - center.z) <= viewDistance;
+  }
+
+  // Finds the entities around 'position', 'ignore' (the client's own player) is never reported
+  void updateEntities(const SpatialHash& grid, const WorldPosition& position, Entity ignore, EntityInterestDiff& diff);
+  bool sees(Entity entity) const;
+
+  ChunkPos getCenter() const { return center; }
+  int getViewDistance() const { return viewDistance; }
+  size_t entityCount() const { return entities.size(); }
+
+private:
+  int viewDistance;
+  int entityDistance;
+
+  bool valid;
+  ChunkPos center;
+
+  // Visible entities and the update in which they were last seen
+  std::unordered_map<Entity, uint32_t, EntityHash> entities;
+  uint32_t stamp;
+};
+
+#endif
@@ -0,0 +1,69 @@
+/**
+ * Headless server
+ *
+ * Runs the world and the entity simulation without a window or GL context. Stops cleanly on SIGINT/SIGTERM, saving
+ * every modified chunk before exiting.
+ *
+ * usage: server [world directory] [seed] [tick rate] [port]
+**/
+
+#include <signal.h>
+#include <stdlib.h>
+#include <iostream>
+
+#include "server.h"
+
+using namespace std;
+
+static Server* instance = NULL;
+
+static void handleSignal(int signal) {
+  if (instance) {
+    instance->stop();
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  try
+  {
+    ServerConfig config;
+    if (argc > 1) {
+      config.directory = argv[1];
+    }
+    if (argc > 2) {
+      config.seed = (unsigned int)strtoul(argv[2], NULL, 10);
+    }
+    if (argc > 3) {
+      config.tickRate = atoi(argv[3]);
+      if (config.tickRate <= 0) {
+        cerr << "Invalid tick rate: " << argv[3] << endl;
+        return EXIT_FAILURE;
+      }
+    }
+    if (argc > 4) {
+      config.port = (uint16_t)atoi(argv[4]);
+    }
+
+    cout << "Starting server: world " << config.directory << ", seed " << config.seed << ", " << config.tickRate
+      << " ticks per second, port " << config.port << endl;
+
+    Server server(config);
+    instance = &server;
+    signal(SIGINT, handleSignal);
+    signal(SIGTERM, handleSignal);
+
+    server.run();
+
+    instance = NULL;
+    cout << "Stopping server, saving the world" << endl;
+  }
+  catch (string& e)
+  {
+    cerr << e << endl;
+
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
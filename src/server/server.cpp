@@ -0,0 +1,387 @@
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "server.h"
+#include "../entity/systems.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point start) {
+  return chrono::duration<double>(Clock::now() - start).count();
+}
+
+Server::Server(const ServerConfig& config) :
+  config(config),
+  jobs(config.workers),
+  storage(config.directory),
+  world(config.seed, &storage),
+  autosave(world, storage, jobs),
+  chunks(world),
+  scheduler(jobs),
+  streamer(world, chunks, net, jobs),
+  stopping(false) {
+  spawn = { 0, 0 };
+  stats = { 0, 0, 0.0, 0.0 };
+  totalMs = 0.0;
+  recordTicks = false;
+  tickCount = 0;
+  snapshotBytes = 0;
+
+  registerSystems(scheduler, world, grid);
+  world.setChangeLog(true);
+  net.listen(config.port, config.host.c_str());
+
+  // Load the spawn area up front so the mobs have ground to stand on
+  loadChunks();
+  spawnMobs();
+}
+
+Server::~Server() {
+  autosave.flush();
+}
+
+void Server::spawnMobs() {
+  for (int i = 0; i < config.mobCount; i++) {
+    int x = 8 + (i % 8) * 3 - 12;
+    int z = 8 + (i / 8) * 3 - 6;
+    spawnMob(registry, WorldPosition::fromBlock(x, world.generator.height(x, z) + 1, z, glm::vec3(0.5f, 0.0f, 0.5f)), 1 + i * 7919);
+  }
+}
+
+void Server::loadChunks() {
+  // Keep the spawn area loaded, everything else is evicted once the cache is over budget
+  chunks.beginFrame();
+  loadList.clear();
+  for (int x = -config.spawnRadius; x <= config.spawnRadius; x++) {
+    for (int z = -config.spawnRadius; z <= config.spawnRadius; z++) {
+      loadList.push_back({ spawn.x + x, spawn.z + z });
+    }
+  }
+  for (auto it = clients.begin(); it != clients.end(); ++it) {
+    const PhysicsBody* body = registry.get<PhysicsBody>(it->second.player);
+    if (body) {
+      ChunkPos center = body->position.chunk();
+      for (int x = -SERVER_PLAYER_RADIUS; x <= SERVER_PLAYER_RADIUS; x++) {
+        for (int z = -SERVER_PLAYER_RADIUS; z <= SERVER_PLAYER_RADIUS; z++) {
+          loadList.push_back({ center.x + x, center.z + z });
+        }
+      }
+    }
+  }
+
+  // Chunks that have to be generated are generated in parallel
+  chunks.acquire(loadList, jobs);
+}
+
+void Server::tick(float dt, double now) {
+  loadChunks();
+  movePlayers(dt);
+  scheduler.run(registry, dt);
+  pickUpItems();
+  tickCount++;
+  autosave.tick(now);
+
+  // There are no meshes on the server, only the CPU budget matters
+  evictions.chunks.clear();
+  evictions.meshes.clear();
+  chunks.enforceBudget(evictions);
+
+  replicate();
+  streamer.update();
+
+  // Everything the tick queued for the clients leaves in one batch per connection
+  net.flush();
+}
+
+void Server::onConnect(ConnectionId id) {
+  // Players start on the surface in the middle of the spawn chunk
+  int x = spawn.x * SECTION_SIZE + SECTION_SIZE / 2;
+  int z = spawn.z * SECTION_SIZE + SECTION_SIZE / 2;
+  Entity player = registry.create<PhysicsBody, Appearance, PlayerControl>();
+  *registry.get<PhysicsBody>(player) = createBody(WorldPosition::fromBlock(x, world.generator.height(x, z) + 1, z, glm::vec3(0.5f, 0.0f, 0.5f)),
+    PLAYER_WIDTH, PLAYER_HEIGHT, PLAYER_STEP_HEIGHT);
+
+  Appearance* appearance = registry.get<Appearance>(player);
+  appearance->color = glm::vec3(0.4f, 0.6f, 1.0f);
+  appearance->scale = PLAYER_HEIGHT;
+  appearance->model = MODEL_MOB;
+  appearance->block = BLOCK_AIR;
+
+  clients.insert(make_pair(id, Client(player, config.viewDistance, config.entityDistance)));
+  streamer.addClient(id);
+
+  message.clear();
+  encodeWelcome(config.seed, config.tickRate, message);
+  net.send(id, message.data(), message.size());
+
+  if (config.logClients) {
+    cout << "Client " << id << " connected, " << net.connectionCount() << " connected" << endl;
+  }
+}
+
+void Server::onMessage(ConnectionId id, const uint8_t* data, size_t size) {
+  auto it = clients.find(id);
+  if (it == clients.end() || size == 0) {
+    return;
+  }
+
+  if (data[0] == MSG_SNAPSHOT_ACK) {
+    uint32_t tick;
+    if (!decodeSnapshotAck(data, size, tick) || tick > tickCount) {
+      net.disconnect(id);
+      return;
+    }
+    if (tick > it->second.acknowledged) {
+      it->second.acknowledged = tick;
+    }
+  }
+  else if (data[0] == MSG_PLAYER_INPUT) {
+    receivedInputs.clear();
+    if (!decodePlayerInputs(data, size, receivedInputs) || it->second.inputs.size() + receivedInputs.size() > SERVER_INPUT_QUEUE) {
+      net.disconnect(id);
+      return;
+    }
+    it->second.inputs.insert(it->second.inputs.end(), receivedInputs.begin(), receivedInputs.end());
+  }
+  else if (data[0] == MSG_PING) {
+    uint32_t sequence;
+    uint64_t time;
+    if (!decodePing(data, size, sequence, time)) {
+      net.disconnect(id);
+      return;
+    }
+    // Answered right away instead of with the next tick, the round trip measures the network and the poll loop
+    message.clear();
+    encodePing(MSG_PONG, sequence, time, message);
+    net.send(id, message.data(), message.size());
+  }
+  else if (data[0] == MSG_BLOCK_EDIT) {
+    BlockEdit edit;
+    if (!decodeBlockEdit(data, size, edit)) {
+      net.disconnect(id);
+      return;
+    }
+    editBlock(it->second, edit);
+  }
+}
+
+void Server::onDisconnect(ConnectionId id) {
+  auto it = clients.find(id);
+  if (it != clients.end()) {
+    registry.destroy(it->second.player);
+    clients.erase(it);
+  }
+  streamer.removeClient(id);
+
+  if (config.logClients) {
+    cout << "Client " << id << " disconnected, " << net.connectionCount() << " connected" << endl;
+  }
+}
+
+void Server::movePlayers(float dt) {
+  for (auto it = clients.begin(); it != clients.end(); ++it) {
+    Client& client = it->second;
+    PhysicsBody* body = registry.get<PhysicsBody>(client.player);
+    PlayerControl* control = registry.get<PlayerControl>(client.player);
+    if (!body || !control) {
+      continue;
+    }
+
+    control->budget = fminf(control->budget + dt, SERVER_INPUT_BUDGET);
+    // The epsilon absorbs the rounding of adding up tick lengths
+    while (!client.inputs.empty() && control->budget + 1e-4f >= PLAYER_INPUT_DT) {
+      PlayerInput input = client.inputs.front();
+      client.inputs.pop_front();
+
+      // Replayed or reordered inputs are dropped, the client's sequence numbers only grow
+      if (input.sequence <= control->lastInput) {
+        continue;
+      }
+      applyPlayerInput(world, *body, input);
+      control->lastInput = input.sequence;
+      control->budget -= PLAYER_INPUT_DT;
+      client.sendState = true;
+    }
+  }
+}
+
+void Server::editBlock(Client& client, const BlockEdit& edit) {
+  const PhysicsBody* body = registry.get<PhysicsBody>(client.player);
+  if (!body || edit.y < 0 || edit.y >= CHUNK_HEIGHT) {
+    return;
+  }
+
+  // Out of reach is not an error, the player may have moved on since the client sent the edit
+  glm::vec3 offset = WorldPosition::fromBlock(edit.x, edit.y, edit.z, glm::vec3(0.5f)) - body->position;
+  if (glm::dot(offset, offset) > SERVER_EDIT_REACH * SERVER_EDIT_REACH) {
+    return;
+  }
+
+  // Only loaded chunks, an edit must not make the server load or generate terrain; the streamer sends the change
+  if (!world.getChunk({ blockToChunk(edit.x), blockToChunk(edit.z) })) {
+    return;
+  }
+
+  // Broken blocks drop as items
+  BlockID broken = world.getBlock(edit.x, edit.y, edit.z);
+  world.setBlock(edit.x, edit.y, edit.z, edit.id);
+  if (edit.id == BLOCK_AIR && broken != BLOCK_AIR) {
+    spawnItem(registry, WorldPosition::fromBlock(edit.x, edit.y, edit.z, glm::vec3(0.5f)), broken);
+  }
+}
+
+void Server::pickUpItems() {
+  for (auto it = clients.begin(); it != clients.end(); ++it) {
+    const PhysicsBody* body = registry.get<PhysicsBody>(it->second.player);
+    if (!body) {
+      continue;
+    }
+
+    grid.forEachInRadius(body->position, ITEM_PICKUP_RADIUS, [this](Entity entity, const WorldPosition& position) {
+      if (registry.get<ItemDrop>(entity)) {
+        registry.destroy(entity);
+      }
+    });
+  }
+}
+
+Entity Server::getPlayer(ConnectionId id) const {
+  auto it = clients.find(id);
+
+  return it == clients.end() ? ENTITY_NULL : it->second.player;
+}
+
+void Server::replicate() {
+  for (auto it = clients.begin(); it != clients.end(); ++it) {
+    ConnectionId id = it->first;
+    Client& client = it->second;
+    const PhysicsBody* playerBody = registry.get<PhysicsBody>(client.player);
+    if (!playerBody) {
+      continue;
+    }
+
+    // Only the strips entering and leaving the view when the player crossed a chunk border
+    if (client.interest.updateChunks(playerBody->position, chunkDiff)) {
+      for (size_t i = 0; i < chunkDiff.removed.size(); i++) {
+        streamer.unsubscribe(id, chunkDiff.removed[i]);
+      }
+      for (size_t i = 0; i < chunkDiff.added.size(); i++) {
+        streamer.subscribe(id, chunkDiff.added[i]);
+      }
+    }
+
+    client.interest.updateEntities(grid, playerBody->position, client.player, entityDiff);
+
+    // Nearest entities first when there are more than a snapshot holds
+    visible.clear();
+    visible.insert(visible.end(), entityDiff.entered.begin(), entityDiff.entered.end());
+    visible.insert(visible.end(), entityDiff.stayed.begin(), entityDiff.stayed.end());
+    if (visible.size() > SNAPSHOT_MAX_ENTITIES) {
+      const Registry& entities = registry;
+      WorldPosition center = playerBody->position;
+      nth_element(visible.begin(), visible.begin() + SNAPSHOT_MAX_ENTITIES, visible.end(), [&entities, &center](Entity a, Entity b) {
+        const PhysicsBody* bodyA = entities.get<PhysicsBody>(a);
+        const PhysicsBody* bodyB = entities.get<PhysicsBody>(b);
+        glm::vec3 da = bodyA ? bodyA->position - center : glm::vec3(1e9f);
+        glm::vec3 db = bodyB ? bodyB->position - center : glm::vec3(1e9f);
+        return glm::dot(da, da) < glm::dot(db, db);
+      });
+      visible.resize(SNAPSHOT_MAX_ENTITIES);
+    }
+
+    // The newest snapshot the client acknowledged is the baseline, unless it is too old to still be in both histories
+    const EntitySnapshot* baseline = tickCount - client.acknowledged < SNAPSHOT_HISTORY ? client.snapshots.find(client.acknowledged) : NULL;
+    EntitySnapshot& snapshot = client.snapshots.add(tickCount);
+    for (size_t i = 0; i < visible.size(); i++) {
+      const PhysicsBody* body = registry.get<PhysicsBody>(visible[i]);
+      const Appearance* appearance = registry.get<Appearance>(visible[i]);
+      if (body && appearance) {
+        snapshot.entities.push_back(quantizeEntity(visible[i], *body, *appearance));
+      }
+    }
+    sort(snapshot.entities.begin(), snapshot.entities.end(), [](const EntityState& a, const EntityState& b) {
+      return a.entity.index < b.entity.index;
+    });
+
+    message.clear();
+    encodeSnapshot(snapshot, baseline, message);
+    net.send(id, message.data(), message.size());
+    snapshotBytes += message.size();
+
+    // The client compares this with what it predicted for the same input
+    const PlayerControl* control = registry.get<PlayerControl>(client.player);
+    if (client.sendState && control) {
+      message.clear();
+      encodePlayerState(control->lastInput, *playerBody, message);
+      net.send(id, message.data(), message.size());
+      client.sendState = false;
+    }
+  }
+}
+
+void Server::run() {
+  Clock::time_point start = Clock::now();
+  Clock::duration interval = chrono::duration_cast<Clock::duration>(chrono::duration<double>(1.0 / config.tickRate));
+  Clock::time_point next = start;
+  double lastReport = 0.0;
+  float dt = 1.0f / config.tickRate;
+
+  while (!stopping.load()) {
+    Clock::time_point tickStart = Clock::now();
+    tick(dt, secondsSince(start));
+
+    double ms = secondsSince(tickStart) * 1e3;
+    stats.ticks++;
+    totalMs += ms;
+    if (ms > stats.maxMs) {
+      stats.maxMs = ms;
+    }
+    if (recordTicks) {
+      tickTimes.push_back((float)ms);
+    }
+
+    next += interval;
+    Clock::time_point now = Clock::now();
+    if (now > next) {
+      stats.overruns++;
+      if (now - next > chrono::seconds(1)) {
+        next = now;
+      }
+    }
+
+    // Wait for the next tick on the sockets, handling messages as they arrive
+    do {
+      Clock::duration remaining = next - Clock::now();
+      int timeout = (int)((chrono::duration_cast<chrono::microseconds>(remaining).count() + 999) / 1000);
+      net.poll(timeout > 0 ? timeout : 0, *this);
+    } while (Clock::now() < next && !stopping.load());
+
+    double elapsed = secondsSince(start);
+    if (config.reportInterval > 0.0 && elapsed - lastReport >= config.reportInterval) {
+      TickStats report = takeStats();
+      JobStats jobStats = jobs.takeStats();
+      cout << "Ticks: " << report.ticks << ", avg " << report.averageMs << " ms, max " << report.maxMs << " ms, "
+        << report.overruns << " overruns, " << net.connectionCount() << " clients, " << registry.size() << " entities, " << world.getChunks().size()
+        << " chunks, jobs " << (int)(jobStats.utilisation() * 100.0) << " % busy" << endl;
+      lastReport = elapsed;
+    }
+  }
+}
+
+TickStats Server::takeStats() {
+  TickStats result = stats;
+  result.averageMs = stats.ticks ? totalMs / stats.ticks : 0.0;
+
+  stats = { 0, 0, 0.0, 0.0 };
+  totalMs = 0.0;
+  return result;
+}
+
+void Server::takeTickTimes(std::vector<float>& out) {
+  out.clear();
+  out.swap(tickTimes);
+}
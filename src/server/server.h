@@ -0,0 +1,185 @@
+/* server.h */
+
+#ifndef SERVER_HEADER_H
+#define SERVER_HEADER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <deque>
+#include <unordered_map>
+#include <string>
+#include <vector>
+
+#include "../world/world.h"
+#include "../world/chunk_cache.h"
+#include "../world/storage/world_storage.h"
+#include "../world/storage/autosave.h"
+#include "../ecs/registry.h"
+#include "../ecs/scheduler.h"
+#include "../jobs/job_system.h"
+#include "../physics/spatial_hash.h"
+#include "../net/net_loop.h"
+#include "../net/entity_protocol.h"
+#include "../net/session_protocol.h"
+#include "chunk_streamer.h"
+#include "interest.h"
+
+#define SERVER_TICK_RATE 20
+#define SERVER_PORT 25565
+// Radius in chunks around the spawn point that stays loaded
+#define SERVER_SPAWN_RADIUS 8
+// Radius in chunks around every player that stays loaded, so players always have ground to stand on
+#define SERVER_PLAYER_RADIUS 1
+// Seconds of movement a player may bank while its inputs are delayed, and the most inputs queued per player. A client
+// sending inputs faster than real time fills the queue and is disconnected.
+#define SERVER_INPUT_BUDGET 0.25f
+#define SERVER_INPUT_QUEUE (2 * PLAYER_INPUT_RATE)
+// Blocks between a player and the center of a block it edits, edits further away are ignored
+#define SERVER_EDIT_REACH 8.0f
+#define SERVER_MOB_COUNT 32
+// Seconds between tick time reports, 0 disables them
+#define SERVER_REPORT_INTERVAL 10.0
+
+struct ServerConfig {
+  std::string directory;
+  unsigned int seed;
+  std::string host;
+  uint16_t port;
+  int tickRate;
+  int spawnRadius;
+  int viewDistance;
+  int entityDistance;
+  int mobCount;
+  double reportInterval;
+  // Prints a line for every client that connects or disconnects
+  bool logClients;
+  // Job system workers, 0 for one per core next to the tick thread
+  int workers;
+
+  ServerConfig() : directory("./saves/world"), seed(1337), host("0.0.0.0"), port(SERVER_PORT), tickRate(SERVER_TICK_RATE), spawnRadius(SERVER_SPAWN_RADIUS),
+    viewDistance(INTEREST_VIEW_DISTANCE), entityDistance(INTEREST_ENTITY_DISTANCE), mobCount(SERVER_MOB_COUNT), reportInterval(SERVER_REPORT_INTERVAL),
+    logClients(true), workers(0) {}
+};
+
+struct TickStats {
+  uint64_t ticks;
+  // Ticks that started late because the previous ones took longer than the tick interval
+  uint64_t overruns;
+  double averageMs;
+  double maxMs;
+};
+
+// Game server: owns the world, its persistence and the entity simulation and advances them at a fixed tick rate. Every
+// client that connects over TCP gets a player entity; it is sent the chunks and entities around that player and
+// nothing else (see ClientInterest), entities as snapshots delta compressed against the last one the client
+// acknowledged. The time between ticks is spent waiting for client messages. Nothing here touches GL or GLFW, the
+// server only links the core library; it runs headless as bin/server, and in process behind the single player game,
+// which connects to it over loopback.
+class Server : public NetHandler {
+public:
+  // Constructor & destructor, the destructor saves the world
+  Server(const ServerConfig& config);
+  ~Server();
+
+  // Runs the tick loop until stop() is called, handling network events between ticks. When a tick overruns the loop
+  // catches up without waiting, and gives up on ticks more than a second behind instead of running them back to back.
+  void run();
+
+  // May be called from another thread or a signal handler, also before run() started, which then returns at once
+  void stop() { stopping.store(true); }
+
+  // Advances the simulation by one tick of 'dt' seconds, 'now' is the time in seconds used for autosaving
+  void tick(float dt, double now);
+
+  // Network events
+  void onConnect(ConnectionId id);
+  void onMessage(ConnectionId id, const uint8_t* data, size_t size);
+  void onDisconnect(ConnectionId id);
+
+  World& getWorld() { return world; }
+  NetLoop& getNet() { return net; }
+  ChunkStreamer& getStreamer() { return streamer; }
+  Registry& getRegistry() { return registry; }
+  JobSystem& getJobs() { return jobs; }
+
+  // The player entity of a connection, ENTITY_NULL for unknown connections
+  Entity getPlayer(ConnectionId id) const;
+  uint64_t getSnapshotBytes() const { return snapshotBytes; }
+
+  // Tick times since the last call
+  TickStats takeStats();
+
+  // Keeps the duration of every tick in milliseconds, for percentiles over a whole run (see takeTickTimes())
+  void recordTickTimes(bool enabled) { recordTicks = enabled; }
+  // Hands out the recorded tick times, oldest first. Not synchronized with run(), call it after run() returned.
+  void takeTickTimes(std::vector<float>& out);
+
+private:
+  struct Client {
+    Entity player;
+    ClientInterest interest;
+    // Received and not applied yet, oldest first
+    std::deque<PlayerInput> inputs;
+    // The player state has to be sent, because inputs were applied or the player just joined
+    bool sendState;
+    // Entity snapshots sent, and the newest one the client acknowledged (0 for none)
+    SnapshotHistory snapshots;
+    uint32_t acknowledged;
+
+    Client(Entity player, int viewDistance, int entityDistance) : player(player), interest(viewDistance, entityDistance), sendState(true),
+      acknowledged(0) {}
+  };
+
+  ServerConfig config;
+  // First, everything below submits jobs to it
+  JobSystem jobs;
+
+  WorldStorage storage;
+  World world;
+  Autosave autosave;
+  ChunkCache chunks;
+
+  Registry registry;
+  SpatialHash grid;
+  SystemScheduler scheduler;
+
+  NetLoop net;
+  ChunkStreamer streamer;
+  std::unordered_map<ConnectionId, Client> clients;
+
+  std::atomic<bool> stopping;
+  ChunkPos spawn;
+  ChunkEvictions evictions;
+  uint32_t tickCount;
+  // Bytes of entity snapshots sent, over the server's lifetime
+  uint64_t snapshotBytes;
+
+  ChunkInterestDiff chunkDiff;
+  EntityInterestDiff entityDiff;
+  std::vector<Entity> visible;
+  std::vector<PlayerInput> receivedInputs;
+  std::vector<uint8_t> message;
+
+  TickStats stats;
+  double totalMs;
+  bool recordTicks;
+  std::vector<float> tickTimes;
+
+  // Chunks the tick keeps loaded, acquired in one batch
+  std::vector<ChunkPos> loadList;
+
+  void spawnMobs();
+  // Acquires the spawn area and the chunks around every player
+  void loadChunks();
+  // Applies the queued inputs of every player, as far as their time budget allows
+  void movePlayers(float dt);
+  // Applies a block edit of a client when its player is within reach of the block
+  void editBlock(Client& client, const BlockEdit& edit);
+  // Removes the items within reach of a player
+  void pickUpItems();
+  // Updates what every client sees and sends it an entity snapshot and its player state, chunks are left to the
+  // streamer
+  void replicate();
+};
+
+#endif
@@ -0,0 +1,118 @@
+/* bit_buffer.h */
+
+#ifndef BIT_BUFFER_HEADER_H
+#define BIT_BUFFER_HEADER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Appends values of any bit width to a byte vector, least significant bit first. Small numbers whose range isn't
+// known up front use exp-Golomb codes: 0 takes 1 bit, 1-2 take 3, 3-6 take 5 and so on, two bits per doubling.
+class BitWriter {
+public:
+  std::vector<uint8_t>& out;
+
+  BitWriter(std::vector<uint8_t>& out) : out(out), word(0), count(0) {}
+
+  // Writes the low 'bits' bits of 'value', up to 32 at a time
+  void bits(uint32_t value, int bits) {
+    word |= (uint64_t)(value & mask(bits)) << count;
+    count += bits;
+    while (count >= 8) {
+      out.push_back((uint8_t)word);
+      word >>= 8;
+      count -= 8;
+    }
+  }
+
+  void flag(bool value) { bits(value ? 1 : 0, 1); }
+
+  // Values up to 2^62
+  void varUnsigned(uint64_t value) {
+    // value + 1 in binary, preceded by as many zeros as it has bits after the leading one
+    uint64_t shifted = value + 1;
+    int length = 0;
+    while ((shifted >> length) > 1) {
+      length++;
+    }
+
+    for (int i = 0; i < length; i++) {
+      flag(false);
+    }
+    flag(true);
+    for (int i = 0; i < length; i += 32) {
+      int n = length - i < 32 ? length - i : 32;
+      bits((uint32_t)(shifted >> i), n);
+    }
+  }
+
+  // Zigzag maps small magnitudes of either sign to small codes
+  void varSigned(int64_t value) { varUnsigned(((uint64_t)value << 1) ^ (uint64_t)(value >> 63)); }
+
+  // Pads the last byte with zeroes, call once after the last value
+  void flush() {
+    if (count > 0) {
+      out.push_back((uint8_t)word);
+      word = 0;
+      count = 0;
+    }
+  }
+
+private:
+  uint64_t word;
+  int count;
+
+  static uint32_t mask(int bits) { return bits >= 32 ? 0xFFFFFFFFu : (1u << bits) - 1; }
+};
+
+// Reads what a BitWriter wrote, running past the end sets 'ok' to false and returns zeroes from then on
+class BitReader {
+public:
+  const uint8_t* data;
+  size_t size;
+  size_t pos;
+  bool ok;
+
+  BitReader(const uint8_t* data, size_t size) : data(data), size(size), pos(0), ok(true) {}
+
+  uint32_t bits(int bits) {
+    uint32_t value = 0;
+    for (int i = 0; i < bits; i++) {
+      if (pos >= size * 8) {
+        ok = false;
+        return 0;
+      }
+      value |= (uint32_t)((data[pos >> 3] >> (pos & 7)) & 1) << i;
+      pos++;
+    }
+
+    return value;
+  }
+
+  bool flag() { return bits(1) != 0; }
+
+  uint64_t varUnsigned() {
+    int length = 0;
+    while (!flag()) {
+      if (!ok || ++length > 62) {
+        ok = false;
+        return 0;
+      }
+    }
+
+    uint64_t low = 0;
+    for (int i = 0; i < length; i += 32) {
+      int n = length - i < 32 ? length - i : 32;
+      low |= (uint64_t)bits(n) << i;
+    }
+    return ok ? (((uint64_t)1 << length) | low) - 1 : 0;
+  }
+
+  int64_t varSigned() {
+    uint64_t value = varUnsigned();
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+  }
+};
+
+#endif
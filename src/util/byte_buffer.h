@@ -0,0 +1,62 @@
+/* byte_buffer.h */
+
+#ifndef BYTE_BUFFER_HEADER_H
+#define BYTE_BUFFER_HEADER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+// Appends little-endian values to a byte vector, used for everything that leaves the process (disk, network)
+class ByteWriter {
+public:
+  std::vector<uint8_t>& out;
+
+  ByteWriter(std::vector<uint8_t>& out) : out(out) {}
+
+  void u8(uint8_t value) { out.push_back(value); }
+  void u16(uint16_t value) { u8(value & 0xff); u8(value >> 8); }
+  void u32(uint32_t value) { u16(value & 0xffff); u16(value >> 16); }
+  void u64(uint64_t value) { u32(value & 0xffffffff); u32(value >> 32); }
+  void f32(float value) { uint32_t bits; memcpy(&bits, &value, sizeof(bits)); u32(bits); }
+  void bytes(const uint8_t* data, size_t size) { out.insert(out.end(), data, data + size); }
+};
+
+// Reads little-endian values, running past the end sets 'ok' to false and returns zeroes from then on
+class ByteReader {
+public:
+  const uint8_t* data;
+  size_t size;
+  size_t pos;
+  bool ok;
+
+  ByteReader(const uint8_t* data, size_t size) : data(data), size(size), pos(0), ok(true) {}
+
+  uint8_t u8() {
+    if (pos >= size) {
+      ok = false;
+      return 0;
+    }
+    return data[pos++];
+  }
+  uint16_t u16() { uint16_t lo = u8(); return lo | (uint16_t)(u8() << 8); }
+  uint32_t u32() { uint32_t lo = u16(); return lo | ((uint32_t)u16() << 16); }
+  uint64_t u64() { uint64_t lo = u32(); return lo | ((uint64_t)u32() << 32); }
+  float f32() { uint32_t bits = u32(); float value; memcpy(&value, &bits, sizeof(value)); return value; }
+
+  const uint8_t* bytes(size_t count) {
+    if (count > size - pos) {
+      ok = false;
+      pos = size;
+      return NULL;
+    }
+    const uint8_t* result = data + pos;
+    pos += count;
+    return result;
+  }
+
+  size_t remaining() const { return size - pos; }
+};
+
+#endif
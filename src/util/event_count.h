@@ -0,0 +1,54 @@
+/* event_count.h */
+
+#ifndef EVENT_COUNT_HEADER_H
+#define EVENT_COUNT_HEADER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+// Lets a thread sleep until a lock-free queue has work, without putting a lock on the queue's fast path. The
+// producer publishes (pushes) and then calls notify(), which costs one atomic operation while nobody sleeps; the waiter
+// registers itself, takes the current epoch and checks its condition once more before sleeping, so a notify() that
+// races with falling asleep is never lost.
+class EventCount {
+public:
+  EventCount() : waiters(0), epoch(0) {}
+
+  void notify() {
+    // A read-modify-write rather than a load: it either comes after a waiter's registration and sees it, or before
+    // and the waiter's registration then sees everything published before this call
+    if (waiters.fetch_add(0, std::memory_order_seq_cst) == 0) {
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      epoch.fetch_add(1, std::memory_order_seq_cst);
+    }
+    wake.notify_all();
+  }
+
+  // Blocks until 'ready()' returns true, it is evaluated again after every notify()
+  template <typename F>
+  void wait(F ready) {
+    while (!ready()) {
+      waiters.fetch_add(1, std::memory_order_seq_cst);
+      uint64_t key = epoch.load(std::memory_order_seq_cst);
+      if (!ready()) {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [this, key] { return epoch.load(std::memory_order_relaxed) != key; });
+      }
+      waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+
+private:
+  std::atomic<uint32_t> waiters;
+  std::atomic<uint64_t> epoch;
+  std::mutex mutex;
+  std::condition_variable wake;
+};
+
+#endif
@@ -0,0 +1,64 @@
+/* mpsc_queue.h */
+
+#ifndef MPSC_QUEUE_HEADER_H
+#define MPSC_QUEUE_HEADER_H
+
+#include <stddef.h>
+#include <atomic>
+
+#include "spsc_queue.h"
+
+// Link embedded in the elements of an MpscQueue
+struct MpscNode {
+  MpscNode* next;
+};
+
+// Unbounded lock-free queue from any number of producer threads to one consumer thread. It is intrusive: elements
+// derive from MpscNode and the queue only links them, so pushing never allocates and the caller keeps ownership.
+// Producers push onto a stack with a single compare-and-swap, the consumer takes the whole stack with one exchange and
+// reverses it, so one pop hands out everything pushed so far in push order (per producer) and a busy consumer pays one
+// atomic operation per batch instead of one per element. Nodes are never popped one at a time from the shared head,
+// which rules out the ABA problem of lock-free stacks.
+template <typename T>
+class MpscQueue {
+public:
+  MpscQueue() : head(NULL) {}
+
+  // Producers
+  void push(T* element) {
+    MpscNode* node = element;
+    node->next = head.load(std::memory_order_relaxed);
+    while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+  }
+
+  // Consumer: everything pushed so far, oldest first and linked through 'next' (see next()), NULL when empty
+  T* popAll() {
+    MpscNode* node = head.exchange(NULL, std::memory_order_acquire);
+
+    MpscNode* reversed = NULL;
+    while (node) {
+      MpscNode* next = node->next;
+      node->next = reversed;
+      reversed = node;
+      node = next;
+    }
+
+    return static_cast<T*>(reversed);
+  }
+
+  static T* next(T* element) { return static_cast<T*>(static_cast<MpscNode*>(element)->next); }
+
+  // Either side, only a snapshot while producers keep going
+  bool empty() const { return head.load(std::memory_order_acquire) == NULL; }
+
+private:
+  char padding0[CACHE_LINE_SIZE];
+  std::atomic<MpscNode*> head;
+  char padding1[CACHE_LINE_SIZE];
+
+  MpscQueue(const MpscQueue&);
+  MpscQueue& operator=(const MpscQueue&);
+};
+
+#endif
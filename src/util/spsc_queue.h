@@ -0,0 +1,90 @@
+/* spsc_queue.h */
+
+#ifndef SPSC_QUEUE_HEADER_H
+#define SPSC_QUEUE_HEADER_H
+
+#include <stddef.h>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+// Assumed size of a cache line. Members written by different threads are kept apart with padding of this size rather
+// than alignas(), C++11 new doesn't honor extended alignment and these queues live in heap allocated objects.
+#define CACHE_LINE_SIZE 64
+
+// Bounded lock-free ring buffer between exactly one producer thread and one consumer thread. The producer owns the
+// tail and the consumer the head, each on its own cache line, and each side keeps a private copy of the other side's
+// index that it only refreshes when the queue looks full or empty, so a push or pop usually touches no cache line the
+// other thread writes. Elements are moved into preallocated slots, T needs a default constructor.
+template <typename T>
+class SpscQueue {
+public:
+  // Constructor, the capacity is rounded up to a power of two
+  SpscQueue(size_t capacity) : head(0), cachedTail(0), tail(0), cachedHead(0) {
+    size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    slots.resize(size);
+    mask = size - 1;
+  }
+
+  // Producer: false when the queue is full, 'value' is left alone then
+  bool push(T&& value) {
+    size_t position = tail.load(std::memory_order_relaxed);
+    if (position - cachedHead > mask) {
+      cachedHead = head.load(std::memory_order_acquire);
+      if (position - cachedHead > mask) {
+        return false;
+      }
+    }
+
+    slots[position & mask] = std::move(value);
+    tail.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool push(const T& value) {
+    T copy = value;
+    return push(std::move(copy));
+  }
+
+  // Consumer: false when the queue is empty
+  bool pop(T& out) {
+    size_t position = head.load(std::memory_order_relaxed);
+    if (position == cachedTail) {
+      cachedTail = tail.load(std::memory_order_acquire);
+      if (position == cachedTail) {
+        return false;
+      }
+    }
+
+    out = std::move(slots[position & mask]);
+    head.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Either side, only a snapshot while the other side keeps going
+  bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+  size_t size() const { return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire); }
+  size_t capacity() const { return mask + 1; }
+
+private:
+  char padding0[CACHE_LINE_SIZE];
+  // Consumer side
+  std::atomic<size_t> head;
+  size_t cachedTail;
+  char padding1[CACHE_LINE_SIZE];
+  // Producer side
+  std::atomic<size_t> tail;
+  size_t cachedHead;
+  char padding2[CACHE_LINE_SIZE];
+  // Read only after construction
+  std::vector<T> slots;
+  size_t mask;
+
+  SpscQueue(const SpscQueue&);
+  SpscQueue& operator=(const SpscQueue&);
+};
+
+#endif
@@ -0,0 +1,53 @@
+/* triple_buffer.h */
+
+#ifndef TRIPLE_BUFFER_HEADER_H
+#define TRIPLE_BUFFER_HEADER_H
+
+#include <stdint.h>
+#include <atomic>
+
+#include "spsc_queue.h"
+
+// Set in the shared index while it holds a value the consumer hasn't taken yet
+#define TRIPLE_BUFFER_FRESH 4
+
+// Hands the latest value from one producer thread to one consumer thread without either ever waiting. The producer
+// fills the back slot and swaps it with the shared middle slot, the consumer swaps the middle slot with its front
+// slot when a newer value is there. Values the consumer is too slow for are overwritten, it always sees the newest
+// one and keeps reading the same one until a newer arrives. Slots are reused, so a T holding vectors keeps their
+// capacity from one value to the next.
+template <typename T>
+class TripleBuffer {
+public:
+  TripleBuffer() : back(0), middle(1), front(2) {}
+
+  // Producer: the slot to fill, left as it was two publishes ago
+  T& write() { return slots[back]; }
+  void publish() { back = middle.exchange(back | TRIPLE_BUFFER_FRESH, std::memory_order_acq_rel) & 3; }
+
+  // Consumer: moves to the newest value, false when nothing was published since the last call
+  bool acquire() {
+    if (!(middle.load(std::memory_order_relaxed) & TRIPLE_BUFFER_FRESH)) {
+      return false;
+    }
+    front = middle.exchange(front, std::memory_order_acq_rel) & 3;
+    return true;
+  }
+  const T& read() const { return slots[front]; }
+
+private:
+  T slots[3];
+  char padding0[CACHE_LINE_SIZE];
+  // Producer side
+  uint8_t back;
+  char padding1[CACHE_LINE_SIZE];
+  std::atomic<uint8_t> middle;
+  char padding2[CACHE_LINE_SIZE];
+  // Consumer side
+  uint8_t front;
+
+  TripleBuffer(const TripleBuffer&);
+  TripleBuffer& operator=(const TripleBuffer&);
+};
+
+#endif
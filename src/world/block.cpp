@@ -0,0 +1,29 @@
+#include "block.h"
+
+static const BlockInfo blockInfo[BLOCK_COUNT] = {
+  // Name ------------ Opaque - Solid - Top - Side - Bottom
+  { "air",              false,   false,   0,    0,     0 },
+  { "stone",            true,    true,    1,    1,     1 },
+  { "dirt",             true,    true,    2,    2,     2 },
+  { "grass",            true,    true,    0,    3,     2 },
+  { "sand",             true,    true,   18,   18,    18 },
+  { "bedrock",          true,    true,   17,   17,    17 },
+  { "cobblestone",      true,    true,   16,   16,    16 },
+  { "planks",           true,    true,    4,    4,     4 },
+};
+
+const BlockInfo& getBlockInfo(BlockID id) {
+  if (id >= BLOCK_COUNT) {
+    return blockInfo[BLOCK_AIR];
+  }
+
+  return blockInfo[id];
+}
+
+bool isOpaque(BlockID id) {
+  return getBlockInfo(id).opaque;
+}
+
+bool isSolid(BlockID id) {
+  return getBlockInfo(id).solid;
+}
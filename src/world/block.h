@@ -0,0 +1,56 @@
+/* block.h */
+
+#ifndef BLOCK_HEADER_H
+#define BLOCK_HEADER_H
+
+#include <stdint.h>
+
+typedef uint16_t BlockID;
+
+// Block identifiers, the numeric value is what gets stored in chunks and on disk so only append to this list
+enum : BlockID {
+  BLOCK_AIR = 0,
+  BLOCK_STONE,
+  BLOCK_DIRT,
+  BLOCK_GRASS,
+  BLOCK_SAND,
+  BLOCK_BEDROCK,
+  BLOCK_COBBLESTONE,
+  BLOCK_PLANKS,
+
+  BLOCK_COUNT
+};
+
+// Faces of a block, ordered by axis so that (face ^ 1) is the opposite face
+enum BlockFace {
+  FACE_POS_X = 0,
+  FACE_NEG_X,
+  FACE_POS_Y,
+  FACE_NEG_Y,
+  FACE_POS_Z,
+  FACE_NEG_Z,
+
+  FACE_COUNT
+};
+
+struct BlockInfo {
+  const char* name;
+  bool opaque;
+  bool solid;
+
+  // Tile numbers in the 16x16 texture atlas (blocks.png)
+  unsigned char textureTop;
+  unsigned char textureSide;
+  unsigned char textureBottom;
+};
+
+// Returns the static properties of a block, unknown ids map to air
+const BlockInfo& getBlockInfo(BlockID id);
+
+// Opaque blocks hide the faces of their neighbours and occlude ambient light
+bool isOpaque(BlockID id);
+
+// Solid blocks stop players and entities
+bool isSolid(BlockID id);
+
+#endif
@@ -0,0 +1,102 @@
+#include <atomic>
+
+#include "chunk.h"
+
+static std::shared_ptr<SectionData> createEmptySection() {
+  std::shared_ptr<SectionData> empty = std::make_shared<SectionData>();
+
+  for (int i = 0; i < SECTION_VOLUME; i++) {
+    empty->blocks[i] = BLOCK_AIR;
+  }
+  empty->nonAirCount = 0;
+
+  return empty;
+}
+
+static const std::shared_ptr<SectionData>& emptySection() {
+  static std::shared_ptr<SectionData> empty = createEmptySection();
+
+  return empty;
+}
+
+Section::Section() : data(emptySection()) {
+}
+
+void Section::setBlock(int x, int y, int z, BlockID id) {
+  BlockID current = data->blocks[index(x, y, z)];
+  if (current == id) {
+    return;
+  }
+
+  SectionData& section = edit();
+
+  if (current == BLOCK_AIR) {
+    section.nonAirCount++;
+  }
+  else if (id == BLOCK_AIR) {
+    section.nonAirCount--;
+  }
+
+  section.blocks[index(x, y, z)] = id;
+}
+
+SectionData& Section::edit() {
+  // A use count above one means a snapshot (or the shared empty section) still references the data
+  if (data.use_count() > 1) {
+    data = std::make_shared<SectionData>(*data);
+  }
+  else {
+    // use_count() is a relaxed load. The last other owner may have been a job reading the data on another thread
+    // before dropping its reference, the fence pairs with that release so its reads happen before our writes.
+    std::atomic_thread_fence(std::memory_order_acquire);
+  }
+
+  return *data;
+}
+
+void Section::assign(const std::shared_ptr<const SectionData>& shared) {
+  // Safe because shared data is never written in place, edit() copies it first
+  data = std::const_pointer_cast<SectionData>(shared);
+}
+
+Chunk::Chunk(ChunkPos pos) {
+  this->pos = pos;
+  this->generation = 1;
+  this->savedGeneration = 1;
+  this->inDirtyList = false;
+}
+
+BlockID Chunk::getBlock(int x, int y, int z) const {
+  if (y < 0 || y >= CHUNK_HEIGHT) {
+    return BLOCK_AIR;
+  }
+
+  return sections[y >> SECTION_SHIFT].getBlock(x, y & SECTION_MASK, z);
+}
+
+void Chunk::setBlock(int x, int y, int z, BlockID id) {
+  if (y < 0 || y >= CHUNK_HEIGHT || getBlock(x, y, z) == id) {
+    return;
+  }
+
+  sections[y >> SECTION_SHIFT].setBlock(x, y & SECTION_MASK, z, id);
+  generation++;
+}
+
+ChunkSnapshot Chunk::snapshot() const {
+  ChunkSnapshot snapshot;
+  snapshot.pos = pos;
+  snapshot.generation = generation;
+
+  for (int i = 0; i < CHUNK_SECTIONS; i++) {
+    snapshot.sections[i] = sections[i].share();
+  }
+
+  return snapshot;
+}
+
+void Chunk::restore(const ChunkSnapshot& snapshot) {
+  for (int i = 0; i < CHUNK_SECTIONS; i++) {
+    sections[i].assign(snapshot.sections[i]);
+  }
+}
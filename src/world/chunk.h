@@ -0,0 +1,106 @@
+/* chunk.h */
+
+#ifndef CHUNK_HEADER_H
+#define CHUNK_HEADER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+
+#include "block.h"
+
+// Sections are 16x16x16 cubes of blocks, a chunk is a vertical column of sections
+#define SECTION_SHIFT 4
+#define SECTION_SIZE (1 << SECTION_SHIFT)
+#define SECTION_MASK (SECTION_SIZE - 1)
+#define SECTION_VOLUME (SECTION_SIZE * SECTION_SIZE * SECTION_SIZE)
+
+#define CHUNK_SECTIONS 8
+#define CHUNK_HEIGHT (SECTION_SIZE * CHUNK_SECTIONS)
+
+struct ChunkPos {
+  int x;
+  int z;
+
+  bool operator==(const ChunkPos& other) const { return x == other.x && z == other.z; }
+  bool operator!=(const ChunkPos& other) const { return !(*this == other); }
+};
+
+struct ChunkPosHash {
+  size_t operator()(const ChunkPos& pos) const {
+    return (size_t)(pos.x * 73856093) ^ (size_t)(pos.z * 19349663);
+  }
+};
+
+// Converts a world block coordinate to the chunk it belongs to and back
+inline int blockToChunk(int coordinate) { return coordinate >> SECTION_SHIFT; }
+inline int blockToLocal(int coordinate) { return coordinate & SECTION_MASK; }
+
+struct SectionData {
+  // Blocks are stored y-major so that a horizontal layer is contiguous
+  BlockID blocks[SECTION_VOLUME];
+
+  // Number of non-air blocks, used to skip empty sections entirely
+  unsigned int nonAirCount;
+};
+
+// Block storage of a section. The data is copy-on-write: snapshots share it and the first modification afterwards
+// copies it, so taking a snapshot costs a reference count and empty sections share a single allocation.
+class Section {
+public:
+  Section();
+
+  static int index(int x, int y, int z) { return (y * SECTION_SIZE + z) * SECTION_SIZE + x; }
+
+  BlockID getBlock(int x, int y, int z) const { return data->blocks[index(x, y, z)]; }
+  void setBlock(int x, int y, int z, BlockID id);
+
+  const BlockID* blocks() const { return data->blocks; }
+  unsigned int nonAirCount() const { return data->nonAirCount; }
+  bool isEmpty() const { return data->nonAirCount == 0; }
+
+  // Exclusive access to the block data for bulk edits, callers have to keep nonAirCount up to date
+  SectionData& edit();
+
+  std::shared_ptr<const SectionData> share() const { return data; }
+  void assign(const std::shared_ptr<const SectionData>& shared);
+
+private:
+  std::shared_ptr<SectionData> data;
+};
+
+// Immutable copy of a chunk's blocks, safe to read from other threads
+struct ChunkSnapshot {
+  ChunkPos pos;
+  uint32_t generation;
+  std::shared_ptr<const SectionData> sections[CHUNK_SECTIONS];
+};
+
+class Chunk {
+public:
+  ChunkPos pos;
+  Section sections[CHUNK_SECTIONS];
+
+  // Bumped by every block change, the chunk needs saving while it differs from the last saved generation
+  uint32_t generation;
+  uint32_t savedGeneration;
+
+  // Set while the chunk is listed in the world's dirty list
+  bool inDirtyList;
+
+  // Constructor
+  Chunk(ChunkPos pos);
+
+  // Block access in chunk local coordinates, y spans the whole column. Edits of loaded chunks should go through
+  // World::setBlock so the chunk gets listed for saving.
+  BlockID getBlock(int x, int y, int z) const;
+  void setBlock(int x, int y, int z, BlockID id);
+
+  bool isDirty() const { return generation != savedGeneration; }
+
+  ChunkSnapshot snapshot() const;
+  void restore(const ChunkSnapshot& snapshot);
+
+};
+
+#endif
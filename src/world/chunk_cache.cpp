@@ -0,0 +1,130 @@
+#include "chunk_cache.h"
+
+ChunkCache::ChunkCache(World& world, size_t cpuBudget, size_t gpuBudget) : world(world) {
+  this->cpuBudget = cpuBudget;
+  this->gpuBudget = gpuBudget;
+  this->frame = 0;
+  this->stats = ChunkCacheStats();
+}
+
+void ChunkCache::beginFrame() {
+  frame++;
+}
+
+Chunk* ChunkCache::acquire(ChunkPos pos) {
+  auto it = entries.find(pos);
+
+  if (it != entries.end()) {
+    stats.hits++;
+    it->second.lastSeen = frame;
+    lru.splice(lru.begin(), lru, it->second.lruEntry);
+
+    return world.getChunk(pos);
+  }
+
+  stats.misses++;
+
+  Chunk* chunk = world.loadChunk(pos);
+
+  lru.push_front(pos);
+  Entry entry = { lru.begin(), frame, chunkBytes(*chunk), 0 };
+  entries[pos] = entry;
+  stats.cpuBytes += entry.cpuBytes;
+
+  return chunk;
+}
+
+void ChunkCache::acquire(const std::vector<ChunkPos>& positions, JobSystem& jobs) {
+  misses.clear();
+  for (size_t i = 0; i < positions.size(); i++) {
+    if (entries.find(positions[i]) == entries.end()) {
+      misses.push_back(positions[i]);
+    }
+  }
+  world.loadChunks(misses, jobs);
+
+  // Every chunk is loaded now, this only does the bookkeeping
+  for (size_t i = 0; i < positions.size(); i++) {
+    acquire(positions[i]);
+  }
+}
+
+void ChunkCache::updateCpuBytes(ChunkPos pos) {
+  auto it = entries.find(pos);
+  Chunk* chunk = world.getChunk(pos);
+  if (it == entries.end() || !chunk) {
+    return;
+  }
+
+  stats.cpuBytes -= it->second.cpuBytes;
+  it->second.cpuBytes = chunkBytes(*chunk);
+  stats.cpuBytes += it->second.cpuBytes;
+}
+
+void ChunkCache::setGpuBytes(ChunkPos pos, size_t bytes) {
+  auto it = entries.find(pos);
+  if (it == entries.end()) {
+    return;
+  }
+
+  stats.gpuBytes -= it->second.gpuBytes;
+  it->second.gpuBytes = bytes;
+  stats.gpuBytes += bytes;
+}
+
+void ChunkCache::enforceBudget(ChunkEvictions& evictions) {
+  // Unload whole chunks while the block data is over budget
+  while (stats.cpuBytes > cpuBudget && !lru.empty()) {
+    ChunkPos pos = lru.back();
+    auto it = entries.find(pos);
+    if (it->second.lastSeen == frame) {
+      break;
+    }
+
+    Chunk* chunk = world.getChunk(pos);
+    if (chunk && chunk->isDirty()) {
+      stats.dirtyEvictions++;
+    }
+
+    stats.cpuBytes -= it->second.cpuBytes;
+    stats.gpuBytes -= it->second.gpuBytes;
+    stats.evictions++;
+
+    lru.pop_back();
+    entries.erase(it);
+    world.unloadChunk(pos);
+    evictions.chunks.push_back(pos);
+  }
+
+  // Meshes are cheap to rebuild from loaded data, drop them first when only the GPU budget is exceeded
+  for (auto it = lru.rbegin(); it != lru.rend() && stats.gpuBytes > gpuBudget; ++it) {
+    Entry& entry = entries[*it];
+    if (entry.lastSeen == frame) {
+      break;
+    }
+
+    if (entry.gpuBytes > 0) {
+      stats.gpuBytes -= entry.gpuBytes;
+      entry.gpuBytes = 0;
+      stats.meshEvictions++;
+      evictions.meshes.push_back(*it);
+    }
+  }
+}
+
+void ChunkCache::setBudget(size_t cpuBudget, size_t gpuBudget) {
+  this->cpuBudget = cpuBudget;
+  this->gpuBudget = gpuBudget;
+}
+
+size_t ChunkCache::chunkBytes(const Chunk& chunk) {
+  size_t bytes = sizeof(Chunk);
+
+  for (int i = 0; i < CHUNK_SECTIONS; i++) {
+    if (!chunk.sections[i].isEmpty()) {
+      bytes += sizeof(SectionData);
+    }
+  }
+
+  return bytes;
+}
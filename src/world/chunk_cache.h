@@ -0,0 +1,87 @@
+/* chunk_cache.h */
+
+#ifndef CHUNK_CACHE_HEADER_H
+#define CHUNK_CACHE_HEADER_H
+
+#include <stdint.h>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "world.h"
+
+#define CHUNK_CACHE_CPU_BUDGET (256 * 1024 * 1024)
+#define CHUNK_CACHE_GPU_BUDGET (128 * 1024 * 1024)
+
+struct ChunkCacheStats {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+  uint64_t dirtyEvictions;
+  uint64_t meshEvictions;
+
+  size_t cpuBytes;
+  size_t gpuBytes;
+};
+
+struct ChunkEvictions {
+  // Chunks that were unloaded, their meshes have to go as well
+  std::vector<ChunkPos> chunks;
+  // Chunks that stay loaded but should drop their GPU mesh
+  std::vector<ChunkPos> meshes;
+};
+
+// Keeps the number of loaded chunks bounded by memory instead of by radius. CPU block data and GPU mesh memory have
+// separate budgets; when one is exceeded the least recently seen chunks give up their data (or only their mesh).
+// Chunks seen during the current frame are never evicted, so a budget that is too small for the view distance
+// overshoots instead of thrashing. Dirty chunks are unloaded through the world, which keeps them for the saver.
+class ChunkCache {
+public:
+  // Constructor
+  ChunkCache(World& world, size_t cpuBudget = CHUNK_CACHE_CPU_BUDGET, size_t gpuBudget = CHUNK_CACHE_GPU_BUDGET);
+
+  // Starts a new frame, everything acquired or touched from here on counts as in use
+  void beginFrame();
+
+  // Returns the chunk, loading it on a miss, and marks it as seen
+  Chunk* acquire(ChunkPos pos);
+  // Acquires every chunk of the list, the misses are loaded in one batch so the ones that have to be generated are
+  // generated in parallel (see World::loadChunks())
+  void acquire(const std::vector<ChunkPos>& positions, JobSystem& jobs);
+
+  // Updates the accounted sizes, call after editing a chunk or (re)building its mesh
+  void updateCpuBytes(ChunkPos pos);
+  void setGpuBytes(ChunkPos pos, size_t bytes);
+
+  // Evicts the least recently seen chunks and meshes until both budgets are met
+  void enforceBudget(ChunkEvictions& evictions);
+
+  void setBudget(size_t cpuBudget, size_t gpuBudget);
+  const ChunkCacheStats& getStats() const { return stats; }
+
+  // Memory used by the block data of a chunk, shared empty sections are free
+  static size_t chunkBytes(const Chunk& chunk);
+
+private:
+  struct Entry {
+    std::list<ChunkPos>::iterator lruEntry;
+    uint64_t lastSeen;
+    size_t cpuBytes;
+    size_t gpuBytes;
+  };
+
+  World& world;
+  size_t cpuBudget;
+  size_t gpuBudget;
+  uint64_t frame;
+
+  // Most recently seen first
+  std::list<ChunkPos> lru;
+  std::unordered_map<ChunkPos, Entry, ChunkPosHash> entries;
+  // Scratch list of the batch acquire()
+  std::vector<ChunkPos> misses;
+
+  ChunkCacheStats stats;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#include <math.h>
+
+#include "generator.h"
+
+TerrainGenerator::TerrainGenerator(unsigned int seed) {
+  this->seed = seed;
+}
+
+void TerrainGenerator::generate(Chunk& chunk) const {
+  for (int z = 0; z < SECTION_SIZE; z++) {
+    for (int x = 0; x < SECTION_SIZE; x++) {
+      int iSurface = height(chunk.pos.x * SECTION_SIZE + x, chunk.pos.z * SECTION_SIZE + z);
+      BlockID top = surfaceBlock(iSurface);
+      BlockID filler = iSurface < SEA_LEVEL + 2 ? BLOCK_SAND : BLOCK_DIRT;
+
+      chunk.setBlock(x, 0, z, BLOCK_BEDROCK);
+      for (int y = 1; y < iSurface - 3; y++) {
+        chunk.setBlock(x, y, z, BLOCK_STONE);
+      }
+      for (int y = iSurface - 3; y < iSurface; y++) {
+        chunk.setBlock(x, y, z, filler);
+      }
+      chunk.setBlock(x, iSurface, z, top);
+    }
+  }
+}
+
+BlockID TerrainGenerator::surfaceBlock(int height) const {
+  return height < SEA_LEVEL + 2 ? BLOCK_SAND : BLOCK_GRASS;
+}
+
+int TerrainGenerator::height(int x, int z) const {
+  // Fractal sum of four octaves of value noise
+  float fHeight = 0.0f;
+  float fAmplitude = 1.0f;
+  float fFrequency = 1.0f / 64.0f;
+
+  for (int octave = 0; octave < 4; octave++) {
+    fHeight += noise(x * fFrequency, z * fFrequency) * fAmplitude;
+    fAmplitude *= 0.5f;
+    fFrequency *= 2.0f;
+  }
+
+  int iHeight = SEA_LEVEL + (int)(fHeight * 24.0f);
+  if (iHeight < 4) {
+    iHeight = 4;
+  }
+  if (iHeight > CHUNK_HEIGHT - 2) {
+    iHeight = CHUNK_HEIGHT - 2;
+  }
+
+  return iHeight;
+}
+
+float TerrainGenerator::noise(float x, float z) const {
+  int x0 = (int)floorf(x);
+  int z0 = (int)floorf(z);
+
+  // Smoothstep the fractional part so the lattice isn't visible
+  float fx = x - x0;
+  float fz = z - z0;
+  fx = fx * fx * (3.0f - 2.0f * fx);
+  fz = fz * fz * (3.0f - 2.0f * fz);
+
+  float a = lattice(x0, z0) + (lattice(x0 + 1, z0) - lattice(x0, z0)) * fx;
+  float b = lattice(x0, z0 + 1) + (lattice(x0 + 1, z0 + 1) - lattice(x0, z0 + 1)) * fx;
+
+  return a + (b - a) * fz;
+}
+
+float TerrainGenerator::lattice(int x, int z) const {
+  // Integer hash of the lattice point, mapped to [-1, 1]
+  unsigned int h = seed ^ ((unsigned int)x * 374761393u) ^ ((unsigned int)z * 668265263u);
+  h = (h ^ (h >> 13)) * 1274126177u;
+  h ^= h >> 16;
+
+  return (h & 0xffff) / 32767.5f - 1.0f;
+}
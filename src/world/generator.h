@@ -0,0 +1,31 @@
+/* generator.h */
+
+#ifndef GENERATOR_HEADER_H
+#define GENERATOR_HEADER_H
+
+#include "chunk.h"
+
+#define SEA_LEVEL 48
+
+class TerrainGenerator {
+public:
+  unsigned int seed;
+
+  // Constructor
+  TerrainGenerator(unsigned int seed);
+
+  // Fills a freshly allocated chunk with terrain
+  void generate(Chunk& chunk) const;
+
+  // Height of the terrain surface at a world column
+  int height(int x, int z) const;
+
+  // Block at the top of a column of the given height
+  BlockID surfaceBlock(int height) const;
+
+private:
+  float noise(float x, float z) const;
+  float lattice(int x, int z) const;
+};
+
+#endif
@@ -0,0 +1,143 @@
+#include <math.h>
+#include <float.h>
+
+#include "raycast.h"
+
+// Entering a block while stepping along an axis in the positive direction goes through its negative face
+static const BlockFace enteredFace[3][2] = {
+  { FACE_POS_X, FACE_NEG_X },
+  { FACE_POS_Y, FACE_NEG_Y },
+  { FACE_POS_Z, FACE_NEG_Z },
+};
+
+Raycaster::Raycaster(const World& world) : world(world) {
+  invalidate();
+}
+
+void Raycaster::invalidate() {
+  for (int i = 0; i < CACHE_SLOTS; i++) {
+    slots[i].valid = false;
+  }
+}
+
+const Chunk* Raycaster::lookup(ChunkPos pos) {
+  Slot& slot = slots[(unsigned int)(pos.x * 7 + pos.z) & (CACHE_SLOTS - 1)];
+
+  if (!slot.valid || slot.pos != pos) {
+    slot.pos = pos;
+    slot.chunk = world.getChunk(pos);
+    slot.valid = true;
+  }
+
+  return slot.chunk;
+}
+
+RayHit Raycaster::cast(const Ray& ray) {
+  RayHit result;
+  result.hit = false;
+  result.id = BLOCK_AIR;
+  result.face = FACE_COUNT;
+  result.normal = glm::ivec3(0);
+  result.distance = ray.maxDistance;
+
+  float length = glm::length(ray.direction);
+  if (length == 0.0f) {
+    return result;
+  }
+  glm::vec3 direction = ray.direction / length;
+
+  // The walk starts from the chunk relative offset, only the integer block coordinates are made absolute
+  const glm::vec3& local = ray.origin.local;
+  glm::vec3 floored(floorf(local.x), floorf(local.y), floorf(local.z));
+  glm::vec3 fraction = local - floored;
+  glm::ivec3 cell((int)(ray.origin.chunkX * SECTION_SIZE) + (int)floored.x, (int)floored.y, (int)(ray.origin.chunkZ * SECTION_SIZE) + (int)floored.z);
+  glm::ivec3 step;
+  glm::vec3 tMax;
+  glm::vec3 tDelta;
+
+  // Distance along the ray to the first boundary on each axis and between boundaries
+  for (int axis = 0; axis < 3; axis++) {
+    if (direction[axis] > 0.0f) {
+      step[axis] = 1;
+      tDelta[axis] = 1.0f / direction[axis];
+      tMax[axis] = (1.0f - fraction[axis]) * tDelta[axis];
+    }
+    else if (direction[axis] < 0.0f) {
+      step[axis] = -1;
+      tDelta[axis] = -1.0f / direction[axis];
+      tMax[axis] = fraction[axis] * tDelta[axis];
+    }
+    else {
+      step[axis] = 0;
+      tDelta[axis] = FLT_MAX;
+      tMax[axis] = FLT_MAX;
+    }
+  }
+
+  ChunkPos chunkPos = { blockToChunk(cell.x), blockToChunk(cell.z) };
+  const Chunk* chunk = lookup(chunkPos);
+  BlockFace face = FACE_COUNT;
+  glm::ivec3 normal(0);
+  float t = 0.0f;
+
+  while (t <= ray.maxDistance) {
+    // Above or below the world there is nothing to hit, unless the ray is heading back into it
+    if ((cell.y < 0 && step.y <= 0) || (cell.y >= CHUNK_HEIGHT && step.y >= 0)) {
+      break;
+    }
+
+    BlockID id = chunk ? chunk->getBlock(blockToLocal(cell.x), cell.y, blockToLocal(cell.z)) : (BlockID)BLOCK_AIR;
+    if (id != BLOCK_AIR) {
+      result.hit = true;
+      result.id = id;
+      result.block = cell;
+      result.face = face;
+      result.normal = normal;
+      result.distance = t;
+      return result;
+    }
+
+    int axis = tMax.x < tMax.y ? (tMax.x < tMax.z ? 0 : 2) : (tMax.y < tMax.z ? 1 : 2);
+
+    t = tMax[axis];
+    tMax[axis] += tDelta[axis];
+    cell[axis] += step[axis];
+    face = enteredFace[axis][step[axis] > 0];
+    normal = glm::ivec3(0);
+    normal[axis] = -step[axis];
+
+    // Only horizontal steps can leave the chunk column
+    if (axis != 1) {
+      ChunkPos next = { blockToChunk(cell.x), blockToChunk(cell.z) };
+      if (next != chunkPos) {
+        chunkPos = next;
+        chunk = lookup(chunkPos);
+      }
+    }
+  }
+
+  return result;
+}
+
+void Raycaster::castBatch(const Ray* rays, size_t count, RayHit* hits) {
+  for (size_t i = 0; i < count; i++) {
+    hits[i] = cast(rays[i]);
+  }
+}
+
+RayHit Raycaster::cast(const World& world, WorldPosition origin, glm::vec3 direction, float maxDistance) {
+  Raycaster raycaster(world);
+  Ray ray = { origin, direction, maxDistance };
+
+  return raycaster.cast(ray);
+}
+
+bool Raycaster::lineOfSight(const World& world, WorldPosition from, WorldPosition to) {
+  glm::vec3 delta = to - from;
+  float distance = glm::length(delta);
+  if (distance == 0.0f) {
+    return true;
+  }
+
+  return !cast(world, from, delta, distance).hit;
+}
@@ -0,0 +1,65 @@
+/* raycast.h */
+
+#ifndef RAYCAST_HEADER_H
+#define RAYCAST_HEADER_H
+
+#include <stddef.h>
+#include <glm/glm.hpp>
+
+#include "world.h"
+#include "world_position.h"
+
+struct Ray {
+  WorldPosition origin;
+  glm::vec3 direction;
+  float maxDistance;
+};
+
+struct RayHit {
+  bool hit;
+  BlockID id;
+  glm::ivec3 block;
+  // Face of the block the ray entered through, FACE_COUNT when the ray started inside the block
+  BlockFace face;
+  // Unit offset towards the block the ray came from, where a placed block goes
+  glm::ivec3 normal;
+  float distance;
+};
+
+// Amanatides & Woo voxel traversal: visits every block the ray passes through in order and stops at the first
+// non-air block. Chunk lookups are cached, the batched variant shares the cache between all rays so rays from the
+// same area (picking, line of sight checks of nearby mobs, light probes) resolve each chunk only once.
+class Raycaster {
+public:
+  // Constructor, the raycaster keeps a chunk lookup cache and must not outlive changes to the loaded chunk set
+  Raycaster(const World& world);
+
+  RayHit cast(const Ray& ray);
+  void castBatch(const Ray* rays, size_t count, RayHit* hits);
+
+  // Forgets the cached chunk pointers, call after chunks were loaded or unloaded
+  void invalidate();
+
+  // Single ray convenience
+  static RayHit cast(const World& world, WorldPosition origin, glm::vec3 direction, float maxDistance);
+
+  // Returns true when no block lies between the two points
+  static bool lineOfSight(const World& world, WorldPosition from, WorldPosition to);
+
+private:
+  // Direct mapped cache of chunk columns
+  static const int CACHE_SLOTS = 64;
+
+  struct Slot {
+    ChunkPos pos;
+    const Chunk* chunk;
+    bool valid;
+  };
+
+  const World& world;
+  Slot slots[CACHE_SLOTS];
+
+  const Chunk* lookup(ChunkPos pos);
+};
+
+#endif
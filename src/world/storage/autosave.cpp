@@ -0,0 +1,132 @@
+#include <iostream>
+
+#include "autosave.h"
+
+using namespace std;
+
+Autosave::Autosave(World& world, WorldStorage& storage, JobSystem& jobs, double interval, int partitions) : world(world), storage(storage),
+  jobs(jobs) {
+  this->interval = interval;
+  this->lastSave = 0.0;
+  this->inFlight = 0;
+
+  if (partitions < 1) {
+    partitions = 1;
+  }
+
+  for (int i = 0; i < partitions; i++) {
+    Partition* partition = new Partition();
+    partition->codec = storage.createWriteCodec();
+    this->partitions.push_back(partition);
+  }
+}
+
+Autosave::~Autosave() {
+  wait();
+
+  for (size_t i = 0; i < partitions.size(); i++) {
+    delete partitions[i]->codec;
+    delete partitions[i];
+  }
+
+  // Finished batches whose results were never applied
+  Batch* batch = results.popAll();
+  while (batch) {
+    Batch* next = MpscQueue<Batch>::next(batch);
+    delete batch;
+    batch = next;
+  }
+}
+
+void Autosave::tick(double now) {
+  applyResults();
+
+  if (now - lastSave < interval) {
+    return;
+  }
+
+  lastSave = now;
+  submit();
+}
+
+void Autosave::flush() {
+  submit();
+  wait();
+  applyResults();
+}
+
+void Autosave::wait() {
+  for (size_t i = 0; i < partitions.size(); i++) {
+    jobs.wait(partitions[i]->last);
+  }
+}
+
+void Autosave::submit() {
+  vector<ChunkSnapshot> snapshots = world.takeDirtySnapshots();
+  if (snapshots.empty()) {
+    return;
+  }
+
+  // Partition by region, a region always maps to the same partition
+  vector<Batch*> batches(partitions.size(), NULL);
+  for (size_t i = 0; i < snapshots.size(); i++) {
+    ChunkPos region = RegionFile::regionOf(snapshots[i].pos);
+    Batch*& batch = batches[ChunkPosHash()(region) % partitions.size()];
+    if (!batch) {
+      batch = new Batch();
+    }
+    batch->snapshots.push_back(std::move(snapshots[i]));
+  }
+
+  inFlight += snapshots.size();
+
+  for (size_t i = 0; i < partitions.size(); i++) {
+    if (batches[i]) {
+      Partition* partition = partitions[i];
+      Batch* batch = batches[i];
+      partition->last = jobs.then(partition->last, [this, partition, batch]() { write(partition, batch); }, JOB_LOW);
+    }
+  }
+}
+
+void Autosave::applyResults() {
+  Batch* batch = results.popAll();
+  while (batch) {
+    for (size_t i = 0; i < batch->snapshots.size(); i++) {
+      if (batch->ok) {
+        world.markSaved(batch->snapshots[i].pos, batch->snapshots[i].generation);
+      }
+      else {
+        world.markSaveFailed(batch->snapshots[i].pos);
+      }
+    }
+
+    Batch* next = MpscQueue<Batch>::next(batch);
+    delete batch;
+    batch = next;
+  }
+}
+
+void Autosave::write(Partition* partition, Batch* batch) {
+  vector<ChunkSnapshot>& snapshots = batch->snapshots;
+  vector<EncodedChunk>& encoded = partition->encoded;
+  batch->ok = true;
+  encoded.resize(snapshots.size());
+
+  try {
+    for (size_t i = 0; i < snapshots.size(); i++) {
+      WorldStorage::encodeChunk(snapshots[i], *partition->codec, encoded[i]);
+    }
+
+    // One synced batch per region file, not per chunk
+    storage.writeChunks(encoded, true);
+  }
+  catch (string& e) {
+    cerr << "Autosave failed: " << e << endl;
+    batch->ok = false;
+  }
+
+  size_t count = snapshots.size();
+  results.push(batch);
+  inFlight -= count;
+}
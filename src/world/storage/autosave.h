@@ -0,0 +1,71 @@
+/* autosave.h */
+
+#ifndef AUTOSAVE_HEADER_H
+#define AUTOSAVE_HEADER_H
+
+#include <atomic>
+#include <vector>
+
+#include "../world.h"
+#include "../../util/mpsc_queue.h"
+#include "../../jobs/job_system.h"
+#include "world_storage.h"
+
+#define AUTOSAVE_INTERVAL 30.0
+// Regions are spread over this many partitions, the writes of different partitions may run in parallel
+#define AUTOSAVE_PARTITIONS 2
+
+// Saves modified chunks in the background. The main thread only takes copy-on-write snapshots of the dirty chunks,
+// serialization, compression and the (synced) region writes run as low priority jobs. Every region always falls into
+// the same partition and each job of a partition depends on the previous one, so snapshots of a chunk reach the disk
+// in the order they were taken and a partition's codec is never used by two jobs at once. Results travel back through
+// a lock-free queue.
+class Autosave {
+public:
+  // Constructor & destructor, the destructor finishes the queued work but doesn't take new snapshots
+  Autosave(World& world, WorldStorage& storage, JobSystem& jobs, double interval = AUTOSAVE_INTERVAL, int partitions = AUTOSAVE_PARTITIONS);
+  ~Autosave();
+
+  // Called once per frame from the thread owning the world. Hands dirty chunks to the job system when the interval
+  // has passed and applies the results of finished writes.
+  void tick(double now);
+
+  // Saves everything that is dirty right now and blocks until it is on disk
+  void flush();
+
+  // Number of chunks queued or being written
+  size_t pending() const { return inFlight.load(); }
+
+private:
+  // The snapshots of one submit() for one partition, sent back as the result once written
+  struct Batch : MpscNode {
+    std::vector<ChunkSnapshot> snapshots;
+    bool ok;
+  };
+
+  struct Partition {
+    Codec* codec;
+    std::vector<EncodedChunk> encoded;
+    // The partition's newest job, the next one depends on it
+    JobHandle last;
+  };
+
+  World& world;
+  WorldStorage& storage;
+  JobSystem& jobs;
+  double interval;
+  double lastSave;
+
+  std::vector<Partition*> partitions;
+
+  MpscQueue<Batch> results;
+  std::atomic<size_t> inFlight;
+
+  void submit();
+  void applyResults();
+  void write(Partition* partition, Batch* batch);
+  // Blocks until every job submitted so far finished
+  void wait();
+};
+
+#endif
@@ -0,0 +1,148 @@
+#include "chunk_serializer.h"
+
+static int bitsForPalette(size_t paletteSize) {
+  int bits = 0;
+  while (((size_t)1 << bits) < paletteSize) {
+    bits++;
+  }
+
+  return bits;
+}
+
+void ChunkSerializer::serialize(const ChunkSnapshot& chunk, std::vector<uint8_t>& out) {
+  ByteWriter writer(out);
+
+  uint8_t sectionMask = 0;
+  for (int i = 0; i < CHUNK_SECTIONS; i++) {
+    if (chunk.sections[i]->nonAirCount > 0) {
+      sectionMask |= 1 << i;
+    }
+  }
+
+  writer.u8(CHUNK_FORMAT_VERSION);
+  writer.u8(sectionMask);
+
+  for (int i = 0; i < CHUNK_SECTIONS; i++) {
+    if (sectionMask & (1 << i)) {
+      writeSection(*chunk.sections[i], writer);
+    }
+  }
+}
+
+bool ChunkSerializer::deserialize(const uint8_t* data, size_t size, Chunk& chunk) {
+  ByteReader reader(data, size);
+
+  if (reader.u8() != CHUNK_FORMAT_VERSION) {
+    return false;
+  }
+
+  uint8_t sectionMask = reader.u8();
+  for (int i = 0; i < CHUNK_SECTIONS; i++) {
+    if (sectionMask & (1 << i)) {
+      if (!readSection(reader, chunk.sections[i].edit())) {
+        return false;
+      }
+    }
+    else {
+      chunk.sections[i] = Section();
+    }
+  }
+
+  return reader.ok;
+}
+
+void ChunkSerializer::writeSection(const SectionData& section, ByteWriter& writer) {
+  // Block id to palette index, only the entries used by this section are touched and reset afterwards
+  static thread_local uint16_t paletteIndex[65536];
+  static thread_local bool paletteUsed[65536];
+
+  std::vector<BlockID> palette;
+  for (int i = 0; i < SECTION_VOLUME; i++) {
+    BlockID block = section.blocks[i];
+    if (!paletteUsed[block]) {
+      paletteUsed[block] = true;
+      paletteIndex[block] = (uint16_t)palette.size();
+      palette.push_back(block);
+    }
+  }
+
+  writer.u16((uint16_t)palette.size());
+  for (size_t i = 0; i < palette.size(); i++) {
+    writer.u16(palette[i]);
+  }
+
+  int bits = bitsForPalette(palette.size());
+  writer.u8((uint8_t)bits);
+
+  if (bits > 0) {
+    // Indices don't straddle words, so a word holds floor(64 / bits) of them
+    int perWord = 64 / bits;
+    uint64_t word = 0;
+    int count = 0;
+
+    for (int i = 0; i < SECTION_VOLUME; i++) {
+      word |= (uint64_t)paletteIndex[section.blocks[i]] << (count * bits);
+      if (++count == perWord) {
+        writer.u64(word);
+        word = 0;
+        count = 0;
+      }
+    }
+    if (count > 0) {
+      writer.u64(word);
+    }
+  }
+
+  for (size_t i = 0; i < palette.size(); i++) {
+    paletteUsed[palette[i]] = false;
+  }
+}
+
+bool ChunkSerializer::readSection(ByteReader& reader, SectionData& section) {
+  uint16_t paletteSize = reader.u16();
+  if (paletteSize == 0 || paletteSize > SECTION_VOLUME) {
+    return false;
+  }
+
+  BlockID palette[SECTION_VOLUME];
+  for (int i = 0; i < paletteSize; i++) {
+    palette[i] = reader.u16();
+  }
+
+  int bits = reader.u8();
+  if (!reader.ok || bits != bitsForPalette(paletteSize)) {
+    return false;
+  }
+
+  unsigned int nonAir = 0;
+
+  if (bits == 0) {
+    for (int i = 0; i < SECTION_VOLUME; i++) {
+      section.blocks[i] = palette[0];
+    }
+    nonAir = palette[0] == BLOCK_AIR ? 0 : SECTION_VOLUME;
+  }
+  else {
+    int perWord = 64 / bits;
+    uint64_t mask = ((uint64_t)1 << bits) - 1;
+    int i = 0;
+
+    while (i < SECTION_VOLUME) {
+      uint64_t word = reader.u64();
+
+      for (int j = 0; j < perWord && i < SECTION_VOLUME; j++, i++) {
+        unsigned int index = (unsigned int)((word >> (j * bits)) & mask);
+        if (index >= paletteSize) {
+          return false;
+        }
+
+        section.blocks[i] = palette[index];
+        nonAir += palette[index] != BLOCK_AIR;
+      }
+    }
+  }
+
+  section.nonAirCount = nonAir;
+
+  return reader.ok;
+}
@@ -0,0 +1,28 @@
+/* chunk_serializer.h */
+
+#ifndef CHUNK_SERIALIZER_HEADER_H
+#define CHUNK_SERIALIZER_HEADER_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "../chunk.h"
+#include "../../util/byte_buffer.h"
+
+#define CHUNK_FORMAT_VERSION 1
+
+// Palette compressed chunk encoding. Every non-empty section stores the distinct block ids it contains followed by
+// the block indices into that palette, bit-packed into 64-bit words with the minimal width (0 bits for a section
+// made of a single block type). Empty sections are only present in the section mask.
+class ChunkSerializer {
+public:
+  // Snapshots can be serialized on any thread while the chunk itself keeps changing
+  static void serialize(const ChunkSnapshot& chunk, std::vector<uint8_t>& out);
+  // Returns false for truncated or corrupt data, the chunk is left in an undefined state in that case
+  static bool deserialize(const uint8_t* data, size_t size, Chunk& chunk);
+
+  static void writeSection(const SectionData& section, ByteWriter& writer);
+  static bool readSection(ByteReader& reader, SectionData& section);
+};
+
+#endif
@@ -0,0 +1,133 @@
+#include <string.h>
+#include <string>
+#include <zstd/zstd.h>
+#include <zstd/zdict.h>
+
+#include "codec.h"
+
+using namespace std;
+
+class NoneCodec : public Codec {
+public:
+  CodecID id() const { return CODEC_NONE; }
+
+  void compress(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+    out.insert(out.end(), data, data + size);
+  }
+
+  bool decompress(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+    out.assign(data, data + size);
+    return true;
+  }
+};
+
+class ZstdCodec : public Codec {
+public:
+  ZstdCodec(int level, const std::vector<uint8_t>* dictionary) {
+    this->level = level;
+    cctx = ZSTD_createCCtx();
+    dctx = ZSTD_createDCtx();
+    cdict = NULL;
+    ddict = NULL;
+
+    if (!cctx || !dctx) {
+      throw(string)"ERROR::CODEC::ZSTD_CONTEXT_FAILED";
+    }
+
+    // Digest the dictionary once, reusing the digested form is what makes small payloads cheap
+    if (dictionary) {
+      cdict = ZSTD_createCDict(dictionary->data(), dictionary->size(), level);
+      ddict = ZSTD_createDDict(dictionary->data(), dictionary->size());
+
+      if (!cdict || !ddict) {
+        throw(string)"ERROR::CODEC::ZSTD_DICTIONARY_FAILED";
+      }
+    }
+  }
+
+  ~ZstdCodec() {
+    ZSTD_freeCDict(cdict);
+    ZSTD_freeDDict(ddict);
+    ZSTD_freeCCtx(cctx);
+    ZSTD_freeDCtx(dctx);
+  }
+
+  CodecID id() const { return cdict ? CODEC_ZSTD_DICT : CODEC_ZSTD; }
+
+  void compress(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+    size_t offset = out.size();
+    out.resize(offset + ZSTD_compressBound(size));
+
+    size_t written = cdict
+      ? ZSTD_compress_usingCDict(cctx, &out[offset], out.size() - offset, data, size, cdict)
+      : ZSTD_compressCCtx(cctx, &out[offset], out.size() - offset, data, size, level);
+
+    if (ZSTD_isError(written)) {
+      throw(string)"ERROR::CODEC::ZSTD_COMPRESS_FAILED " + ZSTD_getErrorName(written);
+    }
+
+    out.resize(offset + written);
+  }
+
+  bool decompress(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+    unsigned long long contentSize = ZSTD_getFrameContentSize(data, size);
+    if (contentSize == ZSTD_CONTENTSIZE_ERROR || contentSize == ZSTD_CONTENTSIZE_UNKNOWN || contentSize > CODEC_MAX_PAYLOAD) {
+      return false;
+    }
+
+    out.resize((size_t)contentSize);
+
+    size_t read = ddict
+      ? ZSTD_decompress_usingDDict(dctx, out.data(), out.size(), data, size, ddict)
+      : ZSTD_decompressDCtx(dctx, out.data(), out.size(), data, size);
+
+    return !ZSTD_isError(read) && read == contentSize;
+  }
+
+private:
+  int level;
+  ZSTD_CCtx* cctx;
+  ZSTD_DCtx* dctx;
+  ZSTD_CDict* cdict;
+  ZSTD_DDict* ddict;
+};
+
+Codec* Codec::create(CodecID id, int level, const std::vector<uint8_t>& dictionary) {
+  if (level < ZSTD_minCLevel()) {
+    level = ZSTD_minCLevel();
+  }
+  if (level > ZSTD_maxCLevel()) {
+    level = ZSTD_maxCLevel();
+  }
+
+  switch (id) {
+  case CODEC_NONE:
+    return new NoneCodec();
+  case CODEC_ZSTD:
+    return new ZstdCodec(level, NULL);
+  case CODEC_ZSTD_DICT:
+    return dictionary.empty() ? NULL : new ZstdCodec(level, &dictionary);
+  default:
+    return NULL;
+  }
+}
+
+std::vector<uint8_t> Codec::trainDictionary(const std::vector<std::vector<uint8_t>>& samples, size_t size) {
+  // ZDICT wants all samples concatenated plus their individual sizes
+  vector<uint8_t> buffer;
+  vector<size_t> sizes;
+  for (size_t i = 0; i < samples.size(); i++) {
+    buffer.insert(buffer.end(), samples[i].begin(), samples[i].end());
+    sizes.push_back(samples[i].size());
+  }
+
+  vector<uint8_t> dictionary(size);
+  size_t trained = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(), buffer.data(), sizes.data(), (unsigned int)sizes.size());
+  if (ZDICT_isError(trained)) {
+    return vector<uint8_t>();
+  }
+
+  dictionary.resize(trained);
+
+  return dictionary;
+}
@@ -0,0 +1,49 @@
+/* codec.h */
+
+#ifndef CODEC_HEADER_H
+#define CODEC_HEADER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Codec identifiers are stored with every chunk, so only append to this list
+enum CodecID : uint8_t {
+  CODEC_NONE = 0,
+  CODEC_ZSTD,
+  CODEC_ZSTD_DICT,
+
+  CODEC_COUNT
+};
+
+// Negative zstd levels trade ratio for LZ4 class throughput and are meant for frequent (auto)saves, the high levels
+// combined with a trained dictionary are meant for archival and network transfer
+#define CODEC_LEVEL_FAST -5
+#define CODEC_LEVEL_DEFAULT 3
+#define CODEC_LEVEL_ARCHIVE 19
+
+// Upper bound on a decompressed payload, protects against corrupt size fields
+#define CODEC_MAX_PAYLOAD (4 * 1024 * 1024)
+
+#define CODEC_DICTIONARY_SIZE (16 * 1024)
+
+class Codec {
+public:
+  virtual ~Codec() {}
+
+  virtual CodecID id() const = 0;
+
+  // Appends the compressed data to 'out'
+  virtual void compress(const uint8_t* data, size_t size, std::vector<uint8_t>& out) = 0;
+  // Replaces the contents of 'out' with the decompressed data, returns false for corrupt input
+  virtual bool decompress(const uint8_t* data, size_t size, std::vector<uint8_t>& out) = 0;
+
+  // Creates a codec, returns NULL when the codec needs a dictionary and none was given.
+  // Codecs keep compression state per instance and must not be shared between threads.
+  static Codec* create(CodecID id, int level, const std::vector<uint8_t>& dictionary);
+
+  // Trains a dictionary for CODEC_ZSTD_DICT from sample payloads, returns an empty dictionary on failure
+  static std::vector<uint8_t> trainDictionary(const std::vector<std::vector<uint8_t>>& samples, size_t size = CODEC_DICTIONARY_SIZE);
+};
+
+#endif
@@ -0,0 +1,301 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+
+#include "region_file.h"
+
+using namespace std;
+
+static inline uint32_t readLE32(const uint8_t* data) {
+  return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static inline void writeLE32(uint8_t* data, uint32_t value) {
+  data[0] = value & 0xff;
+  data[1] = (value >> 8) & 0xff;
+  data[2] = (value >> 16) & 0xff;
+  data[3] = value >> 24;
+}
+
+RegionFile::RegionFile(const std::string& path) {
+  this->path = path;
+  mapping = NULL;
+  mappingSize = 0;
+
+  fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    throw(string)"ERROR::REGION::OPEN_FAILED " + path;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    close(fd);
+    throw(string)"ERROR::REGION::STAT_FAILED " + path;
+  }
+
+  // New (or truncated) files get an empty header
+  if ((size_t)info.st_size < REGION_HEADER_SECTORS * REGION_SECTOR_SIZE) {
+    vector<uint8_t> header(REGION_HEADER_SECTORS * REGION_SECTOR_SIZE, 0);
+    pwriteAll(header.data(), header.size(), 0);
+    info.st_size = header.size();
+  }
+
+  fileSectors = (info.st_size + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE;
+  remap();
+
+  usedSectors.assign(fileSectors, false);
+  for (int i = 0; i < REGION_HEADER_SECTORS; i++) {
+    usedSectors[i] = true;
+  }
+
+  for (int i = 0; i < REGION_CHUNKS; i++) {
+    locations[i] = readLE32(mapping + i * 4);
+    timestamps[i] = readLE32(mapping + REGION_SECTOR_SIZE + i * 4);
+
+    uint32_t first = locations[i] >> 8;
+    uint32_t count = locations[i] & 0xff;
+
+    // Entries pointing outside the file or into the header are dropped, the chunk will be regenerated
+    if (locations[i] != 0 && (first < REGION_HEADER_SECTORS || count == 0 || first + count > fileSectors)) {
+      locations[i] = 0;
+      continue;
+    }
+    for (uint32_t s = first; s < first + count; s++) {
+      usedSectors[s] = true;
+    }
+  }
+}
+
+RegionFile::~RegionFile() {
+  if (mapping) {
+    munmap(mapping, mappingSize);
+  }
+  close(fd);
+}
+
+bool RegionFile::read(int index, std::vector<uint8_t>& out, uint8_t& codec) {
+  lock_guard<std::mutex> lock(mutex);
+
+  uint32_t location = locations[index];
+  if (location == 0) {
+    return false;
+  }
+
+  size_t offset = (size_t)(location >> 8) * REGION_SECTOR_SIZE;
+  size_t capacity = (size_t)(location & 0xff) * REGION_SECTOR_SIZE;
+
+  if (offset + capacity > mappingSize) {
+    remap();
+  }
+
+  const uint8_t* data = mapping + offset;
+  size_t size = readLE32(data);
+  codec = data[4];
+
+  if (size > capacity - REGION_CHUNK_HEADER) {
+    return false;
+  }
+
+  out.assign(data + REGION_CHUNK_HEADER, data + REGION_CHUNK_HEADER + size);
+
+  return true;
+}
+
+void RegionFile::write(const std::vector<RegionWrite>& writes, bool sync) {
+  if (writes.empty()) {
+    return;
+  }
+
+  // Allocate every chunk first so runs of consecutive sectors can be coalesced into a single pwrite
+  struct Placement {
+    const RegionWrite* write;
+    uint32_t first;
+    uint32_t count;
+  };
+  vector<Placement> placements;
+  vector<uint32_t> replaced;
+
+  // A chunk written twice in one batch only keeps its last version, so each index gets a single placement
+  vector<bool> written(REGION_CHUNKS, false);
+
+  {
+    lock_guard<std::mutex> lock(mutex);
+
+    for (size_t i = writes.size(); i-- > 0;) {
+      if (written[writes[i].index]) {
+        continue;
+      }
+      written[writes[i].index] = true;
+
+      size_t bytes = writes[i].size + REGION_CHUNK_HEADER;
+      uint32_t count = (uint32_t)((bytes + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE);
+      if (count > REGION_MAX_CHUNK_SECTORS) {
+        for (size_t j = 0; j < placements.size(); j++) {
+          release(placements[j].first << 8 | placements[j].count);
+        }
+        throw(string)"ERROR::REGION::CHUNK_TOO_LARGE " + path;
+      }
+
+      placements.push_back({ &writes[i], allocate(count), count });
+    }
+  }
+
+  sort(placements.begin(), placements.end(), [](const Placement& a, const Placement& b) { return a.first < b.first; });
+
+  // Nothing points at the new sectors until the header is written, so a failure before that hands them back instead
+  // of leaving them allocated until the region is reopened
+  try {
+    vector<uint8_t> buffer;
+    size_t runStart = 0;
+    for (size_t i = 0; i < placements.size(); i++) {
+      const Placement& placement = placements[i];
+
+      if (buffer.empty()) {
+        runStart = (size_t)placement.first * REGION_SECTOR_SIZE;
+      }
+
+      size_t offset = buffer.size();
+      buffer.resize(offset + (size_t)placement.count * REGION_SECTOR_SIZE, 0);
+      writeLE32(&buffer[offset], (uint32_t)placement.write->size);
+      buffer[offset + 4] = placement.write->codec;
+      memcpy(&buffer[offset + REGION_CHUNK_HEADER], placement.write->data, placement.write->size);
+
+      bool last = i + 1 == placements.size();
+      if (last || placements[i + 1].first != placement.first + placement.count) {
+        pwriteAll(buffer.data(), buffer.size(), runStart);
+        buffer.clear();
+      }
+    }
+
+    // The data has to be durable before the header points at it
+    if (sync) {
+      this->sync();
+    }
+  }
+  catch (...) {
+    lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < placements.size(); i++) {
+      release(placements[i].first << 8 | placements[i].count);
+    }
+    throw;
+  }
+
+  // Point the header at the new data, the old sectors are only released once the new header is durable
+  {
+    lock_guard<std::mutex> lock(mutex);
+
+    uint32_t now = (uint32_t)time(NULL);
+    for (size_t i = 0; i < placements.size(); i++) {
+      int index = placements[i].write->index;
+
+      if (locations[index] != 0) {
+        replaced.push_back(locations[index]);
+      }
+      locations[index] = placements[i].first << 8 | placements[i].count;
+      timestamps[index] = now;
+    }
+
+    uint8_t header[REGION_HEADER_SECTORS * REGION_SECTOR_SIZE];
+    for (int i = 0; i < REGION_CHUNKS; i++) {
+      writeLE32(header + i * 4, locations[i]);
+      writeLE32(header + REGION_SECTOR_SIZE + i * 4, timestamps[i]);
+    }
+    pwriteAll(header, sizeof(header), 0);
+  }
+
+  if (sync) {
+    this->sync();
+  }
+
+  lock_guard<std::mutex> lock(mutex);
+  for (size_t i = 0; i < replaced.size(); i++) {
+    release(replaced[i]);
+  }
+}
+
+void RegionFile::remap() {
+  if (mapping) {
+    munmap(mapping, mappingSize);
+    mapping = NULL;
+  }
+
+  mappingSize = fileSectors * REGION_SECTOR_SIZE;
+  void* address = mmap(NULL, mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+  if (address == MAP_FAILED) {
+    mappingSize = 0;
+    throw(string)"ERROR::REGION::MMAP_FAILED " + path;
+  }
+
+  mapping = (uint8_t*)address;
+}
+
+uint32_t RegionFile::allocate(uint32_t count) {
+  // First fit over the free sectors, otherwise grow the file
+  uint32_t run = 0;
+  for (uint32_t s = REGION_HEADER_SECTORS; s < usedSectors.size(); s++) {
+    run = usedSectors[s] ? 0 : run + 1;
+
+    if (run == count) {
+      uint32_t first = s + 1 - count;
+      for (uint32_t i = first; i <= s; i++) {
+        usedSectors[i] = true;
+      }
+      return first;
+    }
+  }
+
+  uint32_t first = (uint32_t)usedSectors.size() - run;
+  usedSectors.resize(first + count, false);
+  for (uint32_t i = first; i < first + count; i++) {
+    usedSectors[i] = true;
+  }
+
+  if (first + count > fileSectors) {
+    fileSectors = first + count;
+  }
+
+  return first;
+}
+
+void RegionFile::release(uint32_t location) {
+  uint32_t first = location >> 8;
+  uint32_t count = location & 0xff;
+
+  for (uint32_t s = first; s < first + count && s < usedSectors.size(); s++) {
+    usedSectors[s] = false;
+  }
+}
+
+void RegionFile::sync() {
+#ifdef __APPLE__
+  // fsync doesn't reach the platter on macOS
+  int result = fcntl(fd, F_FULLFSYNC);
+#else
+  int result = fdatasync(fd);
+#endif
+
+  if (result != 0) {
+    throw(string)"ERROR::REGION::SYNC_FAILED " + path;
+  }
+}
+
+void RegionFile::pwriteAll(const uint8_t* data, size_t size, size_t offset) {
+  while (size > 0) {
+    ssize_t written = pwrite(fd, data, size, offset);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw(string)"ERROR::REGION::WRITE_FAILED " + path;
+    }
+
+    data += written;
+    size -= written;
+    offset += written;
+  }
+}
@@ -0,0 +1,76 @@
+/* region_file.h */
+
+#ifndef REGION_FILE_HEADER_H
+#define REGION_FILE_HEADER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <mutex>
+
+#include "../chunk.h"
+
+// A region file holds 32x32 chunk columns
+#define REGION_SHIFT 5
+#define REGION_SIZE (1 << REGION_SHIFT)
+#define REGION_CHUNKS (REGION_SIZE * REGION_SIZE)
+
+// The file is divided in 4 KiB sectors. The first two sectors are the header: one 32-bit location per chunk
+// (first sector << 8 | sector count, 0 when absent) followed by one 32-bit modification time per chunk.
+#define REGION_SECTOR_SIZE 4096
+#define REGION_HEADER_SECTORS 2
+#define REGION_MAX_CHUNK_SECTORS 255
+
+// Every stored chunk starts with its payload length and codec id
+#define REGION_CHUNK_HEADER 5
+
+struct RegionWrite {
+  int index;
+  uint8_t codec;
+  const uint8_t* data;
+  size_t size;
+};
+
+class RegionFile {
+public:
+  // Constructor & destructor, creates the file when it doesn't exist
+  RegionFile(const std::string& path);
+  ~RegionFile();
+
+  static ChunkPos regionOf(ChunkPos pos) { return { pos.x >> REGION_SHIFT, pos.z >> REGION_SHIFT }; }
+  static int chunkIndex(ChunkPos pos) { return (pos.x & (REGION_SIZE - 1)) + (pos.z & (REGION_SIZE - 1)) * REGION_SIZE; }
+
+  // Copies the stored payload out of the read-only mapping, returns false when the chunk isn't stored
+  bool read(int index, std::vector<uint8_t>& out, uint8_t& codec);
+
+  // Stores a batch of chunks. New data always goes to free sectors and the header is only updated afterwards, so
+  // an interrupted write leaves the previous version of every chunk intact. With 'sync' the data is flushed before
+  // the header is written and the header before the old sectors are reused, which makes the batch crash safe at
+  // the cost of two fdatasync calls per batch. Reads can proceed while a batch is being written, concurrent writes
+  // to the same file are allowed but their order is not defined. Of several writes to one chunk in a batch the last
+  // one is stored.
+  void write(const std::vector<RegionWrite>& writes, bool sync);
+
+private:
+  std::string path;
+  int fd;
+
+  // Guards the header, the sector map and the mapping; file I/O itself happens outside the lock
+  std::mutex mutex;
+
+  uint8_t* mapping;
+  size_t mappingSize;
+  size_t fileSectors;
+
+  uint32_t locations[REGION_CHUNKS];
+  uint32_t timestamps[REGION_CHUNKS];
+  std::vector<bool> usedSectors;
+
+  void remap();
+  uint32_t allocate(uint32_t count);
+  void release(uint32_t location);
+  void pwriteAll(const uint8_t* data, size_t size, size_t offset);
+  void sync();
+};
+
+#endif
@@ -0,0 +1,191 @@
+#include <sys/stat.h>
+#include <errno.h>
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+
+#include "world_storage.h"
+#include "chunk_serializer.h"
+
+using namespace std;
+
+#define DICTIONARY_FILE "/chunks.dict"
+
+static void makeDirectories(const std::string& path) {
+  for (size_t i = 1; i <= path.size(); i++) {
+    if (i == path.size() || path[i] == '/') {
+      string parent = path.substr(0, i);
+      if (mkdir(parent.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw(string)"ERROR::STORAGE::MKDIR_FAILED " + parent;
+      }
+    }
+  }
+}
+
+WorldStorage::WorldStorage(const std::string& directory, size_t maxOpenRegions) {
+  this->directory = directory;
+  this->maxOpenRegions = maxOpenRegions > 0 ? maxOpenRegions : 1;
+
+  makeDirectories(directory);
+
+  ifstream dictionaryFile(directory + DICTIONARY_FILE, ios::binary);
+  if (dictionaryFile) {
+    dictionary.assign(istreambuf_iterator<char>(dictionaryFile), istreambuf_iterator<char>());
+  }
+
+  for (int i = 0; i < CODEC_COUNT; i++) {
+    readCodecs[i] = Codec::create((CodecID)i, CODEC_LEVEL_DEFAULT, dictionary);
+  }
+
+  writeCodecID = CODEC_ZSTD;
+  writeCodecLevel = CODEC_LEVEL_FAST;
+  writeCodec = Codec::create(writeCodecID, writeCodecLevel, dictionary);
+}
+
+WorldStorage::~WorldStorage() {
+  for (int i = 0; i < CODEC_COUNT; i++) {
+    delete readCodecs[i];
+  }
+  delete writeCodec;
+}
+
+void WorldStorage::setCodec(CodecID id, int level) {
+  Codec* codec = Codec::create(id, level, dictionary);
+  if (!codec) {
+    throw(string)"ERROR::STORAGE::CODEC_UNAVAILABLE";
+  }
+
+  delete writeCodec;
+  writeCodec = codec;
+  writeCodecID = id;
+  writeCodecLevel = level;
+}
+
+Codec* WorldStorage::createWriteCodec() const {
+  return Codec::create(writeCodecID, writeCodecLevel, dictionary);
+}
+
+bool WorldStorage::trainDictionary(const std::vector<ChunkSnapshot>& samples) {
+  if (!dictionary.empty()) {
+    return false;
+  }
+
+  vector<vector<uint8_t>> payloads(samples.size());
+  for (size_t i = 0; i < samples.size(); i++) {
+    ChunkSerializer::serialize(samples[i], payloads[i]);
+  }
+
+  vector<uint8_t> trained = Codec::trainDictionary(payloads);
+  if (trained.empty()) {
+    return false;
+  }
+
+  ofstream dictionaryFile(directory + DICTIONARY_FILE, ios::binary | ios::trunc);
+  dictionaryFile.write((const char*)trained.data(), trained.size());
+  if (!dictionaryFile) {
+    throw(string)"ERROR::STORAGE::DICTIONARY_WRITE_FAILED";
+  }
+
+  dictionary = trained;
+  delete readCodecs[CODEC_ZSTD_DICT];
+  readCodecs[CODEC_ZSTD_DICT] = Codec::create(CODEC_ZSTD_DICT, CODEC_LEVEL_DEFAULT, dictionary);
+
+  return true;
+}
+
+bool WorldStorage::loadChunk(Chunk& chunk) {
+  shared_ptr<RegionFile> region = getRegion(RegionFile::regionOf(chunk.pos));
+
+  uint8_t codec;
+  if (!region->read(RegionFile::chunkIndex(chunk.pos), compressed, codec)) {
+    return false;
+  }
+
+  bool decoded = codec < CODEC_COUNT && readCodecs[codec] && readCodecs[codec]->decompress(compressed.data(), compressed.size(), scratch);
+
+  if (!decoded || !ChunkSerializer::deserialize(scratch.data(), scratch.size(), chunk)) {
+    cerr << "Discarding unreadable chunk " << chunk.pos.x << ", " << chunk.pos.z << endl;
+    chunk = Chunk(chunk.pos);
+    return false;
+  }
+
+  return true;
+}
+
+void WorldStorage::saveChunks(const std::vector<ChunkSnapshot>& chunks) {
+  vector<EncodedChunk> encoded(chunks.size());
+  for (size_t i = 0; i < chunks.size(); i++) {
+    encodeChunk(chunks[i], *writeCodec, encoded[i]);
+  }
+
+  writeChunks(encoded, true);
+}
+
+void WorldStorage::encodeChunk(const ChunkSnapshot& chunk, Codec& codec, EncodedChunk& out) {
+  static thread_local vector<uint8_t> serialized;
+
+  serialized.clear();
+  ChunkSerializer::serialize(chunk, serialized);
+
+  out.pos = chunk.pos;
+  out.generation = chunk.generation;
+  out.codec = codec.id();
+  out.data.clear();
+  codec.compress(serialized.data(), serialized.size(), out.data);
+}
+
+void WorldStorage::writeChunks(const std::vector<EncodedChunk>& chunks, bool sync) {
+  // Group by region so each region file receives a single batch
+  vector<const EncodedChunk*> sorted;
+  for (size_t i = 0; i < chunks.size(); i++) {
+    sorted.push_back(&chunks[i]);
+  }
+  sort(sorted.begin(), sorted.end(), [](const EncodedChunk* a, const EncodedChunk* b) {
+    ChunkPos ra = RegionFile::regionOf(a->pos);
+    ChunkPos rb = RegionFile::regionOf(b->pos);
+    return ra.x != rb.x ? ra.x < rb.x : ra.z < rb.z;
+  });
+
+  vector<RegionWrite> batch;
+  for (size_t i = 0; i < sorted.size(); i++) {
+    batch.push_back({ RegionFile::chunkIndex(sorted[i]->pos), sorted[i]->codec, sorted[i]->data.data(), sorted[i]->data.size() });
+
+    ChunkPos region = RegionFile::regionOf(sorted[i]->pos);
+    if (i + 1 == sorted.size() || RegionFile::regionOf(sorted[i + 1]->pos) != region) {
+      getRegion(region)->write(batch, sync);
+      batch.clear();
+    }
+  }
+}
+
+std::shared_ptr<RegionFile> WorldStorage::getRegion(ChunkPos region) {
+  lock_guard<mutex> lock(regionsMutex);
+
+  auto it = regions.find(region);
+  if (it != regions.end()) {
+    lru.splice(lru.begin(), lru, it->second.lruEntry);
+    return it->second.file;
+  }
+
+  // Close the least recently used file that no other thread is using, a second instance of a file that is still in
+  // use would have its own copy of the header and sector map
+  if (regions.size() >= maxOpenRegions) {
+    for (auto candidate = lru.rbegin(); candidate != lru.rend(); ++candidate) {
+      auto open = regions.find(*candidate);
+      if (open->second.file.use_count() == 1) {
+        lru.erase(open->second.lruEntry);
+        regions.erase(open);
+        break;
+      }
+    }
+  }
+
+  string path = directory + "/r." + to_string(region.x) + "." + to_string(region.z) + ".region";
+  shared_ptr<RegionFile> file = make_shared<RegionFile>(path);
+
+  lru.push_front(region);
+  regions[region] = { file, lru.begin() };
+
+  return file;
+}
@@ -0,0 +1,81 @@
+/* world_storage.h */
+
+#ifndef WORLD_STORAGE_HEADER_H
+#define WORLD_STORAGE_HEADER_H
+
+#include <stdint.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "region_file.h"
+#include "codec.h"
+
+struct EncodedChunk {
+  ChunkPos pos;
+  uint32_t generation;
+  CodecID codec;
+  std::vector<uint8_t> data;
+};
+
+// Loads and saves chunks through region files. Only a bounded number of region files is kept open, the least
+// recently used one is closed when another region is needed. Loading and writing may happen on different threads.
+class WorldStorage {
+public:
+  // Constructor & destructor, creates the world directory when needed
+  WorldStorage(const std::string& directory, size_t maxOpenRegions = 64);
+  ~WorldStorage();
+
+  // Fills the chunk from disk, returns false when it was never saved or can't be decoded. Not reentrant, meant to
+  // be called from the thread that owns the world.
+  bool loadChunk(Chunk& chunk);
+
+  // Serializes, compresses and writes the chunks synchronously with one crash safe batch per region file
+  void saveChunks(const std::vector<ChunkSnapshot>& chunks);
+
+  // Serializes and compresses a snapshot, thread safe as long as every thread uses its own codec
+  static void encodeChunk(const ChunkSnapshot& chunk, Codec& codec, EncodedChunk& out);
+
+  // Writes already encoded chunks, grouped per region file. Thread safe.
+  void writeChunks(const std::vector<EncodedChunk>& chunks, bool sync);
+
+  // Selects the codec used for writing, chunks are always read back with the codec they were written with.
+  // Background savers create their codecs with createWriteCodec(), so select the codec before starting them.
+  void setCodec(CodecID id, int level);
+  Codec* createWriteCodec() const;
+
+  // Trains the dictionary for CODEC_ZSTD_DICT from sample chunks and stores it with the world. Chunks reference the
+  // dictionary they were compressed with, so a world keeps its first dictionary and this returns false afterwards.
+  bool trainDictionary(const std::vector<ChunkSnapshot>& samples);
+
+private:
+  struct OpenRegion {
+    std::shared_ptr<RegionFile> file;
+    std::list<ChunkPos>::iterator lruEntry;
+  };
+
+  std::string directory;
+  size_t maxOpenRegions;
+
+  std::vector<uint8_t> dictionary;
+  CodecID writeCodecID;
+  int writeCodecLevel;
+  Codec* writeCodec;
+  Codec* readCodecs[CODEC_COUNT];
+
+  // Guards the open region map, the files themselves are thread safe and stay alive while they are being used
+  std::mutex regionsMutex;
+  std::unordered_map<ChunkPos, OpenRegion, ChunkPosHash> regions;
+  std::list<ChunkPos> lru;
+
+  // Buffers for loading
+  std::vector<uint8_t> compressed;
+  std::vector<uint8_t> scratch;
+
+  std::shared_ptr<RegionFile> getRegion(ChunkPos region);
+};
+
+#endif
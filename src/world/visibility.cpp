@@ -0,0 +1,79 @@
+#include <string.h>
+
+#include "visibility.h"
+
+FaceConnectivity computeConnectivity(const SectionData& data) {
+  if (data.nonAirCount == 0) {
+    return CONNECTIVITY_ALL;
+  }
+
+  // Opaque blocks start out visited so the fill never enters them
+  bool visited[SECTION_VOLUME];
+  int open = 0;
+  for (int i = 0; i < SECTION_VOLUME; i++) {
+    visited[i] = isOpaque(data.blocks[i]);
+    open += !visited[i];
+  }
+  if (open == 0) {
+    return CONNECTIVITY_NONE;
+  }
+
+  FaceConnectivity connectivity = CONNECTIVITY_NONE;
+  int stack[SECTION_VOLUME];
+
+  for (int start = 0; start < SECTION_VOLUME; start++) {
+    if (visited[start]) {
+      continue;
+    }
+
+    int faces = 0;
+    int top = 0;
+    stack[top++] = start;
+    visited[start] = true;
+
+    while (top > 0) {
+      int index = stack[--top];
+      int x = index & SECTION_MASK;
+      int z = (index >> SECTION_SHIFT) & SECTION_MASK;
+      int y = index >> (2 * SECTION_SHIFT);
+
+      // Blocks on the border open the region to that face, otherwise continue into the neighbour
+      int neighbours[FACE_COUNT] = {
+        x == SECTION_MASK ? -1 : index + 1,
+        x == 0 ? -1 : index - 1,
+        y == SECTION_MASK ? -1 : index + SECTION_SIZE * SECTION_SIZE,
+        y == 0 ? -1 : index - SECTION_SIZE * SECTION_SIZE,
+        z == SECTION_MASK ? -1 : index + SECTION_SIZE,
+        z == 0 ? -1 : index - SECTION_SIZE,
+      };
+
+      for (int f = 0; f < FACE_COUNT; f++) {
+        int neighbour = neighbours[f];
+        if (neighbour < 0) {
+          faces |= 1 << f;
+        }
+        else if (!visited[neighbour]) {
+          visited[neighbour] = true;
+          stack[top++] = neighbour;
+        }
+      }
+    }
+
+    for (int a = 0; a < FACE_COUNT; a++) {
+      if (!(faces & (1 << a))) {
+        continue;
+      }
+      for (int b = 0; b < FACE_COUNT; b++) {
+        if (faces & (1 << b)) {
+          connectivity |= (FaceConnectivity)1 << (a * FACE_COUNT + b);
+        }
+      }
+    }
+
+    if (connectivity == CONNECTIVITY_ALL) {
+      break;
+    }
+  }
+
+  return connectivity;
+}
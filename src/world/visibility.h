@@ -0,0 +1,24 @@
+/* visibility.h */
+
+#ifndef VISIBILITY_HEADER_H
+#define VISIBILITY_HEADER_H
+
+#include <stdint.h>
+
+#include "chunk.h"
+
+// Which pairs of section faces are connected through non-opaque blocks, bit (a * FACE_COUNT + b) is set when a ray
+// could enter through face a and leave through face b. This is what the occlusion flood fill walks.
+typedef uint64_t FaceConnectivity;
+
+#define CONNECTIVITY_ALL ((((FaceConnectivity)1) << (FACE_COUNT * FACE_COUNT)) - 1)
+#define CONNECTIVITY_NONE ((FaceConnectivity)0)
+
+inline bool facesConnected(FaceConnectivity connectivity, int a, int b) {
+  return (connectivity >> (a * FACE_COUNT + b)) & 1;
+}
+
+// Flood fills the non-opaque blocks of a section and connects every pair of faces touched by the same open region
+FaceConnectivity computeConnectivity(const SectionData& data);
+
+#endif
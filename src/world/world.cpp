@@ -0,0 +1,220 @@
+#include "world.h"
+
+World::World(unsigned int seed, WorldStorage* storage) : generator(seed) {
+  this->storage = storage;
+  logChanges = false;
+}
+
+World::~World() {
+  for (auto& entry : chunks) {
+    delete entry.second;
+  }
+}
+
+Chunk* World::getChunk(ChunkPos pos) const {
+  auto it = chunks.find(pos);
+  if (it == chunks.end()) {
+    return NULL;
+  }
+
+  return it->second;
+}
+
+Chunk* World::loadChunk(ChunkPos pos) {
+  Chunk* chunk = getChunk(pos);
+  if (chunk) {
+    return chunk;
+  }
+
+  if (!readChunk(chunk, pos)) {
+    // Freshly generated chunks are saved as well, reading them back is cheaper than generating them
+    generator.generate(*chunk);
+    markDirty(chunk);
+  }
+
+  return chunk;
+}
+
+void World::loadChunks(const std::vector<ChunkPos>& positions, JobSystem& jobs) {
+  std::vector<Chunk*> generated;
+  std::vector<JobHandle> handles;
+
+  for (size_t i = 0; i < positions.size(); i++) {
+    Chunk* chunk = getChunk(positions[i]);
+    if (chunk || readChunk(chunk, positions[i])) {
+      continue;
+    }
+
+    // Generation only reads the seed, every job writes its own chunk
+    const TerrainGenerator* terrain = &generator;
+    generated.push_back(chunk);
+    handles.push_back(jobs.submit([terrain, chunk]() { terrain->generate(*chunk); }, JOB_HIGH));
+  }
+
+  jobs.wait(handles);
+  for (size_t i = 0; i < generated.size(); i++) {
+    markDirty(generated[i]);
+  }
+}
+
+bool World::readChunk(Chunk*& chunk, ChunkPos pos) {
+  chunk = new Chunk(pos);
+  chunks[pos] = chunk;
+
+  auto pending = unsaved.find(pos);
+  if (pending != unsaved.end()) {
+    // The disk copy is stale, continue from the snapshot that is still waiting to be written
+    chunk->restore(pending->second.snapshot);
+    chunk->generation = pending->second.snapshot.generation;
+    chunk->savedGeneration = chunk->generation - 1;
+    unsaved.erase(pending);
+    markDirty(chunk);
+    return true;
+  }
+
+  return storage && storage->loadChunk(*chunk);
+}
+
+Chunk* World::createChunk(ChunkPos pos) {
+  Chunk* chunk = getChunk(pos);
+  if (!chunk) {
+    chunk = new Chunk(pos);
+    chunks[pos] = chunk;
+  }
+
+  return chunk;
+}
+
+void World::unloadChunk(ChunkPos pos) {
+  auto it = chunks.find(pos);
+  if (it == chunks.end()) {
+    return;
+  }
+
+  Chunk* chunk = it->second;
+  if (storage && chunk->isDirty()) {
+    unsaved[pos] = { chunk->snapshot(), false };
+    dirtyChunks.push_back(pos);
+  }
+
+  delete chunk;
+  chunks.erase(it);
+}
+
+BlockID World::getBlock(int x, int y, int z) const {
+  if (y < 0 || y >= CHUNK_HEIGHT) {
+    return BLOCK_AIR;
+  }
+
+  Chunk* chunk = getChunk({ blockToChunk(x), blockToChunk(z) });
+  if (!chunk) {
+    return BLOCK_AIR;
+  }
+
+  return chunk->getBlock(blockToLocal(x), y, blockToLocal(z));
+}
+
+void World::setBlock(int x, int y, int z, BlockID id) {
+  Chunk* chunk = getChunk({ blockToChunk(x), blockToChunk(z) });
+  if (!chunk) {
+    return;
+  }
+
+  if (logChanges && y >= 0 && y < CHUNK_HEIGHT && chunk->getBlock(blockToLocal(x), y, blockToLocal(z)) != id) {
+    BlockChange change = { x, y, z, id };
+    changes.push_back(change);
+  }
+
+  chunk->setBlock(blockToLocal(x), y, blockToLocal(z), id);
+
+  if (chunk->isDirty()) {
+    markDirty(chunk);
+  }
+}
+
+void World::setChangeLog(bool enabled) {
+  logChanges = enabled;
+  if (!enabled) {
+    changes.clear();
+  }
+}
+
+void World::takeChanges(std::vector<BlockChange>& out) {
+  out.clear();
+  out.swap(changes);
+}
+
+std::vector<ChunkSnapshot> World::takeDirtySnapshots() {
+  std::vector<ChunkSnapshot> snapshots;
+  snapshots.reserve(dirtyChunks.size());
+
+  for (size_t i = 0; i < dirtyChunks.size(); i++) {
+    Chunk* chunk = getChunk(dirtyChunks[i]);
+
+    if (chunk) {
+      chunk->inDirtyList = false;
+      if (chunk->isDirty()) {
+        snapshots.push_back(chunk->snapshot());
+      }
+      continue;
+    }
+
+    auto pending = unsaved.find(dirtyChunks[i]);
+    if (pending != unsaved.end() && !pending->second.queued) {
+      pending->second.queued = true;
+      snapshots.push_back(pending->second.snapshot);
+    }
+  }
+
+  dirtyChunks.clear();
+
+  return snapshots;
+}
+
+void World::markSaved(ChunkPos pos, uint32_t generation) {
+  Chunk* chunk = getChunk(pos);
+  if (chunk && (int32_t)(generation - chunk->savedGeneration) > 0) {
+    chunk->savedGeneration = generation;
+  }
+
+  auto pending = unsaved.find(pos);
+  if (pending != unsaved.end() && pending->second.snapshot.generation == generation) {
+    unsaved.erase(pending);
+  }
+}
+
+void World::markSaveFailed(ChunkPos pos) {
+  Chunk* chunk = getChunk(pos);
+  if (chunk) {
+    if (chunk->isDirty()) {
+      markDirty(chunk);
+    }
+    return;
+  }
+
+  auto pending = unsaved.find(pos);
+  if (pending != unsaved.end()) {
+    pending->second.queued = false;
+    dirtyChunks.push_back(pos);
+  }
+}
+
+void World::save() {
+  if (!storage) {
+    return;
+  }
+
+  std::vector<ChunkSnapshot> snapshots = takeDirtySnapshots();
+  storage->saveChunks(snapshots);
+
+  for (size_t i = 0; i < snapshots.size(); i++) {
+    markSaved(snapshots[i].pos, snapshots[i].generation);
+  }
+}
+
+void World::markDirty(Chunk* chunk) {
+  if (!chunk->inDirtyList) {
+    chunk->inDirtyList = true;
+    dirtyChunks.push_back(chunk->pos);
+  }
+}
@@ -0,0 +1,85 @@
+/* world.h */
+
+#ifndef WORLD_HEADER_H
+#define WORLD_HEADER_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "chunk.h"
+#include "generator.h"
+#include "storage/world_storage.h"
+#include "../jobs/job_system.h"
+
+// A block edit in world coordinates
+struct BlockChange {
+  int x;
+  int y;
+  int z;
+  BlockID id;
+};
+
+class World {
+public:
+  TerrainGenerator generator;
+
+  // Constructor & destructor, without storage chunks are always generated and never saved
+  World(unsigned int seed, WorldStorage* storage = NULL);
+  ~World();
+
+  // Returns a loaded chunk or NULL when it isn't loaded
+  Chunk* getChunk(ChunkPos pos) const;
+
+  // Returns the chunk, reading it from storage or generating it first when it isn't loaded yet
+  Chunk* loadChunk(ChunkPos pos);
+  // Loads every chunk of the list like loadChunk(). Storage reads stay on the calling thread, the chunks that have to
+  // be generated are generated in parallel on the job system while the calling thread helps.
+  void loadChunks(const std::vector<ChunkPos>& positions, JobSystem& jobs);
+  // Frees the chunk, a modified chunk is kept as a snapshot until it has been saved
+  void unloadChunk(ChunkPos pos);
+  // Returns the loaded chunk, or adds an empty one without reading or generating it, for chunks that arrive over the
+  // network and are filled in by the caller
+  Chunk* createChunk(ChunkPos pos);
+
+  // Block access in world coordinates, unloaded or out of range blocks read as air
+  BlockID getBlock(int x, int y, int z) const;
+  void setBlock(int x, int y, int z, BlockID id);
+
+  // While enabled setBlock() records every edit that changes a block, takeChanges() hands them out in order
+  void setChangeLog(bool enabled);
+  void takeChanges(std::vector<BlockChange>& out);
+
+  // Snapshots every chunk modified since it was last taken, in O(number of modified chunks). The chunks stay dirty
+  // until the saver reports back through markSaved() or markSaveFailed().
+  std::vector<ChunkSnapshot> takeDirtySnapshots();
+  void markSaved(ChunkPos pos, uint32_t generation);
+  void markSaveFailed(ChunkPos pos);
+
+  // Writes all modified chunks to storage synchronously
+  void save();
+
+  const std::unordered_map<ChunkPos, Chunk*, ChunkPosHash>& getChunks() const { return chunks; }
+
+private:
+  struct UnloadedChunk {
+    ChunkSnapshot snapshot;
+    bool queued;
+  };
+
+  WorldStorage* storage;
+  std::unordered_map<ChunkPos, Chunk*, ChunkPosHash> chunks;
+
+  // Chunks (loaded or not) that changed since the last call to takeDirtySnapshots()
+  std::vector<ChunkPos> dirtyChunks;
+  // Unloaded chunks whose latest changes aren't on disk yet
+  std::unordered_map<ChunkPos, UnloadedChunk, ChunkPosHash> unsaved;
+
+  bool logChanges;
+  std::vector<BlockChange> changes;
+
+  void markDirty(Chunk* chunk);
+  // Adds an empty chunk and fills it from the unsaved snapshots or from storage, false when it has to be generated
+  bool readChunk(Chunk*& chunk, ChunkPos pos);
+};
+
+#endif
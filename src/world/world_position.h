@@ -0,0 +1,72 @@
+/* world_position.h */
+
+#ifndef WORLD_POSITION_HEADER_H
+#define WORLD_POSITION_HEADER_H
+
+#include <stdint.h>
+#include <math.h>
+#include <glm/glm.hpp>
+
+#include "chunk.h"
+
+// A position anywhere in the world: the chunk column as 64 bit integers plus a float offset from the column's origin.
+// The horizontal offset is kept within [0, SECTION_SIZE) so positions are exactly as precise a million blocks out as
+// they are at the origin. Distances between positions are computed from the integer part first and are only turned
+// into floats once they are small.
+struct WorldPosition {
+  int64_t chunkX;
+  int64_t chunkZ;
+  // X and Z relative to the chunk origin, Y is the world height
+  glm::vec3 local;
+
+  WorldPosition() : chunkX(0), chunkZ(0), local(0.0f) {}
+  WorldPosition(int64_t chunkX, int64_t chunkZ, glm::vec3 local) : chunkX(chunkX), chunkZ(chunkZ), local(local) {
+    normalize();
+  }
+
+  // Converts world block coordinates
+  static WorldPosition fromBlock(int64_t x, int64_t y, int64_t z, glm::vec3 offset = glm::vec3(0.0f)) {
+    return WorldPosition(x >> SECTION_SHIFT, z >> SECTION_SHIFT,
+      glm::vec3((float)(x & SECTION_MASK), (float)y, (float)(z & SECTION_MASK)) + offset);
+  }
+
+  static WorldPosition fromDouble(double x, double y, double z) {
+    double chunkX = floor(x / SECTION_SIZE);
+    double chunkZ = floor(z / SECTION_SIZE);
+    return WorldPosition((int64_t)chunkX, (int64_t)chunkZ,
+      glm::vec3((float)(x - chunkX * SECTION_SIZE), (float)y, (float)(z - chunkZ * SECTION_SIZE)));
+  }
+
+  // Moves whole chunks out of the local offset
+  void normalize() {
+    float shiftX = floorf(local.x / SECTION_SIZE);
+    float shiftZ = floorf(local.z / SECTION_SIZE);
+    chunkX += (int64_t)shiftX;
+    chunkZ += (int64_t)shiftZ;
+    local.x -= shiftX * SECTION_SIZE;
+    local.z -= shiftZ * SECTION_SIZE;
+  }
+
+  // Integer block coordinates of the block containing the position
+  int64_t blockX() const { return chunkX * SECTION_SIZE + (int64_t)floorf(local.x); }
+  int64_t blockY() const { return (int64_t)floorf(local.y); }
+  int64_t blockZ() const { return chunkZ * SECTION_SIZE + (int64_t)floorf(local.z); }
+
+  ChunkPos chunk() const { return { (int)chunkX, (int)chunkZ }; }
+
+  // Offset from the origin of another chunk column, for positions near that chunk
+  glm::vec3 relativeTo(int64_t originX, int64_t originZ) const {
+    return glm::vec3((float)((chunkX - originX) * SECTION_SIZE) + local.x, local.y, (float)((chunkZ - originZ) * SECTION_SIZE) + local.z);
+  }
+
+  glm::dvec3 toDouble() const {
+    return glm::dvec3((double)chunkX * SECTION_SIZE + local.x, (double)local.y, (double)chunkZ * SECTION_SIZE + local.z);
+  }
+
+  WorldPosition operator+(glm::vec3 delta) const { return WorldPosition(chunkX, chunkZ, local + delta); }
+
+  // Difference of two nearby positions
+  glm::vec3 operator-(const WorldPosition& other) const { return relativeTo(other.chunkX, other.chunkZ) - other.local; }
+};
+
+#endif